@@ -1,3 +1,16 @@
+-- Options.
+
+newoption {
+   trigger     = "simd",
+   value       = "level",
+   description = "Instruction set used by the pixel kernels, beyond the x64 baseline",
+   allowed     = {
+      { "sse2",  "SSE2 (default)" },
+      { "ssse3", "SSSE3" },
+      { "avx2",  "AVX2" }
+   }
+}
+
 -- Workspace definition.
 
 workspace("GL_Template")
@@ -23,6 +36,12 @@ workspace("GL_Template")
 function CPPSetup()
 	language("C++")
 	buildoptions({ "-std=c++11","-Wall" })
+	-- The pixel kernels pick their code paths at compile time.
+	if _OPTIONS["simd"] == "avx2" then
+		buildoptions({ os.istarget("windows") and "/arch:AVX2" or "-mavx2" })
+	elseif _OPTIONS["simd"] == "ssse3" and not os.istarget("windows") then
+		buildoptions({ "-mssse3" })
+	end
 end	
 
 function GraphicsSetup()
@@ -88,6 +107,18 @@ project("SHExtractor")
 	ToolSetup()	
 	files({ "src/tools/SHExtractor.cpp" })
 
+project("AssetBaker")
+	ToolSetup()
+	files({ "src/tools/AssetBaker.cpp" })
+
+project("AssetPacker")
+	ToolSetup()
+	files({ "src/tools/AssetPacker.cpp" })
+
+project("ResourcesBenchmark")
+	ToolSetup()
+	files({ "src/tools/ResourcesBenchmark.cpp" })
+
 
 -- Actions
 
@@ -0,0 +1,45 @@
+#version 330
+
+// Attributes, packed: octahedral normal, octahedral tangent and binormal sign.
+layout(location = 0) in vec3 v;
+layout(location = 1) in vec2 octN;
+layout(location = 2) in vec2 uv;
+layout(location = 3) in vec4 octTangSign;
+
+// Uniform: the MVP, MV and normal matrices
+uniform mat4 mvp;
+uniform mat3 normalMatrix;
+
+// Output: tangent space matrix, position in view space and uv.
+out INTERFACE {
+    mat3 tbn;
+	vec2 uv;
+} Out ;
+
+// Decode an octahedral-encoded unit vector.
+vec3 decodeOctahedral(vec2 e){
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+
+void main(){
+	// We multiply the coordinates by the MVP matrix, and ouput the result.
+	gl_Position = mvp * vec4(v, 1.0);
+
+	Out.uv = uv;
+
+	// Rebuild the tangent frame in model space.
+	vec3 n = decodeOctahedral(octN);
+	vec3 tang = decodeOctahedral(octTangSign.xy);
+	vec3 binor = (octTangSign.w < 0.0 ? -1.0 : 1.0) * cross(n, tang);
+	
+	// Compute the TBN matrix (from tangent space to view space).
+	vec3 T = normalize(normalMatrix * tang);
+	vec3 B = normalize(normalMatrix * binor);
+	vec3 N = normalize(normalMatrix * n);
+	Out.tbn = mat3(T, B, N);
+	
+}
@@ -78,8 +78,10 @@ void main(){
 	}
 	
 	// Compute the normal at the fragment using the tangent space matrix and the normal read in the normal map.
-	vec3 n = texture(texture1,localUV).rgb;
-	n = normalize(n * 2.0 - 1.0);
+	// Only X and Y are read, Z is rebuilt so that normal maps can be compressed to two channels.
+	vec3 n;
+	n.xy = texture(texture1, localUV).rg * 2.0 - 1.0;
+	n.z = sqrt(max(0.0, 1.0 - dot(n.xy, n.xy)));
 	
 	// Store values.
 	fragColor.rgb = texture(texture0, localUV).rgb;
@@ -8,6 +8,8 @@
 #include "renderers/utils/RendererCube.hpp"
 #include "renderers/utils/TestRenderer.hpp"
 #include "helpers/Logger.hpp"
+#include "helpers/Profiler.hpp"
+#include "resources/ResourcesManager.hpp"
 
 #include "scenes/Scenes.hpp"
 
@@ -128,6 +130,21 @@ int main(int argc, char** argv) {
 	Log::Info() << Log::OpenGL << "Internal renderer: " << rendererString << "." << std::endl;
 	Log::Info() << Log::OpenGL << "Version supported: " << versionString << "." << std::endl;
 	
+	// Resources loading settings.
+	if(config.profileLoading){
+		// Before the resources are listed.
+		Profiler::setEnabled(true);
+	}
+	if(config.loadingThreads > 0){
+		Resources::manager().setLoadingThreads(config.loadingThreads);
+	}
+	Resources::manager().setPackedVertices(config.packedVertices);
+	Resources::manager().setMemoryBudget(size_t(config.memoryBudget) * 1024 * 1024);
+	Resources::manager().setUploadBuffer(size_t(config.uploadBuffer) * 1024 * 1024);
+	Resources::manager().setCPUMipmaps(config.cpuMipmaps, config.boxMipmaps ? ImageUtilities::BoxFilter : ImageUtilities::KaiserFilter);
+	Resources::manager().setTextureCompression(config.compressTextures);
+	Resources::manager().setHotReload(config.hotReload);
+	
 	// Create the scene and the renderer.
 	std::shared_ptr<Scene> scene(new DeskScene());
 	std::shared_ptr<Renderer> renderer(new DeferredRenderer(config, scene));
@@ -149,6 +166,8 @@ int main(int argc, char** argv) {
 		if(Input::manager().triggered(Input::KeyP)){
 			Resources::manager().reload();
 		}
+		// Only reload the resources modified on disk.
+		Resources::manager().reloadChanged();
 		// We separate punctual events from the main physics/movement update loop.
 		renderer->update();
 		
@@ -172,6 +191,15 @@ int main(int argc, char** argv) {
 			remainingTime -= deltaTime;
 		}
 
+		// Upload the resources loaded in the background, without spending more than a few milliseconds per frame.
+		const size_t pendingUploads = Resources::manager().pumpUploads(2.0);
+		// Report the scene loading once everything has been uploaded.
+		if(Profiler::enabled() && pendingUploads == 0){
+			Profiler::setEnabled(false);
+			Profiler::report();
+			Profiler::saveTrace(config.profileTracePath);
+		}
+		
 		// Update the content of the window.
 		renderer->draw();
 		
@@ -10,6 +10,7 @@
 
 class DeskScene : public Scene {
 public:
+	DeskScene() : Scene("desk_scene") {}
 	void init();
 	void update(double fullTime, double frameTime);
 };
@@ -43,7 +44,7 @@ void DeskScene::init(){
 	
 	// Background creation.
 	background = Object(Object::Type::Skybox, "skybox", {}, {{"small_apartment", true }});
-	backgroundReflection = Resources::manager().getCubemap("small_apartment").id;
+	backgroundReflection = Resources::manager().getCubemap("small_apartment");
 	loadSphericalHarmonics("small_apartment_shcoeffs");
 }
 
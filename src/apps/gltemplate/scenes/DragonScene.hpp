@@ -10,6 +10,7 @@
 
 class DragonScene : public Scene {
 public:
+	DragonScene() : Scene("dragon_scene") {}
 	void init();
 	void update(double fullTime, double frameTime);
 };
@@ -47,7 +48,7 @@ void DragonScene::init(){
 	// Background creation.
 	background = Object(Object::Type::Skybox, "skybox", {}, {{"corsica_beach_cube", true }});
 	
-	backgroundReflection = Resources::manager().getCubemap("corsica_beach_cube").id;
+	backgroundReflection = Resources::manager().getCubemap("corsica_beach_cube");
 	loadSphericalHarmonics("corsica_beach_cube_shcoeffs");
 }
 
@@ -10,6 +10,7 @@
 
 class SphereScene : public Scene {
 public:
+	SphereScene() : Scene("sphere_scene") {}
 	void init();
 	void update(double fullTime, double frameTime);
 };
@@ -36,7 +37,7 @@ void SphereScene::init(){
 	
 	// Background creation.
 	background = Object(Object::Type::Skybox, "skybox", {}, {{"studio", true }});
-	backgroundReflection = Resources::manager().getCubemap("studio").id;
+	backgroundReflection = Resources::manager().getCubemap("studio");
 	loadSphericalHarmonics("studio_shcoeffs");
 }
 
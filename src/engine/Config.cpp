@@ -54,7 +54,31 @@ void Config::processArguments(){
 			internalVerticalResolution = std::stof(value);
 		} else if(key == "log-path"){
 			logPath = value;
-		}else if(key == "wxh"){
+		} else if(key == "loading-threads"){
+			loadingThreads = std::stoi(value);
+		} else if(key == "packed-vertices"){
+			packedVertices = true;
+		} else if(key == "profile-loading"){
+			profileLoading = true;
+			// An optional path for the trace can be specified.
+			if(!value.empty() && value != "true"){
+				profileTracePath = value;
+			}
+		} else if(key == "hot-reload"){
+			hotReload = true;
+		} else if(key == "record-manifest"){
+			recordManifest = true;
+		} else if(key == "memory-budget"){
+			memoryBudget = std::stoi(value);
+		} else if(key == "upload-buffer"){
+			uploadBuffer = std::stoi(value);
+		} else if(key == "cpu-mipmaps"){
+			cpuMipmaps = true;
+			// The filter can be specified.
+			boxMipmaps = value == "box";
+		} else if(key == "compress-textures"){
+			compressTextures = true;
+		} else if(key == "wxh"){
 			const std::string::size_type split = value.find_first_of("x");
 			if(split != std::string::npos){
 				unsigned int w = std::stoi(value.substr(0,split));
@@ -35,6 +35,38 @@ public:
 	
 	float internalVerticalResolution = 720.0f;
 	
+	/// Number of threads used for resources loading (0: one per core).
+	unsigned int loadingThreads = 0;
+	
+	/// Use interleaved quantized vertices for meshes.
+	bool packedVertices = false;
+	
+	/// GPU memory budget for textures and meshes in MB, unused resources are released above it (0: no limit).
+	unsigned int memoryBudget = 0;
+	
+	/// Size in MB of the pixel buffer textures are streamed through (0: upload from client memory).
+	unsigned int uploadBuffer = 32;
+	
+	/// Generate the mipmaps of decoded textures on the loading threads instead of on the GPU.
+	bool cpuMipmaps = false;
+	
+	/// Use a box filter for them instead of the sharper Kaiser filter.
+	bool boxMipmaps = false;
+	
+	/// Compress the textures to GPU block formats on the loading threads, caching the results.
+	bool compressTextures = false;
+	
+	/// Reload the resources modified on disk while running.
+	bool hotReload = false;
+	
+	/// Profile the scene loading, and save a Chrome trace of it.
+	bool profileLoading = false;
+	
+	std::string profileTracePath = "loading_trace.json";
+	
+	/// Save the resources requested by the scene as its manifest, instead of prefetching them.
+	bool recordManifest = false;
+	
 	/// Computed properties.
 	glm::vec2 screenResolution = glm::vec2(800.0,600.0);
 	
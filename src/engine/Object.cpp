@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #include <vector>
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 
 
@@ -14,36 +15,32 @@ Object::Object(const Object::Type & type, const std::string& meshPath, const std
 	_material = static_cast<int>(type);
 	_castShadow = castShadows;
 	
-	// Load the shaders
+	// Load geometry.
+	_mesh = Resources::manager().getMeshAsync(meshPath);
+	
+	// Load the shaders, packed meshes need to decode their attributes.
+	// The mesh is not loaded yet, so prepare both versions if needed.
 	_programDepth = Resources::manager().getProgram("object_depth");
+	const bool packed = Resources::manager().packedVertices();
 
 	switch (_material) {
 	case Object::Skybox:
 		_program = Resources::manager().getProgram("skybox_gbuffer");
+		_programPacked = _program;
 		break;
 	case Object::Parallax:
 		_program = Resources::manager().getProgram("parallax_gbuffer");
+		_programPacked = packed ? Resources::manager().getProgram("parallax_gbuffer_packed", "parallax_gbuffer_packed", "parallax_gbuffer") : _program;
 		break;
 	case Object::Regular:
 	default:
 		_program = Resources::manager().getProgram("object_gbuffer");
+		_programPacked = packed ? Resources::manager().getProgram("object_gbuffer_packed", "object_gbuffer_packed", "object_gbuffer") : _program;
 		break;
 	}
 
-	// Load geometry.
-	_mesh = Resources::manager().getMesh(meshPath);
-
 	// Load and upload the textures.
-	for (unsigned int i = 0; i < texturesPaths.size(); ++i) {
-		const auto & textureName = texturesPaths[i];
-		_textures.push_back(Resources::manager().getTexture(textureName.first, textureName.second));
-		_program->registerTexture("texture" + std::to_string(i), i);
-	}
-	for (unsigned int i = 0; i < cubemapPaths.size(); ++i) {
-		const auto & textureName = cubemapPaths[i];
-		_textures.push_back(Resources::manager().getCubemap(textureName.first, textureName.second));
-		_program->registerTexture("texture" + std::to_string( texturesPaths.size() + i), (int)texturesPaths.size() + i);
-	}
+	loadTextures(texturesPaths, cubemapPaths);
 	
 	_model = glm::mat4(1.0f);
 	checkGLError();
@@ -58,26 +55,33 @@ Object::Object(std::shared_ptr<ProgramInfos> & program, const std::string& meshP
 	// Load the shaders
 	_programDepth = nullptr;
 	_program = program;
+	_programPacked = program;
 	
 	// Load geometry.
-	_mesh = Resources::manager().getMesh(meshPath);
+	_mesh = Resources::manager().getMeshAsync(meshPath);
 	
 	// Load and upload the textures.
-	for (unsigned int i = 0; i < texturesPaths.size(); ++i) {
-		const auto & textureName = texturesPaths[i];
-		_textures.push_back(Resources::manager().getTexture(textureName.first, textureName.second));
-		_program->registerTexture("texture" + std::to_string(i), i);
-	}
-	for (unsigned int i = 0; i < cubemapPaths.size(); ++i) {
-		const auto & textureName = cubemapPaths[i];
-		_textures.push_back(Resources::manager().getCubemap(textureName.first, textureName.second));
-		_program->registerTexture("texture" + std::to_string( texturesPaths.size() + i), (int)texturesPaths.size() + i);
-	}
+	loadTextures(texturesPaths, cubemapPaths);
 	_model = glm::mat4(1.0f);
 	checkGLError();
 	
 }
 
+void Object::loadTextures(const std::vector<std::pair<std::string, bool>>& texturesPaths, const std::vector<std::pair<std::string, bool>>& cubemapPaths){
+	for (const auto & textureName : texturesPaths) {
+		_textures.push_back(Resources::manager().getTextureAsync(textureName.first, textureName.second));
+	}
+	for (const auto & textureName : cubemapPaths) {
+		_textures.push_back(Resources::manager().getCubemapAsync(textureName.first, textureName.second));
+	}
+	for (unsigned int i = 0; i < _textures.size(); ++i) {
+		_program->registerTexture("texture" + std::to_string(i), i);
+		if(_programPacked != _program){
+			_programPacked->registerTexture("texture" + std::to_string(i), i);
+		}
+	}
+}
+
 void Object::update(const glm::mat4& model) {
 
 	_model = model;
@@ -85,7 +89,13 @@ void Object::update(const glm::mat4& model) {
 }
 
 
-void Object::draw(const glm::mat4& view, const glm::mat4& projection) const {
+void Object::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewport) const {
+	// Nothing to draw until the geometry is uploaded.
+	if(!_mesh || !_mesh->ready){
+		return;
+	}
+	const MeshInfos & mesh = _mesh->infos;
+	const std::shared_ptr<ProgramInfos> & program = mesh.packed ? _programPacked : _program;
 
 	// Combine the three matrices.
 	glm::mat4 MV = view * _model;
@@ -94,23 +104,23 @@ void Object::draw(const glm::mat4& view, const glm::mat4& projection) const {
 	// Compute the normal matrix
 	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(MV)));
 	// Select the program (and shaders).
-	glUseProgram(_program->id());
+	glUseProgram(program->id());
 
 	// Upload the MVP matrix.
-	glUniformMatrix4fv(_program->uniform("mvp"), 1, GL_FALSE, &MVP[0][0]);
+	glUniformMatrix4fv(program->uniform("mvp"), 1, GL_FALSE, &MVP[0][0]);
 
 	switch (_material) {
 		case Object::Parallax:
 			// Upload the projection matrix.
-			glUniformMatrix4fv(_program->uniform("p"), 1, GL_FALSE, &projection[0][0]);
+			glUniformMatrix4fv(program->uniform("p"), 1, GL_FALSE, &projection[0][0]);
 			// Upload the MV matrix.
-			glUniformMatrix4fv(_program->uniform("mv"), 1, GL_FALSE, &MV[0][0]);
+			glUniformMatrix4fv(program->uniform("mv"), 1, GL_FALSE, &MV[0][0]);
 			// Upload the normal matrix.
-			glUniformMatrix3fv(_program->uniform("normalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
+			glUniformMatrix3fv(program->uniform("normalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
 			break;
 		case Object::Regular:
 			// Upload the normal matrix.
-			glUniformMatrix3fv(_program->uniform("normalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
+			glUniformMatrix3fv(program->uniform("normalMatrix"), 1, GL_FALSE, &normalMatrix[0][0]);
 			break;
 		default:
 			break;
@@ -120,15 +130,17 @@ void Object::draw(const glm::mat4& view, const glm::mat4& projection) const {
 	// Bind the textures.
 	for (unsigned int i = 0; i < _textures.size(); ++i){
 		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(_textures[i].cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, _textures[i].id);
+		const TextureInfos & texture = _textures[i]->infos;
+		glBindTexture(texture.cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, texture.id);
 	}
 	
 	
-	// Select the geometry.
-	glBindVertexArray(_mesh.vId);
+	// Select the geometry and its level of detail.
+	const MeshLevel level = selectLevel(MVP, viewport);
+	glBindVertexArray(mesh.vId);
 	// Draw!
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _mesh.eId);
-	glDrawElements(GL_TRIANGLES, _mesh.count, GL_UNSIGNED_INT, (void*)0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.eId);
+	glDrawElements(GL_TRIANGLES, level.count, mesh.indexType, (void*)level.offset);
 
 	glBindVertexArray(0);
 	glUseProgram(0);
@@ -137,10 +149,11 @@ void Object::draw(const glm::mat4& view, const glm::mat4& projection) const {
 }
 
 
-void Object::drawDepth(const glm::mat4& lightVP) const {
-	if(!_castShadow){
+void Object::drawDepth(const glm::mat4& lightVP, const glm::vec2& viewport) const {
+	if(!_castShadow || !_mesh || !_mesh->ready){
 		return;
 	}
+	const MeshInfos & mesh = _mesh->infos;
 	// Combine the three matrices.
 	glm::mat4 lightMVP = lightVP * _model;
 	
@@ -149,11 +162,12 @@ void Object::drawDepth(const glm::mat4& lightVP) const {
 	// Upload the MVP matrix.
 	glUniformMatrix4fv(_programDepth->uniform("mvp"), 1, GL_FALSE, &lightMVP[0][0]);
 	
-	// Select the geometry.
-	glBindVertexArray(_mesh.vId);
+	// Select the geometry and its level of detail.
+	const MeshLevel level = selectLevel(lightMVP, viewport);
+	glBindVertexArray(mesh.vId);
 	// Draw!
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _mesh.eId);
-	glDrawElements(GL_TRIANGLES, _mesh.count, GL_UNSIGNED_INT, (void*)0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.eId);
+	glDrawElements(GL_TRIANGLES, level.count, mesh.indexType, (void*)level.offset);
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
@@ -161,12 +175,38 @@ void Object::drawDepth(const glm::mat4& lightVP) const {
 }
 
 
-void Object::clean() const {
-	glDeleteVertexArrays(1, &_mesh.vId);
-	for (auto & texture : _textures) {
-		glDeleteTextures(1, &(texture.id));
+MeshLevel Object::selectLevel(const glm::mat4& mvp, const glm::vec2& viewport) const {
+	const MeshInfos & mesh = _mesh->infos;
+	if(mesh.levels.empty()){
+		MeshLevel level;
+		level.count = mesh.count;
+		return level;
+	}
+	if(mesh.levels.size() == 1 || viewport.x <= 0.0f || viewport.y <= 0.0f){
+		return mesh.levels[0];
+	}
+	// Depth of the closest point of the bounding sphere (1 for orthographic projections).
+	const glm::vec3 depthAxis(mvp[0][3], mvp[1][3], mvp[2][3]);
+	const float depth = (mvp * glm::vec4(mesh.center, 1.0f)).w - mesh.radius * glm::length(depthAxis);
+	if(depth <= 0.0f){
+		return mesh.levels[0];
 	}
-	glDeleteProgram(_program->id());
+	// Upper bound of the number of pixels covered by a model space unit at this depth.
+	const float pixelsX = 0.5f * viewport.x * glm::length(glm::vec3(mvp[0][0], mvp[1][0], mvp[2][0]));
+	const float pixelsY = 0.5f * viewport.y * glm::length(glm::vec3(mvp[0][1], mvp[1][1], mvp[2][1]));
+	const float pixelsPerUnit = std::max(pixelsX, pixelsY) / depth;
+	
+	size_t lid = 0;
+	while(lid + 1 < mesh.levels.size() && mesh.levels[lid + 1].error * pixelsPerUnit <= 1.0f){
+		++lid;
+	}
+	return mesh.levels[lid];
+}
+
+void Object::clean() {
+	// Meshes, textures and programs are shared and reference counted, the resources manager releases them.
+	_mesh.reset();
+	_textures.clear();
 }
 
 
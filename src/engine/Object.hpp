@@ -27,23 +27,31 @@ public:
 	/// Update function
 	void update(const glm::mat4& model);
 	
-	/// Draw function
-	void draw(const glm::mat4& view, const glm::mat4& projection) const;
+	/// Draw function, the viewport size in pixels is used to select the level of detail (full resolution if null).
+	void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewport = glm::vec2(0.0f)) const;
 	
-	/// Draw depth function
-	void drawDepth(const glm::mat4& lightVP) const;
+	/// Draw depth function, the viewport size in pixels is used to select the level of detail (full resolution if null).
+	void drawDepth(const glm::mat4& lightVP, const glm::vec2& viewport = glm::vec2(0.0f)) const;
 	
-	/// Clean function
-	void clean() const;
+	/// Release the mesh and textures handles, so that the resources manager can free them.
+	void clean();
 
 
 private:
 	
+	/// Select the coarsest level of detail whose error projects to less than a pixel.
+	MeshLevel selectLevel(const glm::mat4& mvp, const glm::vec2& viewport) const;
+	
+	/// Register the textures samplers and request their loading.
+	void loadTextures(const std::vector<std::pair<std::string, bool>>& texturesPaths, const std::vector<std::pair<std::string, bool>>& cubemapPaths);
+	
 	std::shared_ptr<ProgramInfos> _program;
+	std::shared_ptr<ProgramInfos> _programPacked; ///< Used instead of the main program if the mesh is uploaded with packed vertices.
 	std::shared_ptr<ProgramInfos> _programDepth;
-	MeshInfos _mesh;
 	
-	std::vector<TextureInfos> _textures;
+	/// Loaded in the background: the object is not drawn until the mesh is ready, placeholder textures are used until they are.
+	std::shared_ptr<AsyncMesh> _mesh;
+	std::vector<std::shared_ptr<AsyncTexture>> _textures;
 	
 	glm::mat4 _model;
 	
@@ -2,8 +2,28 @@
 
 Scene::Scene(){};
 
+Scene::Scene(const std::string & name) : name(name) {};
+
 Scene::~Scene(){};
 
+void Scene::load(const bool recordManifest){
+	AssetManifest manifest;
+	if(name.empty()){
+		init();
+	} else if(recordManifest){
+		Resources::manager().recordManifest(&manifest);
+		init();
+		Resources::manager().recordManifest(NULL);
+		Resources::manager().saveManifest(name, manifest);
+	} else {
+		// Start reading all the files before the scene requests them one by one.
+		if(Resources::manager().loadManifest(name, manifest)){
+			Resources::manager().prefetch(manifest);
+		}
+		init();
+	}
+}
+
 void Scene::loadSphericalHarmonics(const std::string & name){
 	backgroundIrradiance.clear();
 	backgroundIrradiance.resize(9);
@@ -22,12 +42,15 @@ void Scene::loadSphericalHarmonics(const std::string & name){
 	
 }
 
-void Scene::clean() const {
+void Scene::clean() {
 	for(auto & object : objects){
 		object.clean();
 	}
 	background.clean();
+	backgroundReflection.reset();
 	for(auto& dirLight : directionalLights){
 		dirLight.clean();
 	}
+	// Free the meshes and textures that no other scene or renderer holds.
+	Resources::manager().collect(true);
 };
@@ -18,20 +18,28 @@ public:
 
 	Scene();
 	
+	/// A named scene has its resources listed in the manifest 'name.manifest'.
+	Scene(const std::string & name);
+	
 	/// Init function
 	virtual void init() = 0;
 	
+	/// Prefetch the resources listed in the scene manifest if there is one, then init the scene.
+	/// If 'recordManifest' is set, the resources requested by init are saved as the scene manifest instead.
+	void load(const bool recordManifest);
+	
 	virtual void update(double fullTime, double frameTime) = 0;
 	
 	void loadSphericalHarmonics(const std::string & name);
 	
-	/// Clean function
-	void clean() const;
+	/// Release the resources of the scene, the ones that aren't used elsewhere are freed.
+	void clean();
 	
+	std::string name;
 	std::vector<Object> objects;
 	Object background;
 	std::vector<glm::vec3> backgroundIrradiance;
-	GLuint backgroundReflection;
+	std::shared_ptr<AsyncTexture> backgroundReflection;
 	std::vector<DirectionalLight> directionalLights;
 	std::vector<PointLight> pointLights;
 	
@@ -3,6 +3,8 @@
 #include "Logger.hpp"
 #include <vector>
 #include <algorithm>
+#include <cstddef>
+#include <thread>
 
 
 std::string getGLErrorString(GLenum error) {
@@ -138,78 +140,193 @@ GLuint GLUtilities::createProgram(const std::string & vertexContent, const std::
 
 
 
+/// GPU memory used by a texture with the given number of levels, in the format of the image.
+static size_t textureBytes(const ImageView & image, const unsigned int levels, const bool cubemap){
+	// RGB16F, RGB32F, RGBA8 or compressed blocks.
+	size_t bytes = 0;
+	for(unsigned int level = 0; level < levels; ++level){
+		bytes += image.levelSize(level);
+	}
+	return cubemap ? 6 * bytes : bytes;
+}
+
+/// Immutable texture storage, allocating all levels at once (GL 4.2).
+static bool supportsTextureStorage(){
+	static const bool supported = glTexStorage2D != NULL && GLUtilities::isSupported("GL_ARB_texture_storage", 4, 2);
+	return supported;
+}
+
+// S3TC formats are only exposed by an extension, absent from the core profile header.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+/// Internal format of block compressed images.
+static GLenum compressedFormat(const BlockCompression::Format format, const bool sRGB){
+	switch(format){
+		case BlockCompression::BC1:
+			return sRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BlockCompression::BC3:
+			return sRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BlockCompression::BC4:
+			return GL_COMPRESSED_RED_RGTC1;
+		case BlockCompression::BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+		case BlockCompression::BC6H:
+			return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+		case BlockCompression::BC7:
+			return sRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		default:
+			return GL_NONE;
+	}
+}
+
+/// Set the unpack alignment for an image and return its upload type. Half-float RGB rows are only 2-byte aligned.
+static GLenum prepareUpload(const ImageView & image){
+	if(!image.hdr){
+		return GL_UNSIGNED_BYTE;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, image.half ? 2 : 4);
+	return image.half ? GL_HALF_FLOAT : GL_FLOAT;
+}
+
+/// Upload a level, either compressed or not, to the storage allocated by glTexStorage2D if immutable.
+static void uploadLevel(const GLenum target, const GLint mipid, const GLenum preciseFormat, const GLenum format, const bool immutable, const ImageView & image, const unsigned int level){
+	const GLsizei width = (std::max)(1u, image.width >> level);
+	const GLsizei height = (std::max)(1u, image.height >> level);
+	if(image.compression != BlockCompression::None){
+		const GLsizei size = (GLsizei)image.levelSize(level);
+		if(immutable){
+			glCompressedTexSubImage2D(target, mipid, 0, 0, width, height, preciseFormat, size, image.levels[level]);
+		} else {
+			glCompressedTexImage2D(target, mipid, preciseFormat, width, height, 0, size, image.levels[level]);
+		}
+		return;
+	}
+	if(immutable){
+		glTexSubImage2D(target, mipid, 0, 0, width, height, format, prepareUpload(image), image.levels[level]);
+	} else {
+		glTexImage2D(target, mipid, preciseFormat, width, height, 0, format, prepareUpload(image), image.levels[level]);
+	}
+}
+
 TextureInfos GLUtilities::loadTexture(const std::vector<std::string>& paths, bool sRGB){
 	TextureInfos infos;
 	infos.cubemap = false;
 	if(paths.empty()){
 		return infos;
 	}
+	// Decode all levels concurrently, only the upload is serialized.
+	std::vector<ImageView> images;
+	std::vector<void *> buffers;
+	if(ImageUtilities::loadImages(paths, true, std::thread::hardware_concurrency(), images, buffers)){
+		infos = GLUtilities::loadTexture(images, sRGB);
+	}
+	for(void * buffer : buffers){
+		free(buffer);
+	}
+	return infos;
+}
+
+TextureInfos GLUtilities::loadTextureCubemap(const std::vector<std::vector<std::string>> & allPaths, bool sRGB){
+	TextureInfos infos;
+	infos.cubemap = true;
+	// If not enough images, return empty texture.
+	if(allPaths.empty() || allPaths.front().size() != 6){
+		Log::Error() << Log::Resources << "Unable to find cubemap." << std::endl;
+		return infos;
+	}
+	
+	// Decode all faces of all levels concurrently, only the uploads are serialized.
+	// We don't need to flip them.
+	std::vector<std::string> paths;
+	for(const auto & levelPaths : allPaths){
+		paths.insert(paths.end(), levelPaths.begin(), levelPaths.end());
+	}
+	std::vector<ImageView> images;
+	std::vector<void *> buffers;
+	if(ImageUtilities::loadImages(paths, false, std::thread::hardware_concurrency(), images, buffers)){
+		std::vector<std::vector<ImageView>> faces;
+		for(size_t lid = 0; lid < allPaths.size(); ++lid){
+			faces.emplace_back(images.begin() + 6 * lid, images.begin() + 6 * (lid + 1));
+		}
+		infos = GLUtilities::loadTextureCubemap(faces, sRGB);
+	}
+	for(void * buffer : buffers){
+		free(buffer);
+	}
+	return infos;
+}
+
+TextureInfos GLUtilities::loadTexture(const std::vector<ImageView> & images, bool sRGB){
+	TextureInfos infos;
+	infos.cubemap = false;
+	if(images.empty() || images[0].levels.empty()){
+		return infos;
+	}
 	
 	// Create 2D texture.
 	GLuint textureId;
 	glGenTextures(1, &textureId);
 	glBindTexture(GL_TEXTURE_2D, textureId);
 	
-	// Set proper max mipmap level.
-	if(paths.size()>1){
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)(paths.size())-1);
-	} else {
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
-	}
-	// Texture settings.
+	// Either a single image with its own mip chain, or one image per level.
+	const bool singleImage = images.size() == 1;
+	const unsigned int levels = singleImage ? (unsigned int)images[0].levels.size() : (unsigned int)images.size();
+	// A lone base level gets its pyramid generated, unless compressed.
+	const bool compressed = images[0].compression != BlockCompression::None;
+	const bool generateMipmaps = levels == 1 && !compressed;
+	const unsigned int allocatedLevels = generateMipmaps ? TextureCache::levelsCount(images[0].width, images[0].height) : levels;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)allocatedLevels - 1);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
 	
-	// Image infos.
-	infos.hdr = ImageUtilities::isHDR(paths[0]);
-	unsigned int width = 0;
-	unsigned int height = 0;
-	unsigned int channels = 4;
-	
-	// For now, we assume HDR images to be 3-channels, LDR images to be 4.
+	// HDR images keep the precision of their base level, other levels are converted if needed.
+	infos.hdr = images[0].hdr;
+	const bool half = infos.hdr && images[0].half;
 	const GLenum format = infos.hdr ? GL_RGB : GL_RGBA;
-	const GLenum type = infos.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
-	const GLenum preciseFormat = (infos.hdr ? GL_RGB32F : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA));
-	
-	for(unsigned int mipid = 0; mipid < paths.size(); ++mipid){
-		
-		const std::string path = paths[mipid];
-		
-		void* image;
-		int ret = ImageUtilities::loadImage(path, width, height, channels, &image, !infos.hdr);
-		
-		if (ret != 0) {
-			Log::Error() << Log::Resources << "Unable to load the texture at path " << path << "." << std::endl;
-			free(image);
-			return infos;
-		}
-		
-		glTexImage2D(GL_TEXTURE_2D, mipid, preciseFormat, width, height, 0, format, type, image);
-		free(image);
-		
+	const GLenum preciseFormat = compressed ? compressedFormat(images[0].compression, sRGB) : (infos.hdr ? (half ? GL_RGB16F : GL_RGB32F) : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8));
+	if(images[0].compression == BlockCompression::BC4){
+		// Single channel images are grey.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
 	}
 	
-	// If only level 0 was given, generate mipmaps pyramid automatically.
-	if(paths.size() == 1){
+	// Allocate all levels at once, the driver then doesn't have to check the texture completeness.
+	const bool immutable = supportsTextureStorage();
+	if(immutable){
+		glTexStorage2D(GL_TEXTURE_2D, allocatedLevels, preciseFormat, images[0].width, images[0].height);
+	}
+	for(unsigned int mipid = 0; mipid < levels; ++mipid){
+		const ImageView & image = singleImage ? images[0] : images[mipid];
+		const unsigned int level = singleImage ? mipid : 0;
+		uploadLevel(GL_TEXTURE_2D, mipid, preciseFormat, format, immutable, image, level);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	if(generateMipmaps){
 		glGenerateMipmap(GL_TEXTURE_2D);
 	}
 	
 	infos.id = textureId;
-	infos.width = width;
-	infos.height = height;
+	infos.width = images[0].width;
+	infos.height = images[0].height;
+	infos.bytes = textureBytes(images[0], allocatedLevels, false);
 	return infos;
 }
 
-TextureInfos GLUtilities::loadTextureCubemap(const std::vector<std::vector<std::string>> & allPaths, bool sRGB){
+TextureInfos GLUtilities::loadTextureCubemap(const std::vector<std::vector<ImageView>> & images, bool sRGB){
 	TextureInfos infos;
 	infos.cubemap = true;
-	if(allPaths.empty() ){
-		Log::Error() << Log::Resources << "Unable to find cubemap." << std::endl;
-		return infos;
-	}
-	
-	// If not enough images, return empty texture.
-	if(allPaths.front().size() == 0 ){
+	if(images.empty() || images[0].size() != 6 || images[0][0].levels.empty()){
 		Log::Error() << Log::Resources << "Unable to find cubemap." << std::endl;
 		return infos;
 	}
@@ -219,65 +336,75 @@ TextureInfos GLUtilities::loadTextureCubemap(const std::vector<std::vector<std::
 	glGenTextures(1, &textureId);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureId);
 	
-	// Set proper max mipmap level.
-	if(allPaths.size()>1){
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (int)(allPaths.size())-1);
-	} else {
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 1000);
-	}
-	// Texture settings.
+	// Either a single set of faces with their own mip chains, or one set per level.
+	const bool singleImage = images.size() == 1;
+	const unsigned int levels = singleImage ? (unsigned int)images[0][0].levels.size() : (unsigned int)images.size();
+	// Lone base levels get their pyramid generated, unless compressed.
+	const bool compressed = images[0][0].compression != BlockCompression::None;
+	const bool generateMipmaps = levels == 1 && !compressed;
+	const unsigned int allocatedLevels = generateMipmaps ? TextureCache::levelsCount(images[0][0].width, images[0][0].height) : levels;
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (int)allocatedLevels - 1);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR );
 	glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP,GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 	
-	// Image infos.
-	unsigned int width = 0;
-	unsigned int height = 0;
-	unsigned int channels = 4;
-	infos.hdr = ImageUtilities::isHDR(allPaths[0][0]);
-	
-	// For now, we assume HDR images to be 3-channels, LDR images to be 4.
+	// HDR images keep the precision of their base level, other levels are converted if needed.
+	infos.hdr = images[0][0].hdr;
+	const bool half = infos.hdr && images[0][0].half;
 	const GLenum format = infos.hdr ? GL_RGB : GL_RGBA;
-	const GLenum type = infos.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
-	const GLenum preciseFormat = (infos.hdr ? GL_RGB32F : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA));
-	
-	for(unsigned int mipid = 0; mipid < allPaths.size(); ++mipid){
-		
-		const std::vector<std::string> paths = allPaths[mipid];
-		// For each side, load the image and upload it in the right slot.
-		// We don't need to flip them.
-		
+	const GLenum preciseFormat = compressed ? compressedFormat(images[0][0].compression, sRGB) : (infos.hdr ? (half ? GL_RGB16F : GL_RGB32F) : (sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8));
+	
+	const bool immutable = supportsTextureStorage();
+	if(immutable){
+		glTexStorage2D(GL_TEXTURE_CUBE_MAP, allocatedLevels, preciseFormat, images[0][0].width, images[0][0].height);
+	}
+	for(unsigned int mipid = 0; mipid < levels; ++mipid){
+		const std::vector<ImageView> & faces = singleImage ? images[0] : images[mipid];
+		const unsigned int level = singleImage ? mipid : 0;
 		for(size_t side = 0; side < 6; ++side){
-			void* image;
-			int ret = ImageUtilities::loadImage(paths[side], width, height, channels, &image, false);
-			if (ret != 0) {
-				Log::Error() << Log::Resources << "Unable to load the texture at path " << paths[side] << "." << std::endl;
-				free(image);
-				return infos;
-			}
-			
-			glTexImage2D(GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + side), mipid, preciseFormat, width, height, 0, format, type, image);
-			free(image);
+			const GLenum target = GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + side);
+			uploadLevel(target, mipid, preciseFormat, format, immutable, faces[side], level);
 		}
-		
 	}
-	
-	// If only level 0 was given, generate mipmaps pyramid automatically.
-	if(allPaths.size() == 1){
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	if(generateMipmaps){
 		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 	}
 	
 	infos.id = textureId;
-	infos.width = width;
-	infos.height = height;
+	infos.width = images[0][0].width;
+	infos.height = images[0][0].height;
+	infos.bytes = textureBytes(images[0][0], allocatedLevels, true);
 	return infos;
 }
 
 
-MeshInfos GLUtilities::setupBuffers(const Mesh & mesh){
+MeshInfos GLUtilities::setupBuffers(const Mesh & mesh, const bool packed){
+	return GLUtilities::setupBuffers(MeshView(mesh), packed);
+}
+
+void GLUtilities::deleteMesh(MeshInfos & infos){
+	glDeleteVertexArrays(1, &infos.vId);
+	if(!infos.buffers.empty()){
+		glDeleteBuffers((GLsizei)infos.buffers.size(), &infos.buffers[0]);
+	}
+	glDeleteBuffers(1, &infos.eId);
+	infos = MeshInfos();
+}
+
+void GLUtilities::deleteTexture(TextureInfos & infos){
+	glDeleteTextures(1, &infos.id);
+	infos = TextureInfos();
+}
+
+MeshInfos GLUtilities::setupBuffers(const MeshView & mesh, const bool packed){
 	MeshInfos infos;
+	// Meshes with only positions wouldn't benefit from packing.
+	if(packed && mesh.normals.size > 0){
+		return setupPackedBuffers(mesh);
+	}
 	GLuint vbo = 0;
 	GLuint vbo_nor = 0;
 	GLuint vbo_uv = 0;
@@ -285,34 +412,44 @@ MeshInfos GLUtilities::setupBuffers(const Mesh & mesh){
 	GLuint vbo_binor = 0;
 	
 	// Create an array buffer to host the geometry data.
-	if(mesh.positions.size() > 0){
+	if(mesh.positions.size > 0){
 		glGenBuffers(1, &vbo);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.positions.size() * 3, &(mesh.positions[0]), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.positions.size * 3, mesh.positions.data, GL_STATIC_DRAW);
+		infos.buffers.push_back(vbo);
+		infos.bytes += sizeof(GLfloat) * mesh.positions.size * 3;
 	}
 	
-	if(mesh.normals.size() > 0){
+	if(mesh.normals.size > 0){
 		glGenBuffers(1, &vbo_nor);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_nor);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.normals.size() * 3, &(mesh.normals[0]), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.normals.size * 3, mesh.normals.data, GL_STATIC_DRAW);
+		infos.buffers.push_back(vbo_nor);
+		infos.bytes += sizeof(GLfloat) * mesh.normals.size * 3;
 	}
 	
-	if(mesh.texcoords.size() > 0){
+	if(mesh.texcoords.size > 0){
 		glGenBuffers(1, &vbo_uv);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_uv);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.texcoords.size() * 2, &(mesh.texcoords[0]), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.texcoords.size * 2, mesh.texcoords.data, GL_STATIC_DRAW);
+		infos.buffers.push_back(vbo_uv);
+		infos.bytes += sizeof(GLfloat) * mesh.texcoords.size * 2;
 	}
 	
-	if(mesh.tangents.size() > 0){
+	if(mesh.tangents.size > 0){
 		glGenBuffers(1, &vbo_tan);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_tan);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.tangents.size() * 3, &(mesh.tangents[0]), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.tangents.size * 3, mesh.tangents.data, GL_STATIC_DRAW);
+		infos.buffers.push_back(vbo_tan);
+		infos.bytes += sizeof(GLfloat) * mesh.tangents.size * 3;
 	}
 	
-	if(mesh.binormals.size() > 0){
+	if(mesh.binormals.size > 0){
 		glGenBuffers(1, &vbo_binor);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo_binor);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.binormals.size() * 3, &(mesh.binormals[0]), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * mesh.binormals.size * 3, mesh.binormals.data, GL_STATIC_DRAW);
+		infos.buffers.push_back(vbo_binor);
+		infos.bytes += sizeof(GLfloat) * mesh.binormals.size * 3;
 	}
 	
 	// Generate a vertex array.
@@ -354,16 +491,110 @@ MeshInfos GLUtilities::setupBuffers(const Mesh & mesh){
 	}
 	
 	// We load the indices data
+	setupIndices(mesh, infos);
+	
+	glBindVertexArray(0);
+	
+	infos.vId = vao;
+	return infos;
+}
+
+void GLUtilities::setupIndices(const MeshView & mesh, MeshInfos & infos){
+	// All levels of detail share the same element buffer, after the full resolution indices.
+	const size_t indicesCount = mesh.indices.size + mesh.lodIndices.size;
+	// Narrowed indices are prepared on the loading threads, else compute them now.
+	DataView<uint16_t> shortIndices = mesh.shortIndices;
+	std::vector<uint16_t> narrowed;
+	if(!mesh.prepared){
+		unsigned int maxIndex = 0;
+		for(size_t iid = 0; iid < mesh.indices.size; ++iid){
+			maxIndex = (std::max)(maxIndex, mesh.indices.data[iid]);
+		}
+		if(maxIndex <= 0xFFFF){
+			narrowed.assign(mesh.indices.data, mesh.indices.data + mesh.indices.size);
+			narrowed.insert(narrowed.end(), mesh.lodIndices.data, mesh.lodIndices.data + mesh.lodIndices.size);
+		}
+		shortIndices = DataView<uint16_t>(narrowed);
+	}
 	GLuint ebo = 0;
 	glGenBuffers(1, &ebo);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.indices.size(), &(mesh.indices[0]), GL_STATIC_DRAW);
+	if(shortIndices.size == indicesCount){
+		// Halve the index buffer size.
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * shortIndices.size, shortIndices.data, GL_STATIC_DRAW);
+		infos.indexType = GL_UNSIGNED_SHORT;
+		infos.bytes += sizeof(GLushort) * shortIndices.size;
+	} else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indicesCount, NULL, GL_STATIC_DRAW);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint) * mesh.indices.size, mesh.indices.data);
+		if(mesh.lodIndices.size > 0){
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * mesh.indices.size, sizeof(GLuint) * mesh.lodIndices.size, mesh.lodIndices.data);
+		}
+		infos.indexType = GL_UNSIGNED_INT;
+		infos.bytes += sizeof(GLuint) * indicesCount;
+	}
+	infos.eId = ebo;
+	infos.count = (GLsizei)mesh.indices.size;
+	
+	const size_t indexSize = infos.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	infos.levels.resize(mesh.lods.size + 1);
+	infos.levels[0].count = infos.count;
+	size_t offset = mesh.indices.size;
+	for(size_t lid = 0; lid < mesh.lods.size; ++lid){
+		MeshLevel & level = infos.levels[lid + 1];
+		level.count = (GLsizei)mesh.lods.data[lid].count;
+		level.offset = offset * indexSize;
+		level.error = mesh.lods.data[lid].error;
+		offset += mesh.lods.data[lid].count;
+	}
+	if(mesh.prepared){
+		infos.center = mesh.center;
+		infos.radius = mesh.radius;
+	} else {
+		MeshUtilities::computeBoundingSphere(mesh.positions, infos.center, infos.radius);
+	}
+}
+
+MeshInfos GLUtilities::setupPackedBuffers(const MeshView & mesh){
+	MeshInfos infos;
+	// Vertices are packed on the loading threads, else pack them now.
+	DataView<PackedVertex> vertices = mesh.packedVertices;
+	std::vector<PackedVertex> packed;
+	if(vertices.size == 0){
+		MeshUtilities::packVertices(mesh, packed);
+		vertices = DataView<PackedVertex>(packed);
+	}
+	
+	// Single interleaved array buffer.
+	GLuint vbo = 0;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex) * vertices.size, vertices.data, GL_STATIC_DRAW);
+	infos.buffers.push_back(vbo);
+	infos.bytes += sizeof(PackedVertex) * vertices.size;
+	
+	GLuint vao = 0;
+	glGenVertexArrays (1, &vao);
+	glBindVertexArray(vao);
+	
+	// Position, octahedral normal, half uv, octahedral tangent and binormal sign.
+	const GLsizei stride = sizeof(PackedVertex);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texcoord));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 4, GL_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, tangent));
+	
+	// We load the indices data
+	setupIndices(mesh, infos);
 	
 	glBindVertexArray(0);
 	
 	infos.vId = vao;
-	infos.eId = ebo;
-	infos.count = (GLsizei)mesh.indices.size();
+	infos.packed = true;
 	return infos;
 }
 
@@ -426,8 +657,40 @@ void GLUtilities::savePixels(const GLenum type, const GLenum format, const unsig
 	
 }
 
+bool GLUtilities::supportsCompression(const BlockCompression::Format format){
+	switch(format){
+		case BlockCompression::BC1:
+		case BlockCompression::BC3:
+			// Never part of the core specification.
+			return isSupported("GL_EXT_texture_compression_s3tc", 99, 0);
+		case BlockCompression::BC4:
+			// Grey images are sampled through swizzling (GL 3.3).
+			return isSupported("GL_ARB_texture_swizzle", 3, 3);
+		case BlockCompression::BC5:
+			return true;
+		case BlockCompression::BC6H:
+		case BlockCompression::BC7:
+			return isSupported("GL_ARB_texture_compression_bptc", 4, 2);
+		default:
+			return false;
+	}
+}
 
-
-
-
-
+bool GLUtilities::isSupported(const std::string & extension, const int major, const int minor){
+	GLint contextMajor = 0;
+	GLint contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+	if(contextMajor > major || (contextMajor == major && contextMinor >= minor)){
+		return true;
+	}
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(GLint eid = 0; eid < count; ++eid){
+		const GLubyte * name = glGetStringi(GL_EXTENSIONS, (GLuint)eid);
+		if(name != NULL && extension == (const char *)name){
+			return true;
+		}
+	}
+	return false;
+}
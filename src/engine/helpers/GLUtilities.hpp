@@ -1,6 +1,7 @@
 #ifndef GLUtilities_h
 #define GLUtilities_h
 #include "../resources/MeshUtilities.hpp"
+#include "../resources/TextureCache.hpp"
 #include "../Framebuffer.hpp"
 #include <gl3w/gl3w.h>
 #include <string>
@@ -25,16 +26,32 @@ struct TextureInfos {
 	int mipmap;
 	bool cubemap;
 	bool hdr;
-	TextureInfos() : id(0), width(0), height(0), mipmap(0), cubemap(false), hdr(false) {}
+	size_t bytes; ///< GPU memory used by all levels and faces.
+	TextureInfos() : id(0), width(0), height(0), mipmap(0), cubemap(false), hdr(false), bytes(0) {}
 
 };
 
+/// Range of the element buffer used by a level of detail.
+struct MeshLevel {
+	GLsizei count;
+	size_t offset; ///< In bytes.
+	float error; ///< Geometric error in model units, 0 for the full resolution mesh.
+	MeshLevel() : count(0), offset(0), error(0.0f) {}
+};
+
 struct MeshInfos {
 	GLuint vId;
 	GLuint eId;
 	GLsizei count;
+	GLenum indexType; ///< GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+	bool packed; ///< Interleaved quantized vertices, see PackedVertex.
+	std::vector<MeshLevel> levels; ///< The full resolution mesh followed by its simplified levels of detail.
+	glm::vec3 center; ///< Bounding sphere, in model space.
+	float radius;
+	std::vector<GLuint> buffers; ///< Vertex buffers referenced by the vertex array.
+	size_t bytes; ///< GPU memory used by the vertex and element buffers.
 
-	MeshInfos() : vId(0), eId(0), count(0) {}
+	MeshInfos() : vId(0), eId(0), count(0), indexType(GL_UNSIGNED_INT), packed(false), center(0.0f), radius(0.0f), bytes(0) {}
 
 };
 
@@ -45,6 +62,13 @@ private:
 	/// Load a shader of the given type from a string
 	static GLuint loadShader(const std::string & prog, GLuint type);
 	
+	/// Upload the indices and the levels of detail to the bound vertex array, using 16 bits indices when possible.
+	/// Also set the bounding sphere used to select the levels. Prepared meshes are used as is.
+	static void setupIndices(const MeshView & mesh, MeshInfos & infos);
+	
+	/// Upload a mesh as a single interleaved buffer of packed vertices.
+	static MeshInfos setupPackedBuffers(const MeshView & mesh);
+	
 	static void savePixels(const GLenum type, const GLenum format, const unsigned int width, const unsigned int height, const unsigned int components, const std::string & path, const bool flip, const bool ignoreAlpha);
 	
 public:
@@ -54,20 +78,45 @@ public:
 	static GLuint createProgram(const std::string & vertexContent, const std::string & fragmentContent);
 	
 	// Texture loading.
-	/// 2D texture.
+	/// 2D texture, one path per mip level. The levels are decoded concurrently.
 	static TextureInfos loadTexture(const std::vector<std::string>& path, bool sRGB);
 	
-	/// Cubemap texture.
+	/// Cubemap texture, six faces per mip level. All faces and levels are decoded concurrently.
 	static TextureInfos loadTextureCubemap(const std::vector<std::vector<std::string>> & paths, bool sRGB);
 	
+	/// 2D texture from decoded images: either one image with its mip chain, or one image per mip level.
+	/// The mip chain of a lone uncompressed base level is generated on the GPU. Storage is immutable when supported.
+	static TextureInfos loadTexture(const std::vector<ImageView> & images, bool sRGB);
+	
+	/// Cubemap texture from decoded faces: either one set of faces with their mip chains, or one set of faces per mip level.
+	/// The mip chains of lone uncompressed base levels are generated on the GPU. Storage is immutable when supported.
+	static TextureInfos loadTextureCubemap(const std::vector<std::vector<ImageView>> & images, bool sRGB);
+	
 	// Mesh loading.
-	static MeshInfos setupBuffers(const Mesh & mesh);
+	static MeshInfos setupBuffers(const Mesh & mesh, const bool packed = false);
+	
+	/// Upload mesh data that can live outside of a Mesh (for instance in a mapped cache file).
+	/// If packed, a single interleaved buffer of PackedVertex is used, and shaders should decode the attributes.
+	/// Data derived by MeshUtilities::prepareUpload is used instead of being computed on the calling thread.
+	static MeshInfos setupBuffers(const MeshView & mesh, const bool packed = false);
+	
+	/// Delete the vertex array and buffers of a mesh.
+	static void deleteMesh(MeshInfos & infos);
+	
+	/// Delete a texture.
+	static void deleteTexture(TextureInfos & infos);
 	
 	// Framebuffer saving to disk.
 	static void saveFramebuffer(const std::shared_ptr<Framebuffer> & framebuffer, const unsigned int width, const unsigned int height, const std::string & path, const bool flip = true, const bool ignoreAlpha = false);
 	
 	static void saveDefaultFramebuffer(const unsigned int width, const unsigned int height, const std::string & path);
 	
+	/// Check if the GPU can sample a block compressed format. RGTC (BC4, BC5) is core since GL 3.0, BPTC (BC6H, BC7) since GL 4.2, S3TC (BC1, BC3) is an extension.
+	static bool supportsCompression(const BlockCompression::Format format);
+	
+	/// Check if a feature is available, either because the context version is at least major.minor or through its extension.
+	static bool isSupported(const std::string & extension, const int major, const int minor);
+	
 };
 
 
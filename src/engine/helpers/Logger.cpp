@@ -7,6 +7,9 @@
 // but we want it to always be created.
 Log* Log::_defaultLogger = new Log();
 
+/// Messages from multiple threads are written one at a time.
+static std::mutex logMutex;
+
 void Log::set(LogLevel l){
 	_level = l;
 	_appendPrefix = (l != LogLevel::INFO);
@@ -18,6 +21,7 @@ Log::Log(){
 	_verbose = false;
 	_ignoreUntilFlush = false;
 	_appendPrefix = false;
+	_output = NULL;
 }
 
 Log::Log(const std::string & filePath, const bool logToStdin, const bool verbose){
@@ -26,15 +30,26 @@ Log::Log(const std::string & filePath, const bool logToStdin, const bool verbose
 	_verbose = verbose;
 	_ignoreUntilFlush = false;
 	_appendPrefix = false;
+	_output = NULL;
 	// Create file if it doesnt exist.
 	setFile(filePath, false);
 }
 
+Log::Log(Log * output){
+	_level = LogLevel::INFO;
+	_logToStdin = false;
+	_verbose = false;
+	_ignoreUntilFlush = false;
+	_appendPrefix = false;
+	_output = output;
+}
+
 void Log::setFile(const std::string & filePath, const bool flushExisting){
 	if(flushExisting){
 		_stream << std::endl;
 		flush();
 	}
+	std::lock_guard<std::mutex> lock(logMutex);
 	if(_file.is_open()){
 		_file.close();
 	}
@@ -50,6 +65,13 @@ void Log::setVerbose(const bool verbose){
 	_verbose = verbose;
 }
 
+Log & Log::threadLogger(LogLevel l){
+	// Each thread builds its messages separately, so that they don't get mixed.
+	static thread_local Log logger(_defaultLogger);
+	logger.set(l);
+	return logger;
+}
+
 
 
 
@@ -62,34 +84,24 @@ void Log::setDefaultVerbose(const bool verbose){
 }
 
 Log& Log::Info(){
-	_defaultLogger->set(LogLevel::INFO);
-	return *_defaultLogger;
+	return threadLogger(LogLevel::INFO);
 }
 
 Log& Log::Warning(){
-	_defaultLogger->set(LogLevel::WARNING);
-	return *_defaultLogger;
+	return threadLogger(LogLevel::WARNING);
 }
 
 Log& Log::Error(){
-	_defaultLogger->set(LogLevel::ERROR);
-	return *_defaultLogger;
+	return threadLogger(LogLevel::ERROR);
 }
 
 void Log::flush(){
 	if(!_ignoreUntilFlush){
-		
 		const std::string finalStr =  _stream.str();
-		
-		if(_logToStdin){
-			if(_level == LogLevel::INFO){
-				std::cout << finalStr << std::flush;
-			} else {
-				std::cerr << finalStr << std::flush;
-			}
-		}
-		if(_file.is_open()){
-			_file << finalStr << std::flush;
+		if(_output != NULL){
+			_output->write(finalStr, _level);
+		} else {
+			write(finalStr, _level);
 		}
 	}
 	_ignoreUntilFlush = false;
@@ -99,6 +111,20 @@ void Log::flush(){
 	_level = LogLevel::INFO;
 }
 
+void Log::write(const std::string & str, LogLevel l){
+	std::lock_guard<std::mutex> lock(logMutex);
+	if(_logToStdin){
+		if(l == LogLevel::INFO){
+			std::cout << str << std::flush;
+		} else {
+			std::cerr << str << std::flush;
+		}
+	}
+	if(_file.is_open()){
+		_file << str << std::flush;
+	}
+}
+
 void Log::appendIfNeeded(){
 	if(_appendPrefix){
 		_appendPrefix = false;
@@ -110,7 +136,7 @@ Log & Log::operator<<(const LogDomain& domain){
 	if(domain != Verbose){
 		_stream << "[" << _domainStrings[domain] << "] ";
 		appendIfNeeded();
-	} else if(!_verbose){
+	} else if(!(_output != NULL ? _output->_verbose : _verbose)){
 		// In this case, we want to ignore until the next flush.
 		_ignoreUntilFlush = true;
 	}
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <mutex>
 #include <glm/glm.hpp>
 // Fix for Windows headers.
 #ifdef ERROR
@@ -80,7 +81,16 @@ public:
 
 private:
 	
+	/// Logger accumulating the messages of a thread, written by the 'output' logger.
+	Log(Log * output);
+	
+	/// Logger of the calling thread, forwarding to the default logger.
+	static Log & threadLogger(LogLevel l);
+	
 	void flush();
+	
+	/// Write a complete message to the outputs.
+	void write(const std::string & str, LogLevel l);
 
 	void appendIfNeeded();
 	
@@ -91,6 +101,7 @@ private:
 	bool _verbose;
 	bool _ignoreUntilFlush;
 	bool _appendPrefix;
+	Log * _output;
 	
 	static Log* _defaultLogger;
 };
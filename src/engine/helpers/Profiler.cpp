@@ -0,0 +1,196 @@
+#include "Profiler.hpp"
+#include "Logger.hpp"
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+static const std::string kStageNames[] = { "index", "read", "decode", "parse", "tangents", "mipmaps", "compress", "upload" };
+static const size_t kStagesCount = sizeof(kStageNames) / sizeof(kStageNames[0]);
+
+static std::mutex profilerMutex;
+static std::vector<Profiler::Event> profilerEvents;
+static std::chrono::steady_clock::time_point profilerOrigin;
+static std::atomic<bool> profilerEnabled(false);
+static std::atomic<unsigned int> profilerThreadsCount(1);
+static thread_local int profilerThread = -1;
+
+/// Small index of the calling thread, assigned on first use.
+static unsigned int currentThread(){
+	if(profilerThread < 0){
+		profilerThread = (int)(profilerThreadsCount++);
+	}
+	return (unsigned int)profilerThread;
+}
+
+/// Escape a string to be used as a JSON value.
+static std::string escapeJSON(const std::string & str){
+	std::string escaped;
+	escaped.reserve(str.size());
+	for(const char c : str){
+		if(c == '"' || c == '\\'){
+			escaped.push_back('\\');
+			escaped.push_back(c);
+		} else if((unsigned char)c < 0x20){
+			escaped.push_back(' ');
+		} else {
+			escaped.push_back(c);
+		}
+	}
+	return escaped;
+}
+
+static std::string formatBytes(const size_t bytes){
+	std::stringstream str;
+	str << std::fixed << std::setprecision(1);
+	if(bytes >= 1024 * 1024){
+		str << double(bytes) / (1024.0 * 1024.0) << "MB";
+	} else {
+		str << double(bytes) / 1024.0 << "kB";
+	}
+	return str.str();
+}
+
+Profiler::Scope::Scope(const Stage stage, const std::string & name) : _enabled(profilerEnabled) {
+	if(!_enabled){
+		return;
+	}
+	_event.stage = stage;
+	_event.name = name;
+	_event.thread = currentThread();
+	_event.bytesRead = 0;
+	_event.bytesDecoded = 0;
+	_event.bytesUploaded = 0;
+	_start = std::chrono::steady_clock::now();
+}
+
+Profiler::Scope::~Scope(){
+	if(!_enabled){
+		return;
+	}
+	const auto end = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	// The profiler could have been restarted in the meantime.
+	if(!profilerEnabled || _start < profilerOrigin){
+		return;
+	}
+	_event.start = std::chrono::duration_cast<std::chrono::microseconds>(_start - profilerOrigin).count();
+	_event.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - _start).count();
+	profilerEvents.push_back(_event);
+}
+
+void Profiler::setEnabled(const bool enabled){
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	if(enabled){
+		profilerEvents.clear();
+		profilerOrigin = std::chrono::steady_clock::now();
+		profilerThread = 0;
+	}
+	profilerEnabled = enabled;
+}
+
+bool Profiler::enabled(){
+	return profilerEnabled;
+}
+
+std::vector<Profiler::Event> Profiler::events(){
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	return profilerEvents;
+}
+
+void Profiler::report(const size_t count){
+	std::vector<Event> events = Profiler::events();
+	if(events.empty()){
+		Log::Info() << Log::Resources << "Profiler: no event recorded." << std::endl;
+		return;
+	}
+	uint64_t endTime = 0;
+	for(const auto & event : events){
+		endTime = std::max(endTime, event.start + event.duration);
+	}
+
+	// Totals per stage, nested events are counted in each of their stages.
+	struct StageTotal {
+		size_t stage;
+		size_t count;
+		uint64_t duration;
+		size_t bytesRead;
+		size_t bytesDecoded;
+		size_t bytesUploaded;
+	};
+	std::vector<StageTotal> totals(kStagesCount);
+	for(size_t sid = 0; sid < kStagesCount; ++sid){
+		totals[sid] = { sid, 0, 0, 0, 0, 0 };
+	}
+	for(const auto & event : events){
+		StageTotal & total = totals[event.stage];
+		++total.count;
+		total.duration += event.duration;
+		total.bytesRead += event.bytesRead;
+		total.bytesDecoded += event.bytesDecoded;
+		total.bytesUploaded += event.bytesUploaded;
+	}
+	std::sort(totals.begin(), totals.end(), [](const StageTotal & a, const StageTotal & b){
+		return a.duration > b.duration;
+	});
+
+	// Format in a local stream, to not change the logger formatting flags.
+	std::stringstream summary;
+	summary << std::fixed << std::setprecision(2);
+	summary << "Profiler: " << events.size() << " events over " << double(endTime) / 1000.0 << "ms." << std::endl;
+	for(const auto & total : totals){
+		if(total.count == 0){
+			continue;
+		}
+		summary << "  " << std::setw(9) << std::left << kStageNames[total.stage] << std::right << std::setw(10) << double(total.duration) / 1000.0 << "ms, " << total.count << " events, read " << formatBytes(total.bytesRead) << ", decoded " << formatBytes(total.bytesDecoded) << ", uploaded " << formatBytes(total.bytesUploaded) << "." << std::endl;
+	}
+
+	// Slowest events.
+	const size_t shown = std::min(count, events.size());
+	std::partial_sort(events.begin(), events.begin() + shown, events.end(), [](const Event & a, const Event & b){
+		return a.duration > b.duration;
+	});
+	summary << "Profiler: " << shown << " slowest events." << std::endl;
+	for(size_t eid = 0; eid < shown; ++eid){
+		const Event & event = events[eid];
+		summary << "  " << std::setw(10) << double(event.duration) / 1000.0 << "ms " << std::setw(9) << std::left << kStageNames[event.stage] << std::right << event.name << " (thread " << event.thread;
+		if(event.bytesRead > 0){
+			summary << ", read " << formatBytes(event.bytesRead);
+		}
+		if(event.bytesDecoded > 0){
+			summary << ", decoded " << formatBytes(event.bytesDecoded);
+		}
+		if(event.bytesUploaded > 0){
+			summary << ", uploaded " << formatBytes(event.bytesUploaded);
+		}
+		summary << ")." << std::endl;
+	}
+	std::string line;
+	while(std::getline(summary, line)){
+		Log::Info() << Log::Resources << line << std::endl;
+	}
+}
+
+bool Profiler::saveTrace(const std::string & path){
+	const std::vector<Event> events = Profiler::events();
+	std::ofstream file(path);
+	if(!file.is_open()){
+		Log::Error() << Log::Resources << "Unable to save the profiler trace to \"" << path << "\"." << std::endl;
+		return false;
+	}
+	// Complete events ('X'), with the data sizes as arguments.
+	file << "{\"traceEvents\":[" << std::endl;
+	for(size_t eid = 0; eid < events.size(); ++eid){
+		const Event & event = events[eid];
+		file << "{\"name\":\"" << escapeJSON(event.name) << "\",\"cat\":\"" << kStageNames[event.stage] << "\",\"ph\":\"X\"";
+		file << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << ",\"pid\":0,\"tid\":" << event.thread;
+		file << ",\"args\":{\"bytesRead\":" << event.bytesRead << ",\"bytesDecoded\":" << event.bytesDecoded << ",\"bytesUploaded\":" << event.bytesUploaded << "}}";
+		file << (eid + 1 < events.size() ? "," : "") << std::endl;
+	}
+	file << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+	file.close();
+	Log::Info() << Log::Resources << "Profiler trace saved to \"" << path << "\"." << std::endl;
+	return true;
+}
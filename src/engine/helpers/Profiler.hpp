@@ -0,0 +1,78 @@
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+
+/// Record timed events of the resources loading pipeline, from any thread.
+/// Events can be summarized in the log or exported to the Chrome trace event format (chrome://tracing).
+class Profiler {
+
+public:
+
+	/// Pipeline stages.
+	enum Stage {
+		Index, Read, Decode, Parse, Tangents, Mipmaps, Compress, Upload
+	};
+
+	/// Timed task, with the amount of data it processed.
+	struct Event {
+		Stage stage;
+		std::string name;
+		unsigned int thread; ///< 0 for the thread that enabled the profiler.
+		uint64_t start; ///< In microseconds since the profiler was enabled.
+		uint64_t duration; ///< In microseconds.
+		size_t bytesRead;
+		size_t bytesDecoded;
+		size_t bytesUploaded;
+	};
+
+	/// Time the lifetime of the object, and record it as an event if the profiler is enabled.
+	class Scope {
+
+	public:
+
+		Scope(const Stage stage, const std::string & name);
+
+		~Scope();
+
+		void setBytesRead(const size_t bytes){ _event.bytesRead = bytes; }
+
+		void setBytesDecoded(const size_t bytes){ _event.bytesDecoded = bytes; }
+
+		void setBytesUploaded(const size_t bytes){ _event.bytesUploaded = bytes; }
+
+	private:
+
+		Scope(const Scope &);
+
+		Scope & operator= (const Scope &);
+
+		Event _event;
+
+		std::chrono::steady_clock::time_point _start;
+
+		bool _enabled;
+
+	};
+
+	/// Start or stop recording. Enabling clears the previous events and resets the time origin.
+	static void setEnabled(const bool enabled);
+
+	static bool enabled();
+
+	/// Log the time spent in each stage, and the slowest events.
+	static void report(const size_t count = 20);
+
+	/// Write the recorded events as a Chrome trace JSON file. Return false on failure.
+	static bool saveTrace(const std::string & path);
+
+	/// Copy of the recorded events.
+	static std::vector<Event> events();
+
+};
+
+#endif
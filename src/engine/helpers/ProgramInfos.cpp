@@ -96,7 +96,13 @@ void ProgramInfos::reload()
 {
 	const std::string vertexContent = Resources::manager().getShader(_vertexName, Resources::Vertex);
 	const std::string fragmentContent = Resources::manager().getShader(_fragmentName, Resources::Fragment);
-	_id = GLUtilities::createProgram(vertexContent, fragmentContent);
+	const GLuint newId = GLUtilities::createProgram(vertexContent, fragmentContent);
+	// Keep the previous version if the new one is invalid.
+	if(newId == 0){
+		return;
+	}
+	glDeleteProgram(_id);
+	_id = newId;
 	// For each stored uniform, update its location, and update textures slots and cached values.
 	glUseProgram(_id);
 	for (auto & uni : _uniforms) {
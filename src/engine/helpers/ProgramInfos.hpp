@@ -32,6 +32,10 @@ public:
 	// To stay coherent with TextureInfos and MeshInfos, we keep the id public.
 	const GLuint id() const { return _id; }
 	
+	const std::string & vertexName() const { return _vertexName; }
+	
+	const std::string & fragmentName() const { return _fragmentName; }
+	
 private:
 	
 	GLuint _id;
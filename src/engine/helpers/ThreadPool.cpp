@@ -0,0 +1,46 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(const unsigned int threads) : _stop(false) {
+	const unsigned int count = std::max(1u, threads);
+	_workers.reserve(count);
+	for(unsigned int tid = 0; tid < count; ++tid){
+		_workers.emplace_back(&ThreadPool::run, this);
+	}
+}
+
+ThreadPool::~ThreadPool(){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	for(auto & worker : _workers){
+		worker.join();
+	}
+}
+
+void ThreadPool::push(const std::function<void()> & task){
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push_back(task);
+	}
+	_condition.notify_one();
+}
+
+void ThreadPool::run(){
+	while(true){
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this](){ return _stop || !_tasks.empty(); });
+			// Only exit once everything has been executed.
+			if(_tasks.empty()){
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+		}
+		task();
+	}
+}
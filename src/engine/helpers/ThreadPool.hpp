@@ -0,0 +1,50 @@
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <deque>
+
+/// Fixed set of worker threads executing tasks in submission order.
+/// Pending tasks are still executed when the pool is destroyed.
+class ThreadPool {
+
+public:
+
+	/// Start the given number of workers (at least one).
+	ThreadPool(const unsigned int threads);
+
+	/// Wait for all tasks to be executed and join the workers.
+	~ThreadPool();
+
+	/// Queue a task, executed by the first available worker.
+	void push(const std::function<void()> & task);
+
+	/// Number of workers.
+	size_t size() const { return _workers.size(); }
+
+private:
+
+	ThreadPool(const ThreadPool &);
+
+	ThreadPool & operator= (const ThreadPool &);
+
+	/// Main loop of each worker.
+	void run();
+
+	std::vector<std::thread> _workers;
+
+	std::deque<std::function<void()>> _tasks;
+
+	std::mutex _mutex;
+
+	std::condition_variable _condition;
+
+	bool _stop;
+
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "UploadRing.hpp"
+#include "GLUtilities.hpp"
+#include "Logger.hpp"
+
+UploadRing::UploadRing() : _buffer(0), _data(NULL), _size(0), _head(0), _firstId(0) {
+}
+
+bool UploadRing::init(const size_t size){
+	clean();
+	if(size == 0){
+		return false;
+	}
+	// Buffers can stay mapped while the GPU reads them with GL 4.4.
+	if(glBufferStorage == NULL || !GLUtilities::isSupported("GL_ARB_buffer_storage", 4, 4)){
+		Log::Warning() << Log::OpenGL << "Persistent buffer mapping unsupported, textures will be uploaded from client memory." << std::endl;
+		return false;
+	}
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &_buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, NULL, flags);
+	char * data = (char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	if(data == NULL){
+		Log::Error() << Log::OpenGL << "Unable to map the upload buffer." << std::endl;
+		glDeleteBuffers(1, &_buffer);
+		_buffer = 0;
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_data = data;
+		_size = size;
+		_head = 0;
+	}
+	Log::Info() << Log::OpenGL << "Streaming texture uploads through a " << (size / (1024 * 1024)) << "MB pixel buffer." << std::endl;
+	return true;
+}
+
+void UploadRing::clean(){
+	std::lock_guard<std::mutex> lock(_mutex);
+	// The GPU might still be reading from the buffer.
+	for(const Slot & slot : _slots){
+		if(slot.fence != NULL){
+			glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(slot.fence);
+		}
+	}
+	_firstId += _slots.size();
+	_slots.clear();
+	if(_buffer != 0){
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &_buffer);
+	}
+	_buffer = 0;
+	_data = NULL;
+	_size = 0;
+	_head = 0;
+}
+
+bool UploadRing::allocate(const size_t size, Allocation & allocation){
+	std::lock_guard<std::mutex> lock(_mutex);
+	const size_t alignedSize = ((size + alignment - 1) / alignment) * alignment;
+	if(_data == NULL || size == 0 || alignedSize > _size){
+		return false;
+	}
+	size_t offset = _head;
+	if(_slots.empty()){
+		// Nothing in flight, restart from the beginning.
+		offset = 0;
+	} else {
+		const size_t tail = _slots.front().offset;
+		// Once wrapped, the free space lies between the newest and the oldest allocations.
+		const bool wrapped = _slots.back().offset < tail;
+		if(wrapped){
+			if(offset + alignedSize > tail){
+				return false;
+			}
+		} else if(offset + alignedSize > _size){
+			// Not enough room at the end, try before the oldest allocation.
+			if(alignedSize > tail){
+				return false;
+			}
+			offset = 0;
+		}
+	}
+	allocation.id = _firstId + _slots.size();
+	allocation.offset = offset;
+	allocation.size = size;
+	allocation.data = _data + offset;
+	_slots.push_back({ offset, alignedSize, NULL });
+	_head = offset + alignedSize;
+	return true;
+}
+
+void UploadRing::submit(const Allocation & allocation){
+	std::lock_guard<std::mutex> lock(_mutex);
+	if(allocation.id < _firstId || allocation.id >= _firstId + _slots.size()){
+		return;
+	}
+	Slot & slot = _slots[size_t(allocation.id - _firstId)];
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UploadRing::retire(){
+	std::lock_guard<std::mutex> lock(_mutex);
+	// Space is reused in order, stop at the first allocation still in use.
+	while(!_slots.empty()){
+		const Slot & slot = _slots.front();
+		if(slot.fence == NULL || glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED){
+			break;
+		}
+		glDeleteSync(slot.fence);
+		_slots.pop_front();
+		++_firstId;
+	}
+}
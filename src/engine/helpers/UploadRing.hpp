@@ -0,0 +1,83 @@
+#ifndef UploadRing_h
+#define UploadRing_h
+
+#include <gl3w/gl3w.h>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/// Ring of pixel unpack buffer memory, persistently mapped, used to stream texture data to the GPU.
+/// Loading threads reserve space and write in it directly, the main thread then issues the uploads from
+/// the buffer, and the space is reused once a fence tells that the GPU has finished reading it.
+/// Requires persistent mapping (GL 4.4 or ARB_buffer_storage), else the ring stays disabled.
+class UploadRing {
+
+public:
+
+	/// Reserved space in the ring.
+	struct Allocation {
+		unsigned long long id;
+		size_t offset; ///< In bytes, from the start of the buffer.
+		size_t size;
+		char * data; ///< Mapped memory, writable from any thread.
+		Allocation() : id(0), offset(0), size(0), data(NULL) {}
+	};
+
+	UploadRing();
+
+	/// Create and map a buffer of the given size (0 to disable the ring), on the main thread. Return false if persistent mapping is unsupported.
+	bool init(const size_t size);
+
+	/// Wait for the pending uploads and delete the buffer, on the main thread.
+	void clean();
+
+	/// Reserve contiguous space, from any thread. Never blocks: return false if the ring is disabled or full.
+	bool allocate(const size_t size, Allocation & allocation);
+
+	/// Mark the space as in use by the GPU, once the commands reading from it have been issued on the main thread.
+	void submit(const Allocation & allocation);
+
+	/// Recycle the space of the uploads finished by the GPU, on the main thread.
+	void retire();
+
+	GLuint buffer() const { return _buffer; }
+
+	bool enabled() const { return _data != NULL; }
+
+	size_t size() const { return _size; }
+
+	/// Alignment of the allocations, enough for any pixel type.
+	static const size_t alignment = 64;
+
+private:
+
+	UploadRing(const UploadRing &);
+
+	UploadRing & operator= (const UploadRing &);
+
+	/// Allocations in ring order, from the oldest one.
+	struct Slot {
+		size_t offset;
+		size_t size;
+		GLsync fence; ///< Set once submitted.
+	};
+
+	GLuint _buffer;
+
+	char * _data;
+
+	size_t _size;
+
+	/// Offset of the next allocation.
+	size_t _head;
+
+	std::deque<Slot> _slots;
+
+	/// Id of the oldest slot.
+	unsigned long long _firstId;
+
+	std::mutex _mutex;
+
+};
+
+#endif
@@ -19,6 +19,9 @@ public:
 	
 	void blurAndUnbind() const;
 	
+	/// Size of the shadow map, in pixels.
+	glm::vec2 shadowMapSize() const { return glm::vec2(_shadowPass->width(), _shadowPass->height()); }
+	
 	void clean() const;
 	
 private:
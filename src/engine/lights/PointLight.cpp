@@ -67,10 +67,11 @@ void PointLight::draw(const glm::mat4& viewMatrix, const glm::mat4& projectionMa
 	
 	
 	// Select the geometry.
-	glBindVertexArray(_debugMesh.vId);
+	const MeshInfos & mesh = _debugMesh->infos;
+	glBindVertexArray(mesh.vId);
 	// Draw!
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _debugMesh.eId);
-	glDrawElements(GL_TRIANGLES, _debugMesh.count, GL_UNSIGNED_INT, (void*)0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.eId);
+	glDrawElements(GL_TRIANGLES, mesh.count, mesh.indexType, (void*)0);
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
@@ -89,10 +90,11 @@ void PointLight::drawDebug(const glm::mat4& viewMatrix, const glm::mat4& project
 	glUniform3fv(_debugProgram->uniform("lightColor"), 1,  &_color[0]);
 	
 	// Select the geometry.
-	glBindVertexArray(_debugMesh.vId);
+	const MeshInfos & mesh = _debugMesh->infos;
+	glBindVertexArray(mesh.vId);
 	// Draw!
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _debugMesh.eId);
-	glDrawElements(GL_TRIANGLES, _debugMesh.count, GL_UNSIGNED_INT, (void*)0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.eId);
+	glDrawElements(GL_TRIANGLES, mesh.count, mesh.indexType, (void*)0);
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
@@ -104,7 +106,7 @@ void PointLight::clean() const {
 }
 
 std::shared_ptr<ProgramInfos> PointLight::_debugProgram;
-MeshInfos PointLight::_debugMesh;
+std::shared_ptr<AsyncMesh> PointLight::_debugMesh;
 
 
 
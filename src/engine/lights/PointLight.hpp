@@ -27,7 +27,7 @@ private:
 	std::shared_ptr<ProgramInfos> _program;
 	
 	static std::shared_ptr<ProgramInfos> _debugProgram;
-	static MeshInfos _debugMesh;
+	static std::shared_ptr<AsyncMesh> _debugMesh;
 	
 };
 
@@ -28,7 +28,7 @@ Renderer::Renderer(Config & config, std::shared_ptr<Scene> & scene) : _config(co
 	
 	_scene = scene;
 	if(_scene){
-		_scene->init();
+		_scene->load(_config.recordManifest);
 	}
 	
 }
@@ -42,7 +42,7 @@ void Renderer::update(){
 }
 
 
-void Renderer::clean() const {
+void Renderer::clean() {
 	// Clean objects.
 	if(_scene){
 		_scene->clean();
@@ -29,7 +29,7 @@ public:
 	virtual void physics(double fullTime, double frameTime) = 0;
 	
 	/// Clean function
-	virtual void clean() const;
+	virtual void clean();
 	
 	/// Handle screen resizing
 	virtual void resize(int width, int height) = 0;
@@ -11,7 +11,7 @@ AmbientQuad::AmbientQuad(){}
 
 AmbientQuad::~AmbientQuad(){}
 
-void AmbientQuad::init(std::map<std::string, GLuint> textureIds, const GLuint reflection, const std::vector<glm::vec3> & irradiance){
+void AmbientQuad::init(std::map<std::string, GLuint> textureIds, const std::shared_ptr<AsyncTexture> & reflection, const std::vector<glm::vec3> & irradiance){
 	
 	// Ambient pass: needs the albedo, the normals, the effect and the AO result
 	std::map<std::string, GLuint> finalTextures = { {"albedoTexture", textureIds["albedoTexture"]}, {"normalTexture", textureIds["normalTexture"]}, {"depthTexture", textureIds["depthTexture"]},  {"effectsTexture", textureIds["effectsTexture"]}, {"ssaoTexture", textureIds["ssaoTexture"]}};
@@ -20,7 +20,7 @@ void AmbientQuad::init(std::map<std::string, GLuint> textureIds, const GLuint re
 	
 	// Load texture.
 	_texCubeMap = reflection;
-	_texBrdfPrecalc = Resources::manager().getTexture("brdf-precomputed", false).id;
+	_texBrdfPrecalc = Resources::manager().getTexture("brdf-precomputed", false);
 	// Load Spherical Harmonics coefficients.
 	_program->cacheUniformArray("shCoeffs", irradiance);
 	// Bind uniform to texture slot.
@@ -88,11 +88,13 @@ void AmbientQuad::draw(const glm::mat4& viewMatrix, const glm::mat4& projectionM
 	glUniformMatrix4fv(_program->uniform("inverseV"), 1, GL_FALSE, &invView[0][0]);
 	glUniform4fv(_program->uniform("projectionMatrix"), 1, &(projectionVector[0]));
 	
+	// The ids change once uploaded or reloaded.
+	const std::shared_ptr<AsyncTexture> reflection = _texCubeMap.lock();
 	glActiveTexture(GL_TEXTURE0 + (unsigned int)_textureIds.size());
-	glBindTexture(GL_TEXTURE_CUBE_MAP, _texCubeMap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, reflection ? reflection->infos.id : 0);
 	
 	glActiveTexture(GL_TEXTURE0 + (unsigned int)_textureIds.size() + 1);
-	glBindTexture(GL_TEXTURE_2D, _texBrdfPrecalc);
+	glBindTexture(GL_TEXTURE_2D, _texBrdfPrecalc->infos.id);
 	
 	ScreenQuad::draw();
 }
@@ -109,7 +111,8 @@ void AmbientQuad::drawSSAO(const glm::mat4& viewMatrix, const glm::mat4& project
 
 
 
-void AmbientQuad::clean() const {
+void AmbientQuad::clean() {
 	ScreenQuad::clean();
 	_ssaoScreen.clean();
+	_texBrdfPrecalc.reset();
 }
@@ -1,12 +1,14 @@
 #ifndef AmbientQuad_h
 #define AmbientQuad_h
 #include "../../ScreenQuad.hpp"
+#include "../../resources/ResourcesManager.hpp"
 
 #include <gl3w/gl3w.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <vector>
 #include <map>
+#include <memory>
 
 class AmbientQuad : public ScreenQuad {
 
@@ -16,21 +18,22 @@ public:
 
 	~AmbientQuad();
 	
-	void init(std::map<std::string, GLuint> textureIds, const GLuint reflection, const std::vector<glm::vec3> & irradiance);
+	/// The reflection cubemap is owned by the scene, the quad doesn't keep it alive.
+	void init(std::map<std::string, GLuint> textureIds, const std::shared_ptr<AsyncTexture> & reflection, const std::vector<glm::vec3> & irradiance);
 	
 	/// Draw function,
 	void draw(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) const;
 	
 	void drawSSAO(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) const;
 		
-	void clean() const;
+	void clean();
 	
 private:
 	
 	GLuint setupSSAO();
 	
-	GLuint _texCubeMap;
-	GLuint _texBrdfPrecalc;
+	std::weak_ptr<AsyncTexture> _texCubeMap;
+	std::shared_ptr<AsyncTexture> _texBrdfPrecalc;
 	
 	ScreenQuad _ssaoScreen;
 	
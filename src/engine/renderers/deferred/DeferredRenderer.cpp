@@ -74,8 +74,9 @@ void DeferredRenderer::draw() {
 	for(auto& dirLight : _scene->directionalLights){
 
 		dirLight.bind();
+		const glm::vec2 shadowMapSize = dirLight.shadowMapSize();
 		for(auto& object : _scene->objects){
-			object.drawDepth(dirLight.mvp());
+			object.drawDepth(dirLight.mvp(), shadowMapSize);
 		}
 		dirLight.blurAndUnbind();
 	}
@@ -91,8 +92,9 @@ void DeferredRenderer::draw() {
 	// Clear the depth buffer (we know we will draw everywhere, no need to clear color.
 	glClear(GL_DEPTH_BUFFER_BIT);
 	
+	const glm::vec2 gbufferSize(_gbuffer->width(), _gbuffer->height());
 	for(auto & object : _scene->objects){
-		object.draw(_userCamera.view(), _userCamera.projection());
+		object.draw(_userCamera.view(), _userCamera.projection(), gbufferSize);
 	}
 	
 	for(auto& pointLight : _scene->pointLights){
@@ -200,8 +202,7 @@ void DeferredRenderer::physics(double fullTime, double frameTime){
 }
 
 
-void DeferredRenderer::clean() const {
-	Renderer::clean();
+void DeferredRenderer::clean() {
 	// Clean objects.
 	_ambientScreen.clean();
 	_fxaaScreen.clean();
@@ -216,6 +217,8 @@ void DeferredRenderer::clean() const {
 	_sceneFramebuffer->clean();
 	_toneMappingFramebuffer->clean();
 	_fxaaFramebuffer->clean();
+	// Last, so that the resources released above are freed along with the scene ones.
+	Renderer::clean();
 }
 
 
@@ -56,7 +56,7 @@ void Renderer2D::physics(double fullTime, double frameTime){
 }
 
 
-void Renderer2D::clean() const {
+void Renderer2D::clean() {
 	Renderer::clean();
 	// Clean objects.
 	_resultScreen.clean();
@@ -33,7 +33,7 @@ public:
 	void save(const std::string & outputPath);
 
 	/// Clean function
-	void clean() const;
+	void clean();
 
 	/// Handle screen resizing
 	void resize(int width, int height);
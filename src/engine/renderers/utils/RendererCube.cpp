@@ -21,6 +21,8 @@ RendererCube::RendererCube(Config & config, const std::string & cubemapName, con
 	
 	_program = Resources::manager().getProgram(shaderName, "object_basic", shaderName);
 	_cubemap = Object(_program, "skybox", {}, {{cubemapName, true }});
+	// The cubemap is rendered right away, it has to be fully loaded.
+	Resources::manager().finishUploads();
 	
 	checkGLError();
 
@@ -82,7 +84,7 @@ void RendererCube::physics(double fullTime, double frameTime){
 }
 
 
-void RendererCube::clean() const {
+void RendererCube::clean() {
 	Renderer::clean();
 	// Clean objects.
 	_cubemap.clean();
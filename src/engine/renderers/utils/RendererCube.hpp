@@ -32,7 +32,7 @@ public:
 	void physics(double fullTime, double frameTime);
 
 	/// Clean function
-	void clean() const;
+	void clean();
 
 	/// Handle screen resizing
 	void resize(int width, int height);
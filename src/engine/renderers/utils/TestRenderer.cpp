@@ -21,6 +21,7 @@ TestRenderer::TestRenderer(Config & config) : Renderer(config) {
 	checkGLError();
 
 	_screenQuad.init("passthrough");
+	_texture = Resources::manager().getTexture("desk_albedo");
 	checkGLError();
 	
 }
@@ -33,7 +34,7 @@ void TestRenderer::draw() {
 	glClear(GL_COLOR_BUFFER_BIT);
 	glDisable(GL_DEPTH_TEST);
 	glViewport(0,0,_framebuffer->width(), _framebuffer->height());
-	_screenQuad.draw(Resources::manager().getTexture("desk_albedo").id);
+	_screenQuad.draw(_texture->infos.id);
 	_framebuffer->unbind();
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -58,7 +59,8 @@ void TestRenderer::physics(double fullTime, double frameTime){
 }
 
 
-void TestRenderer::clean() const {
+void TestRenderer::clean() {
+	_texture.reset();
 	Renderer::clean();
 	// Clean objects.
 	_framebuffer->clean();
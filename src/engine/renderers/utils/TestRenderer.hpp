@@ -36,7 +36,7 @@ public:
 	void physics(double fullTime, double frameTime);
 
 	/// Clean function
-	void clean() const;
+	void clean();
 
 	/// Handle screen resizing
 	void resize(int width, int height);
@@ -48,6 +48,7 @@ private:
 
 	std::shared_ptr<Framebuffer> _framebuffer;
 	
+	std::shared_ptr<AsyncTexture> _texture;
 	
 	ScreenQuad _screenQuad;
 	
@@ -0,0 +1,111 @@
+#include "AssetIndex.hpp"
+#include <algorithm>
+#include <cctype>
+
+/// Supported image extensions, by order of preference when multiple files share a base name.
+static const std::vector<std::string> kImageExtensions = { "png", "jpg", "jpeg", "bmp", "tga", "exr" };
+/// Cubemap faces suffixes, in GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order.
+static const std::string kFacesSuffixes[6] = { "_px", "_nx", "_py", "_ny", "_pz", "_nz" };
+
+bool AssetIndex::Image::isCubemap() const {
+	for(int fid = 0; fid < 6; ++fid){
+		if(faces[fid].empty()){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool AssetIndex::add(const std::string & name, const std::string & path){
+	return _files.emplace(name, path).second;
+}
+
+void AssetIndex::finalize(){
+	_images.clear();
+
+	// Images by base name, keeping the preferred extension.
+	std::unordered_map<std::string, size_t> ranks;
+	ranks.reserve(_files.size());
+	_images.reserve(_files.size());
+	for(const auto & file : _files){
+		const size_t dotPos = file.first.find_last_of('.');
+		if(dotPos == std::string::npos){
+			continue;
+		}
+		const auto extension = std::find(kImageExtensions.begin(), kImageExtensions.end(), file.first.substr(dotPos + 1));
+		if(extension == kImageExtensions.end()){
+			continue;
+		}
+		const std::string name = file.first.substr(0, dotPos);
+		const size_t rank = extension - kImageExtensions.begin();
+		const auto existing = ranks.find(name);
+		if(existing == ranks.end() || rank < existing->second){
+			ranks[name] = rank;
+			_images[name].path = file.second;
+		}
+	}
+
+	// Faces, attached to the cubemap base name.
+	std::vector<std::string> names;
+	names.reserve(_images.size());
+	for(const auto & image : _images){
+		names.push_back(image.first);
+	}
+	for(const auto & name : names){
+		for(int fid = 0; fid < 6; ++fid){
+			const std::string & suffix = kFacesSuffixes[fid];
+			if(name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0){
+				_images[name.substr(0, name.size() - suffix.size())].faces[fid] = _images[name].path;
+				break;
+			}
+		}
+	}
+
+	// Mip levels, either images or cubemaps, attached to the texture base name.
+	// Elements of an unordered_map don't move when it grows, so they can be referenced directly.
+	names.clear();
+	for(const auto & image : _images){
+		names.push_back(image.first);
+	}
+	for(const auto & name : names){
+		const size_t separatorPos = name.find_last_of('_');
+		if(separatorPos == std::string::npos || separatorPos == 0 || separatorPos + 1 == name.size()){
+			continue;
+		}
+		const std::string levelString = name.substr(separatorPos + 1);
+		if(levelString.size() > 4 || !std::all_of(levelString.begin(), levelString.end(), [](const char c){ return std::isdigit((unsigned char)c) != 0; })){
+			continue;
+		}
+		// Same naming as the textures loading: no leading zeros.
+		const size_t level = (size_t)std::stoul(levelString);
+		if(std::to_string(level) != levelString){
+			continue;
+		}
+		Image & texture = _images[name.substr(0, separatorPos)];
+		if(texture.levels.size() <= level){
+			texture.levels.resize(level + 1, NULL);
+		}
+		texture.levels[level] = &_images[name];
+	}
+	// Only keep the levels up to the first missing one.
+	for(auto & image : _images){
+		auto & levels = image.second.levels;
+		levels.erase(std::find(levels.begin(), levels.end(), (const Image *)NULL), levels.end());
+	}
+}
+
+const std::string & AssetIndex::file(const std::string & name) const {
+	static const std::string emptyPath;
+	const auto file = _files.find(name);
+	return file != _files.end() ? file->second : emptyPath;
+}
+
+const AssetIndex::Image * AssetIndex::image(const std::string & name) const {
+	const auto image = _images.find(name);
+	return image != _images.end() ? &image->second : NULL;
+}
+
+void AssetIndex::clear(){
+	_files.clear();
+	_images.clear();
+}
@@ -0,0 +1,49 @@
+#ifndef AssetIndex_h
+#define AssetIndex_h
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/// Hash index of the resource files, built once when listing the resources.
+/// Images are also indexed by base name, with their mip level and cubemap face variants resolved,
+/// so that finding the files of a texture doesn't require probing each extension and suffix.
+class AssetIndex {
+
+public:
+
+	/// All image variants sharing a base name.
+	struct Image {
+		std::string path; ///< Image named exactly 'name', with the preferred extension. Empty if none.
+		std::string faces[6]; ///< Images named 'name_px', 'name_nx', 'name_py', 'name_ny', 'name_pz', 'name_nz'.
+		std::vector<const Image *> levels; ///< Variants named 'name_0', 'name_1',... up to the first missing one.
+
+		/// Are all six faces present.
+		bool isCubemap() const;
+	};
+
+	/// Register a file by its name with extension. Return false if the name is already used.
+	bool add(const std::string & name, const std::string & path);
+
+	/// Index the images, to be called once all files have been added.
+	void finalize();
+
+	/// Path of a file from its name with extension, empty if not found.
+	const std::string & file(const std::string & name) const;
+
+	/// Image variants for a base name, NULL if not found.
+	const Image * image(const std::string & name) const;
+
+	size_t size() const { return _files.size(); }
+
+	void clear();
+
+private:
+
+	std::unordered_map<std::string, std::string> _files;
+
+	std::unordered_map<std::string, Image> _images;
+
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "AssetManifest.hpp"
+#include "../helpers/Logger.hpp"
+#include <sstream>
+
+static const std::string kTypeNames[] = { "mesh", "texture", "cubemap", "file" };
+static const size_t kTypesCount = sizeof(kTypeNames) / sizeof(kTypeNames[0]);
+
+void AssetManifest::add(const Type type, const std::string & name, const bool srgb){
+	for(const auto & entry : _entries){
+		if(entry.type == type && entry.name == name){
+			return;
+		}
+	}
+	_entries.push_back({ type, name, srgb });
+}
+
+bool AssetManifest::parse(const std::string & content){
+	std::stringstream lines(content);
+	std::string line;
+	bool valid = true;
+	while(std::getline(lines, line)){
+		std::stringstream tokens(line);
+		std::string typeName;
+		std::string name;
+		std::string option;
+		tokens >> typeName >> name >> option;
+		if(typeName.empty() || typeName[0] == '#'){
+			continue;
+		}
+		size_t tid = 0;
+		while(tid < kTypesCount && kTypeNames[tid] != typeName){
+			++tid;
+		}
+		if(tid == kTypesCount || name.empty() || (!option.empty() && option != "srgb")){
+			Log::Warning() << Log::Resources << "Invalid manifest line \"" << line << "\"." << std::endl;
+			valid = false;
+			continue;
+		}
+		add(Type(tid), name, option == "srgb");
+	}
+	return valid;
+}
+
+std::string AssetManifest::serialize() const {
+	std::stringstream content;
+	content << "# type name [srgb]" << std::endl;
+	for(const auto & entry : _entries){
+		content << kTypeNames[entry.type] << " " << entry.name;
+		if(entry.srgb && (entry.type == Texture || entry.type == Cubemap)){
+			content << " srgb";
+		}
+		content << std::endl;
+	}
+	return content.str();
+}
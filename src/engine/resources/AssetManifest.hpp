@@ -0,0 +1,45 @@
+#ifndef AssetManifest_h
+#define AssetManifest_h
+
+#include <string>
+#include <vector>
+
+/// List of the resources used by a scene, so that they can all be prefetched before the scene is initialized.
+/// It is either declared explicitly in a text file, or recorded from the requests of a run. Each line is
+/// "type name [srgb]" with type one of mesh, texture, cubemap or file; lines starting with '#' are ignored.
+class AssetManifest {
+
+public:
+
+	enum Type {
+		Mesh, Texture, Cubemap, File
+	};
+
+	struct Entry {
+		Type type;
+		std::string name;
+		bool srgb; ///< Textures and cubemaps only.
+	};
+
+	/// Append an entry, unless it is already listed.
+	void add(const Type type, const std::string & name, const bool srgb = false);
+
+	/// Append the entries described in a manifest text. Return false if a line is invalid.
+	bool parse(const std::string & content);
+
+	/// Text representation, that can be parsed back.
+	std::string serialize() const;
+
+	const std::vector<Entry> & entries() const { return _entries; }
+
+	bool empty() const { return _entries.empty(); }
+
+	void clear(){ _entries.clear(); }
+
+private:
+
+	std::vector<Entry> _entries;
+
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "AssetPack.hpp"
+#include "../helpers/Logger.hpp"
+#include <miniz/miniz.h>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+/// Bump the version whenever the layout changes.
+static const uint32_t kAssetPackVersion = 1;
+static const char kAssetPackMagic[4] = { 'G', 'L', 'T', 'P' };
+/// Files data alignment, enough for any attribute or texel type and for SIMD loads.
+static const uint64_t kAssetPackAlignment = 64;
+
+/// File header, followed by the files data, the table of contents and the paths.
+struct AssetPackHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t count;
+	uint64_t entriesOffset;
+	uint64_t stringsOffset;
+	uint64_t stringsSize;
+	uint64_t reserved[3];
+};
+
+static_assert(sizeof(AssetPackHeader) == 64, "Unexpected asset pack header size.");
+static_assert(sizeof(AssetPackEntry) == 48, "Unexpected asset pack entry size.");
+
+
+AssetPack::AssetPack() : _entries(NULL), _strings(NULL), _count(0) {}
+
+AssetPack::~AssetPack(){
+	close();
+}
+
+bool AssetPack::open(const std::string & path){
+	close();
+	if(!_file.open(path)){
+		return false;
+	}
+	AssetPackHeader header;
+	const uint64_t fileSize = _file.size();
+	bool valid = fileSize >= sizeof(AssetPackHeader);
+	if(valid){
+		std::memcpy(&header, _file.data(), sizeof(AssetPackHeader));
+		valid = std::memcmp(header.magic, kAssetPackMagic, 4) == 0 && header.version == kAssetPackVersion
+			&& header.entriesOffset % sizeof(uint64_t) == 0 && header.entriesOffset <= fileSize
+			&& header.count <= (fileSize - header.entriesOffset) / sizeof(AssetPackEntry)
+			&& header.stringsOffset <= fileSize && header.stringsSize <= fileSize - header.stringsOffset;
+	}
+	if(!valid){
+		Log::Error() << Log::Resources << "Invalid asset pack at path \"" << path << "\"." << std::endl;
+		close();
+		return false;
+	}
+	_entries = (const AssetPackEntry *)(_file.data() + header.entriesOffset);
+	_strings = _file.data() + header.stringsOffset;
+	_count = (size_t)header.count;
+
+	// Check that all entries stay in the file, so that accesses don't have to.
+	for(size_t eid = 0; eid < _count; ++eid){
+		const AssetPackEntry & entry = _entries[eid];
+		const bool compressed = (entry.flags & Compressed) != 0;
+		if(entry.offset > fileSize || entry.storedSize > fileSize - entry.offset
+		   || uint64_t(entry.pathOffset) + entry.pathSize > header.stringsSize
+		   || (!compressed && entry.storedSize != entry.size)){
+			Log::Error() << Log::Resources << "Invalid asset pack at path \"" << path << "\"." << std::endl;
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void AssetPack::close(){
+	_file.close();
+	_entries = NULL;
+	_strings = NULL;
+	_count = 0;
+}
+
+std::string AssetPack::path(size_t index) const {
+	return std::string(_strings + _entries[index].pathOffset, _entries[index].pathSize);
+}
+
+long AssetPack::find(const std::string & path) const {
+	// The entries are sorted by path, in byte order.
+	size_t begin = 0;
+	size_t end = _count;
+	while(begin < end){
+		const size_t middle = begin + (end - begin) / 2;
+		const AssetPackEntry & entry = _entries[middle];
+		const int comparison = std::memcmp(_strings + entry.pathOffset, path.c_str(), std::min(size_t(entry.pathSize), path.size()));
+		if(comparison == 0 && entry.pathSize == path.size()){
+			return (long)middle;
+		}
+		if(comparison < 0 || (comparison == 0 && entry.pathSize < path.size())){
+			begin = middle + 1;
+		} else {
+			end = middle;
+		}
+	}
+	return -1;
+}
+
+const char * AssetPack::data(size_t index, size_t & size, char * & buffer) const {
+	const AssetPackEntry & entry = _entries[index];
+	buffer = NULL;
+	size = (size_t)entry.size;
+	if((entry.flags & Compressed) == 0){
+		return _file.data() + entry.offset;
+	}
+	buffer = (char*)malloc(std::max(size, size_t(1)));
+	mz_ulong inflatedSize = (mz_ulong)entry.size;
+	if(buffer == NULL || mz_uncompress((unsigned char*)buffer, &inflatedSize, (const unsigned char*)(_file.data() + entry.offset), (mz_ulong)entry.storedSize) != MZ_OK || inflatedSize != entry.size){
+		Log::Error() << Log::Resources << "Unable to inflate \"" << path(index) << "\" from asset pack." << std::endl;
+		free(buffer);
+		buffer = NULL;
+		size = 0;
+		return NULL;
+	}
+	return buffer;
+}
+
+size_t AssetPack::readahead(size_t index) const {
+	const AssetPackEntry & entry = _entries[index];
+	_file.readahead((size_t)entry.offset, (size_t)entry.storedSize);
+	return (size_t)entry.storedSize;
+}
+
+void AssetPack::stamp(size_t index, SourceStamp & stamp) const {
+	stamp.size = _entries[index].size;
+	stamp.time = _entries[index].hash;
+	stamp.hash = _entries[index].hash;
+}
+
+bool AssetPack::write(const std::string & path, const std::vector<std::pair<std::string, std::string>> & files, const bool compress){
+	// Sort the files by path in the pack, for lookups by binary search.
+	std::vector<std::pair<std::string, std::string>> sortedFiles(files);
+	std::sort(sortedFiles.begin(), sortedFiles.end());
+
+	// Same as the caches, write to a temporary file first.
+	const std::string tempPath = path + ".tmp";
+	std::ofstream outputFile(tempPath, std::ios::binary);
+	if(!outputFile.is_open()){
+		Log::Error() << Log::Resources << "Unable to write asset pack at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	AssetPackHeader header;
+	std::memset(&header, 0, sizeof(AssetPackHeader));
+	outputFile.write((const char *)&header, sizeof(AssetPackHeader));
+
+	std::vector<AssetPackEntry> entries;
+	std::string strings;
+	uint64_t offset = sizeof(AssetPackHeader);
+	const char padding[kAssetPackAlignment] = { 0 };
+	bool success = true;
+	for(size_t fid = 0; fid < sortedFiles.size() && success; ++fid){
+		if(fid > 0 && sortedFiles[fid].first == sortedFiles[fid - 1].first){
+			Log::Error() << Log::Resources << "Duplicate path \"" << sortedFiles[fid].first << "\" in asset pack." << std::endl;
+			success = false;
+			break;
+		}
+		std::ifstream inputFile(sortedFiles[fid].second, std::ios::binary | std::ios::ate);
+		if(!inputFile.is_open()){
+			Log::Error() << Log::Resources << "Unable to read file at path \"" << sortedFiles[fid].second << "\"." << std::endl;
+			success = false;
+			break;
+		}
+		std::vector<char> content((size_t)inputFile.tellg());
+		inputFile.seekg(0, std::ios::beg);
+		inputFile.read(content.data(), content.size());
+		inputFile.close();
+
+		AssetPackEntry entry;
+		std::memset(&entry, 0, sizeof(AssetPackEntry));
+		entry.size = content.size();
+		entry.storedSize = content.size();
+		entry.hash = MeshCache::hash(content.data(), content.size());
+		entry.pathOffset = (uint32_t)strings.size();
+		entry.pathSize = (uint32_t)sortedFiles[fid].first.size();
+		strings += sortedFiles[fid].first;
+
+		// Only keep the deflated version if it is significantly smaller.
+		std::vector<unsigned char> compressed;
+		if(compress && !content.empty()){
+			mz_ulong compressedSize = mz_compressBound((mz_ulong)content.size());
+			compressed.resize(compressedSize);
+			if(mz_compress2(&compressed[0], &compressedSize, (const unsigned char*)content.data(), (mz_ulong)content.size(), MZ_BEST_COMPRESSION) == MZ_OK
+			   && compressedSize < content.size() - content.size() / 8){
+				compressed.resize(compressedSize);
+				entry.flags |= Compressed;
+				entry.storedSize = compressedSize;
+			} else {
+				compressed.clear();
+			}
+		}
+
+		// Align the data.
+		const uint64_t paddingSize = (kAssetPackAlignment - offset % kAssetPackAlignment) % kAssetPackAlignment;
+		outputFile.write(padding, paddingSize);
+		offset += paddingSize;
+		entry.offset = offset;
+		if(entry.flags & Compressed){
+			outputFile.write((const char *)&compressed[0], compressed.size());
+		} else if(!content.empty()){
+			outputFile.write(content.data(), content.size());
+		}
+		offset += entry.storedSize;
+		entries.push_back(entry);
+		success = !outputFile.fail();
+	}
+
+	if(success){
+		// Table of contents and paths.
+		const uint64_t paddingSize = (kAssetPackAlignment - offset % kAssetPackAlignment) % kAssetPackAlignment;
+		outputFile.write(padding, paddingSize);
+		offset += paddingSize;
+		std::memcpy(header.magic, kAssetPackMagic, 4);
+		header.version = kAssetPackVersion;
+		header.count = entries.size();
+		header.entriesOffset = offset;
+		header.stringsOffset = offset + entries.size() * sizeof(AssetPackEntry);
+		header.stringsSize = strings.size();
+		if(!entries.empty()){
+			outputFile.write((const char *)&entries[0], entries.size() * sizeof(AssetPackEntry));
+		}
+		outputFile.write(strings.data(), strings.size());
+		outputFile.seekp(0);
+		outputFile.write((const char *)&header, sizeof(AssetPackHeader));
+		success = !outputFile.fail();
+	}
+	outputFile.close();
+	if(!success){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to write asset pack at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+#ifdef _WIN32
+	std::remove(path.c_str());
+#endif
+	if(std::rename(tempPath.c_str(), path.c_str()) != 0){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to write asset pack at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	return true;
+}
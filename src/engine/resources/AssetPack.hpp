@@ -0,0 +1,83 @@
+#ifndef AssetPack_h
+#define AssetPack_h
+
+#include "MeshCache.hpp"
+#include "MappedFile.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/// Entry of an asset pack table of contents.
+struct AssetPackEntry {
+	uint64_t offset; ///< Position of the stored data in the pack, aligned on 64 bytes.
+	uint64_t storedSize; ///< Size of the stored data.
+	uint64_t size; ///< Size of the original file.
+	uint64_t hash; ///< Hash of the original file content.
+	uint32_t pathOffset; ///< Position of the path in the strings block.
+	uint32_t pathSize;
+	uint32_t flags;
+	uint32_t reserved;
+};
+
+/// Uncompressed asset pack: a header, the files data aligned on 64 bytes, a table of contents sorted by path
+/// and a block of paths. The whole pack is memory-mapped, so that stored files can be used in place.
+/// Files can individually be deflated when it is worth it (text files mostly).
+class AssetPack {
+
+public:
+
+	enum EntryFlags {
+		Compressed = 1
+	};
+
+	AssetPack();
+
+	~AssetPack();
+
+	/// Map a pack file and validate its table of contents. Return false if the file is missing or invalid.
+	bool open(const std::string & path);
+
+	void close();
+
+	bool isOpen() const { return _file.data() != NULL; }
+
+	/// Number of files in the pack.
+	size_t count() const { return _count; }
+
+	/// Path of a file in the pack.
+	std::string path(size_t index) const;
+
+	/// Index of a file in the pack, by binary search on the table of contents. Return -1 if not found.
+	long find(const std::string & path) const;
+
+	/// Access the content of a file. Stored files are returned in place and 'buffer' is set to NULL.
+	/// Compressed files are inflated in 'buffer', to be freed by the caller with free.
+	const char * data(size_t index, size_t & size, char * & buffer) const;
+
+	/// Ask the system to read the stored data of a file in the background, without inflating it. Return the stored size.
+	size_t readahead(size_t index) const;
+
+	/// Size and hash of the original file, the hash being used as the modification time.
+	void stamp(size_t index, SourceStamp & stamp) const;
+
+	/// Build a pack from a list of (path in the pack, path on disk) pairs. Files are deflated if 'compress' is
+	/// enabled and if it saves at least an eighth of their size. Return false on failure.
+	static bool write(const std::string & path, const std::vector<std::pair<std::string, std::string>> & files, const bool compress);
+
+private:
+
+	AssetPack(const AssetPack &);
+
+	AssetPack & operator=(const AssetPack &);
+
+	MappedFile _file;
+
+	const AssetPackEntry * _entries;
+
+	const char * _strings;
+
+	size_t _count;
+
+};
+
+#endif
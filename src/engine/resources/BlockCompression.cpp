@@ -0,0 +1,891 @@
+#include "BlockCompression.hpp"
+#include "TextureCache.hpp"
+
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+/// Interpolation weights of the 4-bit indices of BC7 and BC6H, out of 64.
+static const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/// Largest finite half-float, BC6H unsigned blocks can't represent negative values, infinities or NaNs.
+static const int kMaxHalf = 0x7BFF;
+
+/// Bit stream of a 128-bit block, least significant bit first.
+struct BlockBits {
+	uint64_t words[2];
+	unsigned int position;
+
+	BlockBits() : position(0) {
+		words[0] = words[1] = 0;
+	}
+
+	explicit BlockBits(const unsigned char * src) : position(0) {
+		words[0] = words[1] = 0;
+		for(unsigned int i = 0; i < 16; ++i){
+			words[i / 8] |= uint64_t(src[i]) << (8 * (i % 8));
+		}
+	}
+
+	void write(const uint32_t value, const unsigned int bits){
+		for(unsigned int b = 0; b < bits; ++b, ++position){
+			if((value >> b) & 1){
+				words[position / 64] |= uint64_t(1) << (position % 64);
+			}
+		}
+	}
+
+	uint32_t read(const unsigned int bits){
+		uint32_t value = 0;
+		for(unsigned int b = 0; b < bits; ++b, ++position){
+			value |= uint32_t((words[position / 64] >> (position % 64)) & 1) << b;
+		}
+		return value;
+	}
+
+	void store(unsigned char * dst) const {
+		for(unsigned int i = 0; i < 16; ++i){
+			dst[i] = (unsigned char)(words[i / 8] >> (8 * (i % 8)));
+		}
+	}
+};
+
+/// Mean of the block values and direction of largest variance, through power iterations on the covariance.
+/// The axis is null for uniform blocks.
+template<int N>
+static void principalAxis(const float values[16][N], float mean[N], float axis[N]){
+	for(int c = 0; c < N; ++c){
+		mean[c] = 0.0f;
+		for(int i = 0; i < 16; ++i){
+			mean[c] += values[i][c];
+		}
+		mean[c] /= 16.0f;
+	}
+	float covariance[N][N];
+	for(int c0 = 0; c0 < N; ++c0){
+		for(int c1 = 0; c1 < N; ++c1){
+			float sum = 0.0f;
+			for(int i = 0; i < 16; ++i){
+				sum += (values[i][c0] - mean[c0]) * (values[i][c1] - mean[c1]);
+			}
+			covariance[c0][c1] = sum;
+		}
+	}
+	// Start from the channel with the largest variance.
+	int start = 0;
+	for(int c = 1; c < N; ++c){
+		if(covariance[c][c] > covariance[start][start]){
+			start = c;
+		}
+	}
+	for(int c = 0; c < N; ++c){
+		axis[c] = covariance[start][c];
+	}
+	for(int iteration = 0; iteration < 8; ++iteration){
+		float next[N];
+		float largest = 0.0f;
+		for(int c0 = 0; c0 < N; ++c0){
+			next[c0] = 0.0f;
+			for(int c1 = 0; c1 < N; ++c1){
+				next[c0] += covariance[c0][c1] * axis[c1];
+			}
+			largest = std::max(largest, std::abs(next[c0]));
+		}
+		if(largest < 1e-8f){
+			break;
+		}
+		for(int c = 0; c < N; ++c){
+			axis[c] = next[c] / largest;
+		}
+	}
+	float norm = 0.0f;
+	for(int c = 0; c < N; ++c){
+		norm += axis[c] * axis[c];
+	}
+	norm = std::sqrt(norm);
+	for(int c = 0; c < N; ++c){
+		axis[c] = norm > 1e-8f ? axis[c] / norm : 0.0f;
+	}
+}
+
+/// Endpoints at the extremities of the block values projected on their principal axis, moved inwards by
+/// a fraction of the range as the interpolated colors cover the extremities anyway.
+template<int N>
+static void initialEndpoints(const float values[16][N], const float inset, float e0[N], float e1[N]){
+	float mean[N];
+	float axis[N];
+	principalAxis<N>(values, mean, axis);
+	float minT = FLT_MAX;
+	float maxT = -FLT_MAX;
+	for(int i = 0; i < 16; ++i){
+		float t = 0.0f;
+		for(int c = 0; c < N; ++c){
+			t += (values[i][c] - mean[c]) * axis[c];
+		}
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	const float delta = (maxT - minT) * inset;
+	for(int c = 0; c < N; ++c){
+		e0[c] = mean[c] + axis[c] * (minT + delta);
+		e1[c] = mean[c] + axis[c] * (maxT - delta);
+	}
+}
+
+/// Least squares endpoints for values reconstructed as w * e0 + (1 - w) * e1. Return false if the system is degenerate.
+template<int N>
+static bool fitEndpoints(const float values[16][N], const float weights[16], float e0[N], float e1[N]){
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[N] = {};
+	float bx[N] = {};
+	for(int i = 0; i < 16; ++i){
+		const float a = weights[i];
+		const float b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for(int c = 0; c < N; ++c){
+			ax[c] += a * values[i][c];
+			bx[c] += b * values[i][c];
+		}
+	}
+	const float det = aa * bb - ab * ab;
+	if(std::abs(det) < 1e-4f){
+		return false;
+	}
+	for(int c = 0; c < N; ++c){
+		e0[c] = (ax[c] * bb - bx[c] * ab) / det;
+		e1[c] = (bx[c] * aa - ax[c] * ab) / det;
+	}
+	return true;
+}
+
+static int roundClamp(const float value, const int maximum){
+	return std::min(maximum, std::max(0, int(std::floor(value + 0.5f))));
+}
+
+// BC1 color blocks, also used by BC3.
+
+static uint16_t packRGB565(const float color[3]){
+	const int r = roundClamp(color[0] * 31.0f / 255.0f, 31);
+	const int g = roundClamp(color[1] * 63.0f / 255.0f, 63);
+	const int b = roundClamp(color[2] * 31.0f / 255.0f, 31);
+	return uint16_t((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(const uint16_t value, int color[3]){
+	const int r = (value >> 11) & 31;
+	const int g = (value >> 5) & 63;
+	const int b = value & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+/// Four colors palette, the two endpoints and two thirds.
+static void colorPalette(const uint16_t c0, const uint16_t c1, int palette[4][3]){
+	unpackRGB565(c0, palette[0]);
+	unpackRGB565(c1, palette[1]);
+	for(int c = 0; c < 3; ++c){
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+/// Pick the closest palette entry for each pixel, return the total squared error.
+static int colorIndices(const float values[16][3], const uint16_t c0, const uint16_t c1, unsigned char indices[16]){
+	int palette[4][3];
+	colorPalette(c0, c1, palette);
+	int error = 0;
+	for(int i = 0; i < 16; ++i){
+		int best = INT32_MAX;
+		for(unsigned char p = 0; p < 4; ++p){
+			int distance = 0;
+			for(int c = 0; c < 3; ++c){
+				const int delta = int(values[i][c]) - palette[p][c];
+				distance += delta * delta;
+			}
+			if(distance < best){
+				best = distance;
+				indices[i] = p;
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+static void encodeColorBlock(const unsigned char pixels[16][4], unsigned char * dst){
+	float values[16][3];
+	for(int i = 0; i < 16; ++i){
+		for(int c = 0; c < 3; ++c){
+			values[i][c] = float(pixels[i][c]);
+		}
+	}
+	float e0[3];
+	float e1[3];
+	initialEndpoints<3>(values, 1.0f / 16.0f, e1, e0);
+	uint16_t c0 = packRGB565(e0);
+	uint16_t c1 = packRGB565(e1);
+	unsigned char indices[16];
+	int error = colorIndices(values, c0, c1, indices);
+
+	// Refine the endpoints from the selected indices.
+	static const float kColorWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	for(int iteration = 0; iteration < 2 && error > 0; ++iteration){
+		float weights[16];
+		for(int i = 0; i < 16; ++i){
+			weights[i] = kColorWeights[indices[i]];
+		}
+		if(!fitEndpoints<3>(values, weights, e0, e1)){
+			break;
+		}
+		const uint16_t n0 = packRGB565(e0);
+		const uint16_t n1 = packRGB565(e1);
+		unsigned char newIndices[16];
+		const int newError = colorIndices(values, n0, n1, newIndices);
+		if(newError >= error){
+			break;
+		}
+		c0 = n0;
+		c1 = n1;
+		error = newError;
+		std::memcpy(indices, newIndices, 16);
+	}
+
+	// The four colors mode is only used if the first endpoint is larger.
+	if(c0 < c1){
+		std::swap(c0, c1);
+		for(int i = 0; i < 16; ++i){
+			indices[i] ^= 1;
+		}
+	} else if(c0 == c1){
+		std::memset(indices, 0, 16);
+	}
+	uint32_t bits = 0;
+	for(int i = 0; i < 16; ++i){
+		bits |= uint32_t(indices[i]) << (2 * i);
+	}
+	dst[0] = (unsigned char)(c0 & 0xFF);
+	dst[1] = (unsigned char)(c0 >> 8);
+	dst[2] = (unsigned char)(c1 & 0xFF);
+	dst[3] = (unsigned char)(c1 >> 8);
+	for(int b = 0; b < 4; ++b){
+		dst[4 + b] = (unsigned char)(bits >> (8 * b));
+	}
+}
+
+static void decodeColorBlock(const unsigned char * src, unsigned char pixels[16][4]){
+	const uint16_t c0 = uint16_t(src[0] | (src[1] << 8));
+	const uint16_t c1 = uint16_t(src[2] | (src[3] << 8));
+	int palette[4][3];
+	colorPalette(c0, c1, palette);
+	int alphas[4] = { 255, 255, 255, 255 };
+	if(c0 <= c1){
+		// Three colors mode, with transparent black.
+		for(int c = 0; c < 3; ++c){
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+		alphas[3] = 0;
+	}
+	const uint32_t bits = uint32_t(src[4]) | (uint32_t(src[5]) << 8) | (uint32_t(src[6]) << 16) | (uint32_t(src[7]) << 24);
+	for(int i = 0; i < 16; ++i){
+		const int index = (bits >> (2 * i)) & 3;
+		for(int c = 0; c < 3; ++c){
+			pixels[i][c] = (unsigned char)palette[index][c];
+		}
+		pixels[i][3] = (unsigned char)alphas[index];
+	}
+}
+
+// BC4 single channel blocks, also used by BC3 and BC5.
+
+/// Eight values palette, the two endpoints and six interpolations.
+static void channelPalette(const int v0, const int v1, int palette[8]){
+	palette[0] = v0;
+	palette[1] = v1;
+	for(int i = 2; i < 8; ++i){
+		palette[i] = ((8 - i) * v0 + (i - 1) * v1 + 3) / 7;
+	}
+}
+
+static void encodeChannelBlock(const unsigned char values[16], unsigned char * dst){
+	int minValue = 255;
+	int maxValue = 0;
+	for(int i = 0; i < 16; ++i){
+		minValue = std::min(minValue, int(values[i]));
+		maxValue = std::max(maxValue, int(values[i]));
+	}
+	// The eight values mode requires the first endpoint to be larger.
+	dst[0] = (unsigned char)maxValue;
+	dst[1] = (unsigned char)minValue;
+	uint64_t bits = 0;
+	if(maxValue != minValue){
+		int palette[8];
+		channelPalette(maxValue, minValue, palette);
+		for(int i = 0; i < 16; ++i){
+			int best = INT32_MAX;
+			uint64_t index = 0;
+			for(int p = 0; p < 8; ++p){
+				const int distance = std::abs(int(values[i]) - palette[p]);
+				if(distance < best){
+					best = distance;
+					index = uint64_t(p);
+				}
+			}
+			bits |= index << (3 * i);
+		}
+	}
+	for(int b = 0; b < 6; ++b){
+		dst[2 + b] = (unsigned char)(bits >> (8 * b));
+	}
+}
+
+static void decodeChannelBlock(const unsigned char * src, unsigned char values[16]){
+	const int v0 = src[0];
+	const int v1 = src[1];
+	int palette[8];
+	if(v0 > v1){
+		channelPalette(v0, v1, palette);
+	} else {
+		// Six values mode, with the extremities.
+		palette[0] = v0;
+		palette[1] = v1;
+		for(int i = 2; i < 6; ++i){
+			palette[i] = ((6 - i) * v0 + (i - 1) * v1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	uint64_t bits = 0;
+	for(int b = 0; b < 6; ++b){
+		bits |= uint64_t(src[2 + b]) << (8 * b);
+	}
+	for(int i = 0; i < 16; ++i){
+		values[i] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+	}
+}
+
+// BC7 blocks, mode 6: one subset, RGBA endpoints with 7 bits and a shared lowest bit each, 4-bit indices.
+
+/// Quantize an endpoint, picking the shared bit with the lowest error.
+static void quantizeEndpointBC7(const float endpoint[4], int quantized[4], int & pbit){
+	float bestError = FLT_MAX;
+	for(int p = 0; p < 2; ++p){
+		int candidate[4];
+		float error = 0.0f;
+		for(int c = 0; c < 4; ++c){
+			candidate[c] = roundClamp((endpoint[c] - float(p)) * 0.5f, 127);
+			const float delta = float(candidate[c] * 2 + p) - endpoint[c];
+			error += delta * delta;
+		}
+		if(error < bestError){
+			bestError = error;
+			pbit = p;
+			std::memcpy(quantized, candidate, sizeof(candidate));
+		}
+	}
+}
+
+static void paletteBC7(const int q0[4], const int p0, const int q1[4], const int p1, int palette[16][4]){
+	for(int c = 0; c < 4; ++c){
+		const int v0 = q0[c] * 2 + p0;
+		const int v1 = q1[c] * 2 + p1;
+		for(int i = 0; i < 16; ++i){
+			palette[i][c] = ((64 - kWeights4[i]) * v0 + kWeights4[i] * v1 + 32) >> 6;
+		}
+	}
+}
+
+static int indicesBC7(const float values[16][4], const int palette[16][4], unsigned char indices[16]){
+	int error = 0;
+	for(int i = 0; i < 16; ++i){
+		int best = INT32_MAX;
+		for(unsigned char p = 0; p < 16; ++p){
+			int distance = 0;
+			for(int c = 0; c < 4; ++c){
+				const int delta = int(values[i][c]) - palette[p][c];
+				distance += delta * delta;
+			}
+			if(distance < best){
+				best = distance;
+				indices[i] = p;
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+static void encodeBC7(const unsigned char pixels[16][4], unsigned char * dst){
+	float values[16][4];
+	for(int i = 0; i < 16; ++i){
+		for(int c = 0; c < 4; ++c){
+			values[i][c] = float(pixels[i][c]);
+		}
+	}
+	float e0[4];
+	float e1[4];
+	initialEndpoints<4>(values, 1.0f / 32.0f, e0, e1);
+	int q0[4], q1[4];
+	int p0 = 0, p1 = 0;
+	quantizeEndpointBC7(e0, q0, p0);
+	quantizeEndpointBC7(e1, q1, p1);
+	int palette[16][4];
+	paletteBC7(q0, p0, q1, p1, palette);
+	unsigned char indices[16];
+	int error = indicesBC7(values, palette, indices);
+
+	for(int iteration = 0; iteration < 2 && error > 0; ++iteration){
+		float weights[16];
+		for(int i = 0; i < 16; ++i){
+			weights[i] = float(64 - kWeights4[indices[i]]) / 64.0f;
+		}
+		if(!fitEndpoints<4>(values, weights, e0, e1)){
+			break;
+		}
+		int n0[4], n1[4];
+		int np0 = 0, np1 = 0;
+		quantizeEndpointBC7(e0, n0, np0);
+		quantizeEndpointBC7(e1, n1, np1);
+		paletteBC7(n0, np0, n1, np1, palette);
+		unsigned char newIndices[16];
+		const int newError = indicesBC7(values, palette, newIndices);
+		if(newError >= error){
+			break;
+		}
+		std::memcpy(q0, n0, sizeof(q0));
+		std::memcpy(q1, n1, sizeof(q1));
+		p0 = np0;
+		p1 = np1;
+		error = newError;
+		std::memcpy(indices, newIndices, 16);
+	}
+
+	// The first index is stored without its highest bit, swap the endpoints if needed.
+	if(indices[0] >= 8){
+		std::swap(q0, q1);
+		std::swap(p0, p1);
+		for(int i = 0; i < 16; ++i){
+			indices[i] = (unsigned char)(15 - indices[i]);
+		}
+	}
+	BlockBits bits;
+	bits.write(1 << 6, 7);
+	for(int c = 0; c < 4; ++c){
+		bits.write(uint32_t(q0[c]), 7);
+		bits.write(uint32_t(q1[c]), 7);
+	}
+	bits.write(uint32_t(p0), 1);
+	bits.write(uint32_t(p1), 1);
+	for(int i = 0; i < 16; ++i){
+		bits.write(indices[i], i == 0 ? 3 : 4);
+	}
+	bits.store(dst);
+}
+
+static void decodeBC7(const unsigned char * src, unsigned char pixels[16][4]){
+	BlockBits bits(src);
+	if(bits.read(7) != (1 << 6)){
+		// Other modes are never produced.
+		std::memset(pixels, 0, 16 * 4);
+		return;
+	}
+	int q0[4], q1[4];
+	for(int c = 0; c < 4; ++c){
+		q0[c] = int(bits.read(7));
+		q1[c] = int(bits.read(7));
+	}
+	const int p0 = int(bits.read(1));
+	const int p1 = int(bits.read(1));
+	int palette[16][4];
+	paletteBC7(q0, p0, q1, p1, palette);
+	for(int i = 0; i < 16; ++i){
+		const uint32_t index = bits.read(i == 0 ? 3 : 4);
+		for(int c = 0; c < 4; ++c){
+			pixels[i][c] = (unsigned char)palette[index][c];
+		}
+	}
+}
+
+// BC6H unsigned blocks, mode 11: one subset, RGB endpoints with 10 bits, 4-bit indices.
+// Values are processed in the endpoints domain, where half-floats bits are scaled by 64/31.
+
+static int unquantizeBC6H(const int value){
+	if(value == 0){
+		return 0;
+	}
+	if(value == 1023){
+		return 0xFFFF;
+	}
+	return (value << 6) + 32;
+}
+
+static void quantizeEndpointBC6H(const float endpoint[3], int quantized[3]){
+	for(int c = 0; c < 3; ++c){
+		quantized[c] = roundClamp((endpoint[c] - 32.0f) / 64.0f, 1023);
+	}
+}
+
+/// Palette as half-float bits.
+static void paletteBC6H(const int q0[3], const int q1[3], int palette[16][3]){
+	for(int c = 0; c < 3; ++c){
+		const int v0 = unquantizeBC6H(q0[c]);
+		const int v1 = unquantizeBC6H(q1[c]);
+		for(int i = 0; i < 16; ++i){
+			const int value = ((64 - kWeights4[i]) * v0 + kWeights4[i] * v1 + 32) >> 6;
+			palette[i][c] = (value * 31) >> 6;
+		}
+	}
+}
+
+static float indicesBC6H(const int halfs[16][3], const int palette[16][3], unsigned char indices[16]){
+	float error = 0.0f;
+	for(int i = 0; i < 16; ++i){
+		float best = FLT_MAX;
+		for(unsigned char p = 0; p < 16; ++p){
+			float distance = 0.0f;
+			for(int c = 0; c < 3; ++c){
+				const float delta = float(halfs[i][c] - palette[p][c]);
+				distance += delta * delta;
+			}
+			if(distance < best){
+				best = distance;
+				indices[i] = p;
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+static void encodeBC6H(const uint16_t pixels[16][3], unsigned char * dst){
+	int halfs[16][3];
+	float values[16][3];
+	for(int i = 0; i < 16; ++i){
+		for(int c = 0; c < 3; ++c){
+			const int value = pixels[i][c];
+			// Negative values are clamped to zero, infinities and NaNs to the largest value.
+			halfs[i][c] = (value & 0x8000) ? 0 : std::min(value, kMaxHalf);
+			values[i][c] = float(halfs[i][c]) * 64.0f / 31.0f;
+		}
+	}
+	float e0[3];
+	float e1[3];
+	initialEndpoints<3>(values, 1.0f / 32.0f, e0, e1);
+	int q0[3], q1[3];
+	quantizeEndpointBC6H(e0, q0);
+	quantizeEndpointBC6H(e1, q1);
+	int palette[16][3];
+	paletteBC6H(q0, q1, palette);
+	unsigned char indices[16];
+	float error = indicesBC6H(halfs, palette, indices);
+
+	for(int iteration = 0; iteration < 2 && error > 0.0f; ++iteration){
+		float weights[16];
+		for(int i = 0; i < 16; ++i){
+			weights[i] = float(64 - kWeights4[indices[i]]) / 64.0f;
+		}
+		if(!fitEndpoints<3>(values, weights, e0, e1)){
+			break;
+		}
+		int n0[3], n1[3];
+		quantizeEndpointBC6H(e0, n0);
+		quantizeEndpointBC6H(e1, n1);
+		paletteBC6H(n0, n1, palette);
+		unsigned char newIndices[16];
+		const float newError = indicesBC6H(halfs, palette, newIndices);
+		if(newError >= error){
+			break;
+		}
+		std::memcpy(q0, n0, sizeof(q0));
+		std::memcpy(q1, n1, sizeof(q1));
+		error = newError;
+		std::memcpy(indices, newIndices, 16);
+	}
+
+	if(indices[0] >= 8){
+		std::swap(q0, q1);
+		for(int i = 0; i < 16; ++i){
+			indices[i] = (unsigned char)(15 - indices[i]);
+		}
+	}
+	BlockBits bits;
+	bits.write(0x03, 5);
+	for(int c = 0; c < 3; ++c){
+		bits.write(uint32_t(q0[c]), 10);
+	}
+	for(int c = 0; c < 3; ++c){
+		bits.write(uint32_t(q1[c]), 10);
+	}
+	for(int i = 0; i < 16; ++i){
+		bits.write(indices[i], i == 0 ? 3 : 4);
+	}
+	bits.store(dst);
+}
+
+static void decodeBC6H(const unsigned char * src, uint16_t pixels[16][3]){
+	BlockBits bits(src);
+	if(bits.read(5) != 0x03){
+		std::memset(pixels, 0, 16 * 3 * sizeof(uint16_t));
+		return;
+	}
+	int q0[3], q1[3];
+	for(int c = 0; c < 3; ++c){
+		q0[c] = int(bits.read(10));
+	}
+	for(int c = 0; c < 3; ++c){
+		q1[c] = int(bits.read(10));
+	}
+	int palette[16][3];
+	paletteBC6H(q0, q1, palette);
+	for(int i = 0; i < 16; ++i){
+		const uint32_t index = bits.read(i == 0 ? 3 : 4);
+		for(int c = 0; c < 3; ++c){
+			pixels[i][c] = uint16_t(palette[index][c]);
+		}
+	}
+}
+
+// Blocks access.
+
+/// Gather the pixels of a block as RGBA8, repeating the last row and column of partial blocks.
+static void loadBlockLDR(const ImageView & image, const unsigned char * data, const unsigned int width, const unsigned int height, const unsigned int bx, const unsigned int by, unsigned char pixels[16][4]){
+	const unsigned int channels = image.channels;
+	for(unsigned int y = 0; y < 4; ++y){
+		const size_t py = std::min(by * 4 + y, height - 1);
+		for(unsigned int x = 0; x < 4; ++x){
+			const size_t px = std::min(bx * 4 + x, width - 1);
+			const unsigned char * pixel = data + (py * width + px) * channels;
+			unsigned char * block = pixels[y * 4 + x];
+			for(unsigned int c = 0; c < 4; ++c){
+				block[c] = c < channels ? pixel[c] : (c == 3 ? 255 : 0);
+			}
+		}
+	}
+}
+
+/// Gather the pixels of a block as RGB half-floats.
+static void loadBlockHDR(const ImageView & image, const void * data, const unsigned int width, const unsigned int height, const unsigned int bx, const unsigned int by, uint16_t pixels[16][3]){
+	const unsigned int channels = image.channels;
+	for(unsigned int y = 0; y < 4; ++y){
+		const size_t py = std::min(by * 4 + y, height - 1);
+		for(unsigned int x = 0; x < 4; ++x){
+			const size_t px = std::min(bx * 4 + x, width - 1);
+			const size_t offset = (py * width + px) * channels;
+			uint16_t * block = pixels[y * 4 + x];
+			for(unsigned int c = 0; c < 3; ++c){
+				if(c >= channels){
+					block[c] = 0;
+				} else if(image.half){
+					block[c] = ((const uint16_t *)data)[offset + c];
+				} else {
+					block[c] = glm::packHalf1x16(((const float *)data)[offset + c]);
+				}
+			}
+		}
+	}
+}
+
+static void encodeBlock(const unsigned char pixels[16][4], const BlockCompression::Format format, unsigned char * dst){
+	unsigned char channel[16];
+	switch(format){
+		case BlockCompression::BC1:
+			encodeColorBlock(pixels, dst);
+			break;
+		case BlockCompression::BC3:
+			for(int i = 0; i < 16; ++i){
+				channel[i] = pixels[i][3];
+			}
+			encodeChannelBlock(channel, dst);
+			encodeColorBlock(pixels, dst + 8);
+			break;
+		case BlockCompression::BC4:
+		case BlockCompression::BC5:
+			for(int i = 0; i < 16; ++i){
+				channel[i] = pixels[i][0];
+			}
+			encodeChannelBlock(channel, dst);
+			if(format == BlockCompression::BC5){
+				for(int i = 0; i < 16; ++i){
+					channel[i] = pixels[i][1];
+				}
+				encodeChannelBlock(channel, dst + 8);
+			}
+			break;
+		case BlockCompression::BC7:
+			encodeBC7(pixels, dst);
+			break;
+		default:
+			break;
+	}
+}
+
+static void decodeBlock(const unsigned char * src, const BlockCompression::Format format, unsigned char pixels[16][4]){
+	unsigned char channel[16];
+	switch(format){
+		case BlockCompression::BC1:
+			decodeColorBlock(src, pixels);
+			break;
+		case BlockCompression::BC3:
+			decodeColorBlock(src + 8, pixels);
+			decodeChannelBlock(src, channel);
+			for(int i = 0; i < 16; ++i){
+				pixels[i][3] = channel[i];
+			}
+			break;
+		case BlockCompression::BC4:
+		case BlockCompression::BC5:
+			decodeChannelBlock(src, channel);
+			for(int i = 0; i < 16; ++i){
+				pixels[i][0] = channel[i];
+				pixels[i][1] = 0;
+				pixels[i][2] = 0;
+				pixels[i][3] = 255;
+			}
+			if(format == BlockCompression::BC5){
+				decodeChannelBlock(src + 8, channel);
+				for(int i = 0; i < 16; ++i){
+					pixels[i][1] = channel[i];
+				}
+			}
+			break;
+		case BlockCompression::BC7:
+			decodeBC7(src, pixels);
+			break;
+		default:
+			break;
+	}
+}
+
+
+size_t BlockCompression::blockSize(const Format format){
+	switch(format){
+		case BC1:
+		case BC4:
+			return 8;
+		case BC3:
+		case BC5:
+		case BC6H:
+		case BC7:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+size_t BlockCompression::imageSize(const Format format, const unsigned int width, const unsigned int height){
+	const size_t blocksX = (std::max(1u, width) + 3) / 4;
+	const size_t blocksY = (std::max(1u, height) + 3) / 4;
+	return blocksX * blocksY * blockSize(format);
+}
+
+BlockCompression::Format BlockCompression::chooseFormat(const ImageView & image, const bool color, const bool normalMap){
+	if(image.compression != None || image.levels.empty()){
+		return None;
+	}
+	if(image.hdr){
+		return BC6H;
+	}
+	if(normalMap){
+		return BC5;
+	}
+	const unsigned char * pixels = (const unsigned char *)image.levels[0];
+	const size_t count = size_t(image.width) * size_t(image.height);
+	const unsigned int channels = image.channels;
+	bool opaque = true;
+	bool grey = true;
+	for(size_t pid = 0; pid < count && (opaque || grey); ++pid){
+		const unsigned char * pixel = pixels + pid * channels;
+		opaque = opaque && (channels < 4 || pixel[3] == 255);
+		grey = grey && (channels < 3 || (pixel[0] == pixel[1] && pixel[0] == pixel[2]));
+	}
+	if(color){
+		return opaque ? BC1 : BC3;
+	}
+	return (grey && opaque) ? BC4 : BC7;
+}
+
+void BlockCompression::encode(const ImageView & image, const unsigned int level, const Format format, const unsigned int threads, unsigned char * dst){
+	if(format == None || level >= image.levels.size()){
+		return;
+	}
+	const unsigned int width = std::max(1u, image.width >> level);
+	const unsigned int height = std::max(1u, image.height >> level);
+	const unsigned int blocksX = (width + 3) / 4;
+	const unsigned int blocksY = (height + 3) / 4;
+	const size_t rowSize = blocksX * blockSize(format);
+	const void * data = image.levels[level];
+	std::atomic<unsigned int> nextRow(0);
+	// Rows of blocks all have the same cost, distribute them in order.
+	auto encode = [&](){
+		for(unsigned int by = nextRow++; by < blocksY; by = nextRow++){
+			unsigned char * row = dst + by * rowSize;
+			for(unsigned int bx = 0; bx < blocksX; ++bx){
+				unsigned char * block = row + bx * blockSize(format);
+				if(format == BC6H){
+					uint16_t pixels[16][3];
+					loadBlockHDR(image, data, width, height, bx, by, pixels);
+					encodeBC6H(pixels, block);
+				} else {
+					unsigned char pixels[16][4];
+					loadBlockLDR(image, (const unsigned char *)data, width, height, bx, by, pixels);
+					encodeBlock(pixels, format, block);
+				}
+			}
+		}
+	};
+	const unsigned int threadsCount = std::min(std::max(1u, threads), blocksY);
+	std::vector<std::thread> workers;
+	for(unsigned int tid = 1; tid < threadsCount; ++tid){
+		workers.emplace_back(encode);
+	}
+	encode();
+	for(auto & worker : workers){
+		worker.join();
+	}
+}
+
+void BlockCompression::decode(const unsigned char * blocks, const Format format, const unsigned int width, const unsigned int height, void * dst){
+	if(format == None){
+		return;
+	}
+	const unsigned int blocksX = (width + 3) / 4;
+	const unsigned int blocksY = (height + 3) / 4;
+	const unsigned int channels = format == BC6H ? 3 : 4;
+	const size_t channelSize = format == BC6H ? sizeof(uint16_t) : sizeof(unsigned char);
+	for(unsigned int by = 0; by < blocksY; ++by){
+		for(unsigned int bx = 0; bx < blocksX; ++bx){
+			const unsigned char * block = blocks + (by * blocksX + bx) * blockSize(format);
+			unsigned char pixels[16][4];
+			uint16_t halfs[16][3];
+			const unsigned char * decoded;
+			if(format == BC6H){
+				decodeBC6H(block, halfs);
+				decoded = (const unsigned char *)halfs;
+			} else {
+				decodeBlock(block, format, pixels);
+				decoded = (const unsigned char *)pixels;
+			}
+			// Skip the pixels outside of the image.
+			const size_t pixelSize = channels * channelSize;
+			for(unsigned int y = 0; y < 4 && by * 4 + y < height; ++y){
+				const unsigned int count = std::min(4u, width - bx * 4);
+				unsigned char * row = (unsigned char *)dst + ((size_t)(by * 4 + y) * width + bx * 4) * pixelSize;
+				std::memcpy(row, decoded + y * 4 * pixelSize, count * pixelSize);
+			}
+		}
+	}
+}
+
+const char * BlockCompression::name(const Format format){
+	static const char * names[] = { "none", "BC1", "BC3", "BC4", "BC5", "BC6H", "BC7" };
+	return names[format];
+}
@@ -0,0 +1,42 @@
+#ifndef BlockCompression_h
+#define BlockCompression_h
+
+#include <cstddef>
+
+struct ImageView;
+
+/// CPU encoders for the GPU block compressed formats, storing each 4x4 block of pixels in 8 or 16 bytes.
+/// LDR images use BC1 (opaque colors), BC3 (colors with alpha), BC4 (one channel), BC5 (two channels, for
+/// normal maps) or BC7 (four channels, higher quality). HDR images use BC6H (unsigned). BC7 and BC6H blocks
+/// are encoded with a single subset mode (mode 6 and mode 11 respectively).
+class BlockCompression {
+
+public:
+
+	enum Format {
+		None, BC1, BC3, BC4, BC5, BC6H, BC7
+	};
+
+	/// Bytes used by a 4x4 block.
+	static size_t blockSize(const Format format);
+
+	/// Bytes used by an image of the given size, partial blocks included.
+	static size_t imageSize(const Format format, const unsigned int width, const unsigned int height);
+
+	/// Format suited to an uncompressed image: BC6H for HDR images, BC5 for normal maps, BC1 or BC3 for
+	/// colors depending on their alpha, BC4 for grey data and BC7 for other data.
+	static Format chooseFormat(const ImageView & image, const bool color, const bool normalMap);
+
+	/// Encode a level of an uncompressed image, splitting the rows of blocks between threads. The destination
+	/// should hold imageSize bytes. The result doesn't depend on the number of threads.
+	static void encode(const ImageView & image, const unsigned int level, const Format format, const unsigned int threads, unsigned char * dst);
+
+	/// Decode blocks produced by encode, to RGBA8 pixels or to RGB half-floats for BC6H. Missing channels are
+	/// set as when sampling the texture: 0 for green and blue, opaque alpha.
+	static void decode(const unsigned char * blocks, const Format format, const unsigned int width, const unsigned int height, void * dst);
+
+	static const char * name(const Format format);
+
+};
+
+#endif
@@ -0,0 +1,237 @@
+#include "ByteSource.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+char * ByteSource::readAll(){
+	if(_size == 0){
+		return NULL;
+	}
+	char * buffer = (char*)malloc(_size);
+	if(buffer == NULL){
+		return NULL;
+	}
+	if(read(0, _size, buffer) != _size){
+		free(buffer);
+		return NULL;
+	}
+	return buffer;
+}
+
+std::unique_ptr<ByteSource> ByteSource::open(const std::string & path){
+	// Mapping fails on empty files and some file systems, read them instead.
+	std::unique_ptr<MappedSource> mapped(new MappedSource());
+	if(mapped->open(path)){
+		return std::unique_ptr<ByteSource>(mapped.release());
+	}
+	std::unique_ptr<FileSource> file(new FileSource());
+	if(file->open(path)){
+		return std::unique_ptr<ByteSource>(file.release());
+	}
+	return std::unique_ptr<ByteSource>();
+}
+
+/// File source.
+
+#ifdef _WIN32
+
+FileSource::FileSource() : _file(INVALID_HANDLE_VALUE) { }
+
+FileSource::~FileSource(){
+	if(_file != INVALID_HANDLE_VALUE){
+		CloseHandle(_file);
+	}
+}
+
+bool FileSource::open(const std::string & path){
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE){
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize)){
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+size_t FileSource::read(const size_t offset, const size_t count, char * dst){
+	size_t done = 0;
+	const size_t total = offset < _size ? std::min(count, _size - offset) : 0;
+	while(done < total){
+		// Positioned read, without changing the file pointer used by other readers.
+		OVERLAPPED overlapped = {};
+		const uint64_t position = offset + done;
+		overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+		DWORD readCount = 0;
+		const DWORD chunk = (DWORD)std::min(total - done, size_t(1) << 30);
+		if(!ReadFile(_file, dst + done, chunk, &readCount, &overlapped) || readCount == 0){
+			break;
+		}
+		done += readCount;
+	}
+	return done;
+}
+
+void FileSource::readahead(const size_t, const size_t){
+	// The system prefetches sequential reads.
+}
+
+#else
+
+FileSource::FileSource() : _file(-1) { }
+
+FileSource::~FileSource(){
+	if(_file >= 0){
+		::close(_file);
+	}
+}
+
+bool FileSource::open(const std::string & path){
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if(file < 0){
+		return false;
+	}
+	struct stat fileStat;
+	if(fstat(file, &fileStat) != 0){
+		::close(file);
+		return false;
+	}
+	_file = file;
+	_size = (size_t)fileStat.st_size;
+	return true;
+}
+
+size_t FileSource::read(const size_t offset, const size_t count, char * dst){
+	size_t done = 0;
+	const size_t total = offset < _size ? std::min(count, _size - offset) : 0;
+	while(done < total){
+		const ssize_t readCount = pread(_file, dst + done, total - done, (off_t)(offset + done));
+		if(readCount <= 0){
+			break;
+		}
+		done += (size_t)readCount;
+	}
+	return done;
+}
+
+void FileSource::readahead(const size_t offset, const size_t count){
+#ifdef POSIX_FADV_WILLNEED
+	posix_fadvise(_file, (off_t)offset, (off_t)count, POSIX_FADV_WILLNEED);
+#else
+	(void)offset; (void)count;
+#endif
+}
+
+#endif
+
+/// Mapped source.
+
+bool MappedSource::open(const std::string & path){
+	if(!_file.open(path)){
+		return false;
+	}
+	_size = _file.size();
+	return true;
+}
+
+size_t MappedSource::read(const size_t offset, const size_t count, char * dst){
+	const size_t total = offset < _size ? std::min(count, _size - offset) : 0;
+	std::memcpy(dst, _file.data() + offset, total);
+	return total;
+}
+
+void MappedSource::readahead(const size_t offset, const size_t count){
+	_file.readahead(offset, count);
+}
+
+/// Memory source.
+
+MemorySource::MemorySource(const char * data, const size_t size, char * owned) : _data(data), _owned(owned) {
+	_size = size;
+}
+
+MemorySource::~MemorySource(){
+	free(_owned);
+}
+
+size_t MemorySource::read(const size_t offset, const size_t count, char * dst){
+	const size_t total = offset < _size ? std::min(count, _size - offset) : 0;
+	std::memcpy(dst, _data + offset, total);
+	return total;
+}
+
+/// Zip source.
+
+ZipSource::ZipSource(mz_zip_archive * archive, const unsigned int index, std::mutex & mutex) : _archive(archive), _index(index), _mutex(mutex), _state(NULL), _position(0) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	mz_zip_archive_file_stat fileStat;
+	if(!mz_zip_reader_file_stat(_archive, _index, &fileStat)){
+		return;
+	}
+	_size = (size_t)fileStat.m_uncomp_size;
+	_state = mz_zip_reader_extract_iter_new(_archive, _index, 0);
+}
+
+ZipSource::~ZipSource(){
+	if(_state != NULL){
+		std::lock_guard<std::mutex> lock(_mutex);
+		mz_zip_reader_extract_iter_free(_state);
+	}
+}
+
+void ZipSource::restart(){
+	if(_state != NULL){
+		mz_zip_reader_extract_iter_free(_state);
+	}
+	_state = mz_zip_reader_extract_iter_new(_archive, _index, 0);
+	_position = 0;
+}
+
+size_t ZipSource::read(const size_t offset, const size_t count, char * dst){
+	if(_state == NULL || offset >= _size){
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	// Entries can only be decompressed forward.
+	if(offset < _position){
+		restart();
+		if(_state == NULL){
+			return 0;
+		}
+	}
+	char skipped[4096];
+	while(_position < offset){
+		const size_t readCount = mz_zip_reader_extract_iter_read(_state, skipped, std::min(sizeof(skipped), offset - _position));
+		if(readCount == 0){
+			return 0;
+		}
+		_position += readCount;
+	}
+	const size_t total = std::min(count, _size - offset);
+	size_t done = 0;
+	while(done < total){
+		const size_t readCount = mz_zip_reader_extract_iter_read(_state, dst + done, total - done);
+		if(readCount == 0){
+			break;
+		}
+		done += readCount;
+	}
+	_position += done;
+	return done;
+}
@@ -0,0 +1,148 @@
+#ifndef ByteSource_h
+#define ByteSource_h
+
+#include "MappedFile.hpp"
+#include <miniz/miniz.h>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+/// Read-only content of a resource file, accessed by ranges whatever its storage, so that decoders
+/// don't need the whole file in memory at once. A source is used by one thread at a time.
+class ByteSource {
+
+public:
+
+	virtual ~ByteSource(){}
+
+	size_t size() const { return _size; }
+
+	/// Copy the range [offset, offset+count[ (clamped to the size) to 'dst'. Return the number of bytes copied.
+	virtual size_t read(const size_t offset, const size_t count, char * dst) = 0;
+
+	/// Whole content if it is already in memory, NULL otherwise.
+	virtual const char * data() const { return NULL; }
+
+	/// Hint that a range is going to be read soon, so that it can be fetched in the background.
+	virtual void readahead(const size_t offset, const size_t count){ (void)offset; (void)count; }
+
+	/// Copy the whole content to a buffer allocated with malloc, that the caller has to free. NULL on failure.
+	char * readAll();
+
+	/// Open a file on disk, mapped in memory if possible, else read by ranges. NULL on failure.
+	static std::unique_ptr<ByteSource> open(const std::string & path);
+
+protected:
+
+	ByteSource() : _size(0) {}
+
+	size_t _size;
+
+private:
+
+	ByteSource(const ByteSource &);
+
+	ByteSource & operator= (const ByteSource &);
+
+};
+
+/// File on disk, read with positioned reads.
+class FileSource : public ByteSource {
+
+public:
+
+	FileSource();
+
+	~FileSource();
+
+	bool open(const std::string & path);
+
+	size_t read(const size_t offset, const size_t count, char * dst);
+
+	void readahead(const size_t offset, const size_t count);
+
+private:
+
+#ifdef _WIN32
+	void * _file;
+#else
+	int _file;
+#endif
+
+};
+
+/// File on disk mapped in memory, paged in by the system on access.
+class MappedSource : public ByteSource {
+
+public:
+
+	bool open(const std::string & path);
+
+	size_t read(const size_t offset, const size_t count, char * dst);
+
+	const char * data() const { return _file.data(); }
+
+	void readahead(const size_t offset, const size_t count);
+
+private:
+
+	MappedFile _file;
+
+};
+
+/// Content already in memory, for instance an asset pack entry. Frees the owned buffer if any.
+class MemorySource : public ByteSource {
+
+public:
+
+	/// 'owned' is either NULL or the buffer containing 'data', allocated with malloc.
+	MemorySource(const char * data, const size_t size, char * owned);
+
+	~MemorySource();
+
+	size_t read(const size_t offset, const size_t count, char * dst);
+
+	const char * data() const { return _data; }
+
+private:
+
+	const char * _data;
+
+	char * _owned;
+
+};
+
+/// Entry of a zip archive, decompressed progressively. Reading before the current position restarts the decompression.
+class ZipSource : public ByteSource {
+
+public:
+
+	/// The archive is shared, and only accessed while holding 'mutex'.
+	ZipSource(mz_zip_archive * archive, const unsigned int index, std::mutex & mutex);
+
+	~ZipSource();
+
+	/// Did the entry open successfully.
+	bool valid() const { return _state != NULL; }
+
+	size_t read(const size_t offset, const size_t count, char * dst);
+
+private:
+
+	void restart();
+
+	mz_zip_archive * _archive;
+
+	unsigned int _index;
+
+	std::mutex & _mutex;
+
+	mz_zip_reader_extract_iter_state * _state;
+
+	/// Offset of the next decompressed byte.
+	size_t _position;
+
+};
+
+#endif
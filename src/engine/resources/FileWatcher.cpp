@@ -0,0 +1,140 @@
+#include "FileWatcher.hpp"
+#include "ResourcesManager.hpp"
+#include "../helpers/Logger.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/// Minimum delay between two scans when polling.
+static const std::chrono::milliseconds kScanInterval(500);
+
+FileWatcher::FileWatcher() : _notifier(-1) {
+#ifdef __linux__
+	_notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(_notifier < 0){
+		Log::Warning() << Log::Resources << "Unable to create a file notifier, polling files instead." << std::endl;
+	}
+#endif
+}
+
+FileWatcher::~FileWatcher(){
+#ifdef __linux__
+	if(_notifier >= 0){
+		close(_notifier);
+	}
+#endif
+}
+
+bool FileWatcher::watch(const std::string & root){
+	_root = root;
+#ifdef __linux__
+	if(_notifier >= 0){
+		DIR * dir = opendir(root.c_str());
+		if(dir == NULL){
+			Log::Error() << Log::Resources << "Unable to watch directory at path \"" << root << "\"." << std::endl;
+			return false;
+		}
+		closedir(dir);
+		addDirectory(root, NULL);
+		return true;
+	}
+#endif
+	// Reference stamps, nothing is reported for the existing files.
+	std::vector<std::string> paths;
+	scan(paths);
+	return true;
+}
+
+void FileWatcher::addDirectory(const std::string & path, std::vector<std::string> * files){
+#ifdef __linux__
+	// Files can be replaced by saving to a temporary file and moving it.
+	const int wd = inotify_add_watch(_notifier, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if(wd < 0){
+		Log::Error() << Log::Resources << "Unable to watch directory at path \"" << path << "\"." << std::endl;
+		return;
+	}
+	_directories[wd] = path;
+	DIR * dir = opendir(path.c_str());
+	if(dir == NULL){
+		return;
+	}
+	while(struct dirent * entry = readdir(dir)){
+		const std::string name(entry->d_name);
+		if(entry->d_type == DT_DIR && name != "." && name != ".."){
+			addDirectory(path + "/" + name, files);
+		} else if(files != NULL && entry->d_type == DT_REG && name[0] != '.'){
+			files->push_back(path + "/" + name);
+		}
+	}
+	closedir(dir);
+#endif
+}
+
+void FileWatcher::changes(std::vector<std::string> & paths){
+	const size_t first = paths.size();
+#ifdef __linux__
+	if(_notifier >= 0){
+		alignas(struct inotify_event) char buffer[4096];
+		while(true){
+			const ssize_t length = read(_notifier, buffer, sizeof(buffer));
+			if(length <= 0){
+				break;
+			}
+			for(ssize_t offset = 0; offset < length;){
+				const struct inotify_event * event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+				offset += sizeof(struct inotify_event) + event->len;
+				const auto directory = _directories.find(event->wd);
+				if(event->len == 0 || directory == _directories.end()){
+					continue;
+				}
+				const std::string name(event->name);
+				const std::string path = directory->second + "/" + name;
+				if(event->mask & IN_ISDIR){
+					// Files already written in a new directory are reported when it is registered.
+					if(event->mask & (IN_CREATE | IN_MOVED_TO)){
+						addDirectory(path, &paths);
+					}
+					continue;
+				}
+				// A created file is reported once written and closed.
+				if((event->mask & IN_CREATE) || name.empty() || name[0] == '.'){
+					continue;
+				}
+				paths.push_back(path);
+			}
+		}
+	}
+#endif
+	if(_notifier < 0){
+		const auto now = std::chrono::steady_clock::now();
+		if(now - _lastScan >= kScanInterval){
+			scan(paths);
+		}
+	}
+	// Editors can write the same file multiple times.
+	std::sort(paths.begin() + first, paths.end());
+	paths.erase(std::unique(paths.begin() + first, paths.end()), paths.end());
+}
+
+void FileWatcher::scan(std::vector<std::string> & paths){
+	const bool first = _lastScan == std::chrono::steady_clock::time_point();
+	_lastScan = std::chrono::steady_clock::now();
+	std::vector<std::string> files;
+	Resources::listFiles(_root, files);
+	for(const auto & file : files){
+		SourceStamp stamp;
+		if(!Resources::getExternalFileStamp(file, stamp)){
+			continue;
+		}
+		SourceStamp & previous = _stamps[file];
+		if(!first && (previous.size != stamp.size || previous.time != stamp.time)){
+			paths.push_back(file);
+		}
+		previous = stamp;
+	}
+}
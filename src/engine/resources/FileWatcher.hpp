@@ -0,0 +1,55 @@
+#ifndef FileWatcher_h
+#define FileWatcher_h
+
+#include "MeshCache.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+/// Report the files modified or created in a directory hierarchy.
+/// Uses inotify on Linux, and falls back to periodically comparing the files stamps elsewhere or if it is unavailable.
+class FileWatcher {
+
+public:
+
+	FileWatcher();
+
+	~FileWatcher();
+
+	/// Start watching a directory and all its subdirectories. Return false if it can't be listed.
+	bool watch(const std::string & root);
+
+	/// Append the paths of the files written since the last call, each path once. Never blocks.
+	void changes(std::vector<std::string> & paths);
+
+	/// Is the fallback polling used.
+	bool polling() const { return _notifier < 0; }
+
+private:
+
+	FileWatcher(const FileWatcher &);
+
+	FileWatcher & operator= (const FileWatcher &);
+
+	/// Register a directory and its subdirectories with the notifier, listing their files if requested.
+	void addDirectory(const std::string & path, std::vector<std::string> * files);
+
+	/// List all files and compare their stamps with the ones of the previous scan.
+	void scan(std::vector<std::string> & paths);
+
+	std::string _root;
+
+	/// inotify instance (-1 when polling), and the directory associated to each watch.
+	int _notifier;
+
+	std::map<int, std::string> _directories;
+
+	/// Stamps of all files, and time of the last scan, when polling.
+	std::map<std::string, SourceStamp> _stamps;
+
+	std::chrono::steady_clock::time_point _lastScan;
+
+};
+
+#endif
@@ -1,8 +1,17 @@
 #include "ImageUtilities.hpp"
 #include "ResourcesManager.hpp"
+#include "ByteSource.hpp"
+#include "PixelKernels.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/Profiler.hpp"
 
 #include <vector>
 #include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <atomic>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
 #ifdef _WIN32
@@ -19,42 +28,112 @@
 #define TINYEXR_IMPLEMENTATION
 #include <tinyexr/tinyexr.h>
 
+/// Progressive reading of a source by stb_image.
+struct SourceReader {
+	ByteSource * source;
+	size_t position;
+};
+
+static int sourceRead(void * user, char * data, int size){
+	SourceReader & reader = *(SourceReader *)user;
+	const size_t readCount = reader.source->read(reader.position, (size_t)size, data);
+	reader.position += readCount;
+	return (int)readCount;
+}
+
+static void sourceSkip(void * user, int count){
+	SourceReader & reader = *(SourceReader *)user;
+	// stb_image can also rewind.
+	reader.position = (size_t)std::max(0LL, (long long)reader.position + count);
+}
+
+static int sourceEof(void * user){
+	const SourceReader & reader = *(const SourceReader *)user;
+	return reader.position >= reader.source->size() ? 1 : 0;
+}
+
+static const stbi_io_callbacks kSourceCallbacks = { sourceRead, sourceSkip, sourceEof };
+
 bool ImageUtilities::isHDR(const std::string & path){
 	return path.substr(path.size()-4,4) == ".exr";
 }
 
-int ImageUtilities::loadImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile){
+int ImageUtilities::loadImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile, bool * halfFloat){
+	Profiler::Scope scope(Profiler::Decode, path);
 	int ret = 0;
-	if(isHDR(path)){
-		ret = ImageUtilities::loadHDRImage(path, width, height, channels, (float**)data, flip, externalFile);
+	const bool hdr = isHDR(path);
+	if(halfFloat != NULL){
+		*halfFloat = false;
+	}
+	if(hdr){
+		ret = ImageUtilities::loadHDRImage(path, width, height, channels, data, flip, externalFile, halfFloat);
 	} else {
 		ret = ImageUtilities::loadLDRImage(path, width, height, channels, (unsigned char**)data, flip, externalFile);
 	}
+	if(ret == 0){
+		const size_t channelSize = hdr ? ((halfFloat != NULL && *halfFloat) ? sizeof(uint16_t) : sizeof(float)) : sizeof(unsigned char);
+		scope.setBytesDecoded(size_t(width) * height * channels * channelSize);
+	}
 	return ret;
 }
 
-int ImageUtilities::loadLDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, unsigned char **data, const bool flip, const bool externalFile){
-	
-	size_t rawSize = 0;
-	unsigned char * rawData;
-	if(externalFile){
-		rawData = (unsigned char*)(Resources::loadRawDataFromExternalFile(path, rawSize));
-	} else {
-		rawData = (unsigned char*)(Resources::manager().getRawData(path, rawSize));
+bool ImageUtilities::loadImages(const std::vector<std::string> & paths, const bool flipLDR, const unsigned int threads, std::vector<ImageView> & images, std::vector<void *> & buffers, const bool externalFile){
+	images.assign(paths.size(), ImageView());
+	std::vector<void *> datas(paths.size(), NULL);
+	std::atomic<size_t> nextImage(0);
+	std::atomic<bool> success(true);
+	// Mip levels have very different sizes, so images are distributed one at a time.
+	auto decode = [&](){
+		for(size_t iid = nextImage++; iid < paths.size(); iid = nextImage++){
+			ImageView & image = images[iid];
+			image.hdr = isHDR(paths[iid]);
+			image.flipped = flipLDR && !image.hdr;
+			const int ret = loadImage(paths[iid], image.width, image.height, image.channels, &datas[iid], image.flipped, externalFile, &image.half);
+			if(ret != 0 || datas[iid] == NULL){
+				Log::Error() << Log::Resources << "Unable to load the texture at path " << paths[iid] << "." << std::endl;
+				success = false;
+				continue;
+			}
+			image.levels.assign(1, datas[iid]);
+		}
+	};
+	const size_t threadsCount = std::min(size_t(std::max(1u, threads)), paths.size());
+	std::vector<std::thread> workers;
+	for(size_t tid = 1; tid < threadsCount; ++tid){
+		workers.emplace_back(decode);
+	}
+	decode();
+	for(auto & worker : workers){
+		worker.join();
 	}
+	for(void * data : datas){
+		if(data != NULL){
+			buffers.push_back(data);
+		}
+	}
+	return success;
+}
+
+int ImageUtilities::loadLDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, unsigned char **data, const bool flip, const bool externalFile){
 	
-	if(rawData == NULL || rawSize == 0){
+	std::unique_ptr<ByteSource> source = externalFile ? ByteSource::open(path) : Resources::manager().openSource(path);
+	if(!source || source->size() == 0){
 		return 1;
 	}
 	
-	stbi_set_flip_vertically_on_load(flip);
-	
 	channels = 4;
 	int localWidth = 0;
 	int localHeight = 0;
-	// Beware: the size has to be cast to int, imposing a limit on big file sizes.
-	*data = stbi_load_from_memory(rawData, (int)rawSize, &localWidth, &localHeight, NULL, channels);
-	free(rawData);
+	if(source->data() != NULL){
+		// Mapped files and asset pack entries are decoded in place.
+		// Beware: the size has to be cast to int, imposing a limit on big file sizes.
+		*data = stbi_load_from_memory((const unsigned char*)source->data(), (int)source->size(), &localWidth, &localHeight, NULL, channels);
+	} else {
+		// Else the decoder pulls the content progressively.
+		SourceReader reader = { source.get(), 0 };
+		source->readahead(0, source->size());
+		*data = stbi_load_from_callbacks(&kSourceCallbacks, &reader, &localWidth, &localHeight, NULL, channels);
+	}
 	
 	if(*data == NULL){
 		return 1;
@@ -63,10 +142,32 @@ int ImageUtilities::loadLDRImage(const std::string &path, unsigned int & width,
 	width = (unsigned int)localWidth;
 	height = (unsigned int)localHeight;
 	
+	// The stb_image flip setting is global, flip here so that images can be decoded on multiple threads.
+	if(flip){
+		PixelKernels::flipRows(*data, size_t(width) * channels, height);
+	}
+	
 	return 0;
 }
 
-int ImageUtilities::loadHDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, float **data, const bool flip, const bool externalFile){
+/// Interleave the RGB planes of an EXR image, in a buffer allocated with malloc.
+template<typename T>
+static T * interleaveChannels(const EXRImage & image, const int indices[3], const bool flip){
+	const size_t width = size_t(image.width);
+	const size_t height = size_t(image.height);
+	T * data = reinterpret_cast<T *>(malloc(3 * sizeof(T) * width * height));
+	if(data == NULL){
+		return NULL;
+	}
+	const T * const * planes = reinterpret_cast<const T * const *>(image.images);
+	for(size_t y = 0; y < height; ++y){
+		const size_t sourceRow = (flip ? (height - 1 - y) : y) * width;
+		PixelKernels::interleaveRGB(planes[indices[0]] + sourceRow, planes[indices[1]] + sourceRow, planes[indices[2]] + sourceRow, data + 3 * y * width, width);
+	}
+	return data;
+}
+
+int ImageUtilities::loadHDRImage(const std::string &path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile, bool * halfFloat){
 	
 	// Code adapted from tinyEXR deprecated loadEXR.
 	EXRVersion exr_version;
@@ -75,94 +176,94 @@ int ImageUtilities::loadHDRImage(const std::string &path, unsigned int & width,
 	InitEXRHeader(&exr_header);
 	InitEXRImage(&exr_image);
 	
-	size_t rawSize = 0;
-	unsigned char * rawData;
-	if(externalFile){
-		rawData = (unsigned char*)(Resources::loadRawDataFromExternalFile(path, rawSize));
-	} else {
-		rawData = (unsigned char*)(Resources::manager().getRawData(path, rawSize));
+	std::unique_ptr<ByteSource> source = externalFile ? ByteSource::open(path) : Resources::manager().openSource(path);
+	if(!source || source->size() == 0){
+		return 1;
 	}
-	
-	if(rawData == NULL || rawSize == 0){
+	// The EXR decoder needs random access to the whole file: decode in place if possible, else read it at once.
+	char * rawBuffer = NULL;
+	const size_t rawSize = source->size();
+	const unsigned char * rawData = (const unsigned char*)source->data();
+	if(rawData == NULL){
+		rawBuffer = source->readAll();
+		rawData = (const unsigned char*)rawBuffer;
+	}
+	if(rawData == NULL || rawSize < tinyexr::kEXRVersionSize){
+		free(rawBuffer);
 		return 1;
 	}
 	
 	{
 		int ret = ParseEXRVersionFromMemory(&exr_version, rawData, tinyexr::kEXRVersionSize);
 		if (ret != TINYEXR_SUCCESS) {
+			free(rawBuffer);
 			return ret;
 		}
 		
 		if (exr_version.multipart || exr_version.non_image) {
+			free(rawBuffer);
 			return TINYEXR_ERROR_INVALID_DATA;
 		}
 	}
 	{
 		int ret = ParseEXRHeaderFromMemory(&exr_header, &exr_version, rawData, rawSize, NULL);
 		if (ret != TINYEXR_SUCCESS) {
+			free(rawBuffer);
 			return ret;
 		}
 	}
 	
-	// Read HALF channel as FLOAT.
+	// RGB, alpha is ignored.
+	int indices[3] = { -1, -1, -1 };
+	const char * names[3] = { "R", "G", "B" };
+	for (int c = 0; c < exr_header.num_channels; c++) {
+		for (int i = 0; i < 3; ++i) {
+			if (strcmp(exr_header.channels[c].name, names[i]) == 0) {
+				indices[i] = c;
+			}
+		}
+	}
+	if (indices[0] == -1 || indices[1] == -1 || indices[2] == -1) {
+		FreeEXRHeader(&exr_header);
+		free(rawBuffer);
+		return TINYEXR_ERROR_INVALID_DATA;
+	}
+	
+	// Keep HALF channels as is if the caller accepts them and all colors are HALF, else read them as FLOAT.
+	bool keepHalf = halfFloat != NULL;
+	for (int i = 0; i < 3; ++i) {
+		keepHalf = keepHalf && exr_header.pixel_types[indices[i]] == TINYEXR_PIXELTYPE_HALF;
+	}
 	for (int i = 0; i < exr_header.num_channels; i++) {
-		if (exr_header.pixel_types[i] == TINYEXR_PIXELTYPE_HALF) {
+		if (exr_header.pixel_types[i] == TINYEXR_PIXELTYPE_HALF && !keepHalf) {
 			exr_header.requested_pixel_types[i] = TINYEXR_PIXELTYPE_FLOAT;
 		}
 	}
 	{
 		int ret = LoadEXRImageFromMemory(&exr_image, &exr_header, rawData, rawSize, NULL);
 		if (ret != TINYEXR_SUCCESS) {
+			FreeEXRHeader(&exr_header);
+			free(rawBuffer);
 			return ret;
 		}
 	}
-	free(rawData);
-	
-	// RGBA
-	int idxR = -1;
-	int idxG = -1;
-	int idxB = -1;
-	int idxA = -1;
-	for (int c = 0; c < exr_header.num_channels; c++) {
-		if (strcmp(exr_header.channels[c].name, "R") == 0) {
-			idxR = c;
-		} else if (strcmp(exr_header.channels[c].name, "G") == 0) {
-			idxG = c;
-		} else if (strcmp(exr_header.channels[c].name, "B") == 0) {
-			idxB = c;
-		} else if (strcmp(exr_header.channels[c].name, "A") == 0) {
-			idxA = c;
-		}
-	}
-	
-	if (idxR == -1 || idxG == -1 || idxB == -1) {
-		// @todo { free exr_image }
-		return TINYEXR_ERROR_INVALID_DATA;
-	}
+	free(rawBuffer);
+	source.reset();
 	
 	width = exr_image.width;
 	height = exr_image.height;
 	channels = 3;
-	
-	*data = reinterpret_cast<float *>(malloc(channels * sizeof(float) * static_cast<size_t>(width) *
-												  static_cast<size_t>(height)));
-	
-	for(int y = 0; y < exr_image.height; ++y){
-		for (int x = 0; x < exr_image.width; ++x){
-			const int destIndex = y * width + x;
-			const int sourceIndex = flip ? ((height-1-y)*width+x) : destIndex;
-			
-			(*data)[channels * destIndex + 0] = reinterpret_cast<float **>(exr_image.images)[idxR][sourceIndex];
-			(*data)[channels * destIndex + 1] = reinterpret_cast<float **>(exr_image.images)[idxG][sourceIndex];
-			(*data)[channels * destIndex + 2] = reinterpret_cast<float **>(exr_image.images)[idxB][sourceIndex];
-			// Ignore alpha.
-		}
+	if(keepHalf){
+		*halfFloat = true;
+		*data = interleaveChannels<uint16_t>(exr_image, indices, flip);
+	} else {
+		*data = interleaveChannels<float>(exr_image, indices, flip);
 	}
 	
 	FreeEXRHeader(&exr_header);
 	FreeEXRImage(&exr_image);
 	
-	return 0;
+	return *data != NULL ? 0 : 1;
 }
 
 int ImageUtilities::saveLDRImage(const std::string &path, const unsigned int width, const unsigned int height, const unsigned int channels, const unsigned char * data, const bool flip, const bool ignoreAlpha){
@@ -176,12 +277,7 @@ int ImageUtilities::saveLDRImage(const std::string &path, const unsigned int wid
 	int ret = 1;
 	if(ignoreAlpha && channels == 4){
 		unsigned char * newData = new unsigned char[width*height*4];
-		for(unsigned int i = 0; i < width*height; ++i){
-			newData[4*i+0] = data[4*i+0];
-			newData[4*i+1] = data[4*i+1];
-			newData[4*i+2] = data[4*i+2];
-			newData[4*i+3] = 255;
-		}
+		PixelKernels::copyOpaqueRGBA(data, newData, size_t(width) * height);
 		ret = stbi_write_png(path.c_str(), (int)width, (int)height, (int)channels, (const void*)newData, stride_in_bytes);
 		delete [] newData;
 	} else {
@@ -211,7 +307,9 @@ int ImageUtilities::saveHDRImage(const std::string &path, const unsigned int wid
 	if (components == 1) {
 		images[0].resize(static_cast<size_t>(width * height));
 		memcpy(images[0].data(), data, sizeof(float) * size_t(width * height));
-		// TODO: support flipping.
+		if (flip) {
+			PixelKernels::flipRows(images[0].data(), sizeof(float) * width, height);
+		}
 	} else {
 		images[0].resize(static_cast<size_t>(width * height));
 		images[1].resize(static_cast<size_t>(width * height));
@@ -220,21 +318,28 @@ int ImageUtilities::saveHDRImage(const std::string &path, const unsigned int wid
 		
 		// Split RGB(A)RGB(A)RGB(A)... into R, G and B(and A) layers
 		// By default we try to always fill at least three channels.
-		for (size_t y = 0; y < height; y++) {
-			for (size_t x = 0; x < width; x++) {
-				const size_t destIndex = y * width + x;
-				const size_t sourceIndex = flip ? ((height-1-y)*width+x) : destIndex;
-				//images[0][destIndex] = data[static_cast<size_t>(components) * sourceIndex + 0];
-				//images[1][destIndex] = data[static_cast<size_t>(components) * sourceIndex + 1];
-				//images[2][destIndex] = data[static_cast<size_t>(components) * sourceIndex + 2];
-				for(unsigned int j = 0; j < channels; ++j){
-					images[j][destIndex] = data[static_cast<size_t>(channels) * sourceIndex + j];
+		if (channels == 3 || channels == 4) {
+			for (size_t y = 0; y < height; y++) {
+				const size_t destIndex = y * width;
+				const size_t sourceIndex = (flip ? (height-1-y) : y) * width;
+				if (channels == 3) {
+					PixelKernels::deinterleaveRGB(data + 3 * sourceIndex, &images[0][destIndex], &images[1][destIndex], &images[2][destIndex], width);
+				} else {
+					PixelKernels::deinterleaveRGBA(data + 4 * sourceIndex, &images[0][destIndex], &images[1][destIndex], &images[2][destIndex], &images[3][destIndex], width);
 				}
-				for(unsigned int j = channels; j < 3; ++j){
-					images[j][destIndex] = 0.0f;
-				}
-				if (components == 4) {
-					images[3][destIndex] = ignoreAlpha ? 1.0f : data[static_cast<size_t>(channels) * sourceIndex + 3];
+			}
+			if (channels == 4 && ignoreAlpha) {
+				std::fill(images[3].begin(), images[3].end(), 1.0f);
+			}
+		} else {
+			// Two channels, the third one is empty.
+			for (size_t y = 0; y < height; y++) {
+				for (size_t x = 0; x < width; x++) {
+					const size_t destIndex = y * width + x;
+					const size_t sourceIndex = flip ? ((height-1-y)*width+x) : destIndex;
+					images[0][destIndex] = data[static_cast<size_t>(channels) * sourceIndex + 0];
+					images[1][destIndex] = data[static_cast<size_t>(channels) * sourceIndex + 1];
+					images[2][destIndex] = 0.0f;
 				}
 			}
 		}
@@ -320,3 +425,288 @@ int ImageUtilities::saveHDRImage(const std::string &path, const unsigned int wid
 }
 
 
+
+static float halfToFloat(const uint16_t value){
+	tinyexr::FP16 half;
+	half.u = value;
+	return tinyexr::half_to_float(half).f;
+}
+
+template<typename T>
+void downscaleImageTyped(const T * src, const unsigned int width, const unsigned int height, const unsigned int channels, T * dst){
+	const unsigned int dstWidth = (std::max)(1u, width / 2);
+	const unsigned int dstHeight = (std::max)(1u, height / 2);
+	for(unsigned int y = 0; y < dstHeight; ++y){
+		// Clamp for odd or unit dimensions.
+		const size_t y0 = (std::min)(2 * y, height - 1);
+		const size_t y1 = (std::min)(2 * y + 1, height - 1);
+		for(unsigned int x = 0; x < dstWidth; ++x){
+			const size_t x0 = (std::min)(2 * x, width - 1);
+			const size_t x1 = (std::min)(2 * x + 1, width - 1);
+			for(unsigned int c = 0; c < channels; ++c){
+				const float sum = float(src[(y0 * width + x0) * channels + c]) + float(src[(y0 * width + x1) * channels + c])
+								+ float(src[(y1 * width + x0) * channels + c]) + float(src[(y1 * width + x1) * channels + c]);
+				dst[(y * dstWidth + x) * channels + c] = std::is_integral<T>::value ? T(sum * 0.25f + 0.5f) : T(sum * 0.25f);
+			}
+		}
+	}
+}
+
+/// Half-floats are averaged in 32-bit.
+static void downscaleImageHalf(const uint16_t * src, const unsigned int width, const unsigned int height, const unsigned int channels, uint16_t * dst){
+	const unsigned int dstWidth = (std::max)(1u, width / 2);
+	const unsigned int dstHeight = (std::max)(1u, height / 2);
+	for(unsigned int y = 0; y < dstHeight; ++y){
+		// Clamp for odd or unit dimensions.
+		const size_t y0 = (std::min)(2 * y, height - 1);
+		const size_t y1 = (std::min)(2 * y + 1, height - 1);
+		for(unsigned int x = 0; x < dstWidth; ++x){
+			const size_t x0 = (std::min)(2 * x, width - 1);
+			const size_t x1 = (std::min)(2 * x + 1, width - 1);
+			for(unsigned int c = 0; c < channels; ++c){
+				tinyexr::FP32 sum;
+				sum.f = 0.25f * (halfToFloat(src[(y0 * width + x0) * channels + c]) + halfToFloat(src[(y0 * width + x1) * channels + c])
+								+ halfToFloat(src[(y1 * width + x0) * channels + c]) + halfToFloat(src[(y1 * width + x1) * channels + c]));
+				dst[(y * dstWidth + x) * channels + c] = tinyexr::float_to_half_full(sum).u;
+			}
+		}
+	}
+}
+
+/// Separable filter halving an image: dst[x] = sum of weights[k] * src[2x + first + k], clamped at the edges.
+struct HalvingFilter {
+	int first;
+	std::vector<float> weights;
+};
+
+/// Modified Bessel function of the first kind, order 0.
+static double besselI0(const double x){
+	double sum = 1.0;
+	double term = 1.0;
+	for(int k = 1; k < 32; ++k){
+		const double factor = x / (2.0 * k);
+		term *= factor * factor;
+		sum += term;
+	}
+	return sum;
+}
+
+/// Sinc windowed by a Kaiser window (alpha = 4), with a radius of two destination pixels.
+static HalvingFilter kaiserFilter(){
+	const double pi = 3.14159265358979323846;
+	const double radius = 2.0;
+	const double beta = 4.0 * pi;
+	HalvingFilter filter;
+	filter.first = -3;
+	double total = 0.0;
+	for(int k = 0; k < 8; ++k){
+		// Distance between the source and destination pixel centers, in destination pixels.
+		const double d = (double(k) - 3.5) / 2.0;
+		const double t = d / radius;
+		const double sinc = std::sin(pi * d) / (pi * d);
+		const double weight = sinc * besselI0(beta * std::sqrt(1.0 - t * t)) / besselI0(beta);
+		filter.weights.push_back(float(weight));
+		total += weight;
+	}
+	for(float & weight : filter.weights){
+		weight = float(weight / total);
+	}
+	return filter;
+}
+
+static const HalvingFilter & halvingFilter(const ImageUtilities::MipFilter filter){
+	static const HalvingFilter box = { 0, { 0.5f, 0.5f } };
+	static const HalvingFilter kaiser = kaiserFilter();
+	return filter == ImageUtilities::KaiserFilter ? kaiser : box;
+}
+
+/// Conversions between 8-bit sRGB and linear values.
+struct SRGBTables {
+	float toLinear[256];
+	/// Linear values halfway between two consecutive sRGB values.
+	float thresholds[256];
+	/// Encoded value of the start of each interval of linear values, refined with the thresholds.
+	unsigned char guesses[4096];
+
+	SRGBTables(){
+		const auto decode = [](const double value){
+			return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+		};
+		for(int i = 0; i < 256; ++i){
+			toLinear[i] = float(decode(i / 255.0));
+		}
+		for(int i = 0; i < 255; ++i){
+			thresholds[i] = float(decode((i + 0.5) / 255.0));
+		}
+		thresholds[255] = 2.0f;
+		for(int i = 0; i < 4096; ++i){
+			guesses[i] = (unsigned char)(std::upper_bound(thresholds, thresholds + 255, float(i) / 4096.0f) - thresholds);
+		}
+	}
+
+	/// Value in [0,1].
+	unsigned char encode(const float value) const {
+		unsigned int encoded = guesses[(std::min)(int(value * 4096.0f), 4095)];
+		while(value >= thresholds[encoded]){
+			++encoded;
+		}
+		return (unsigned char)encoded;
+	}
+};
+
+static const SRGBTables & srgbTables(){
+	static const SRGBTables tables;
+	return tables;
+}
+
+/// Pixel format of the images filtered in linear space.
+struct FilteredFormat {
+	unsigned int width;
+	unsigned int channels;
+	bool hdr;
+	bool halfFloat;
+	bool srgb;
+	/// The alpha channel of LDR images is always linear.
+	unsigned int colorChannels() const { return (srgb && !hdr) ? (channels == 4 ? 3 : channels) : 0; }
+};
+
+/// Convert a row of 'count' pixels to linear floats.
+static void toLinearRow(const void * src, const FilteredFormat & format, const size_t count, float * dst){
+	const size_t values = count * format.channels;
+	if(format.hdr && format.halfFloat){
+		const uint16_t * halves = (const uint16_t *)src;
+		for(size_t i = 0; i < values; ++i){
+			dst[i] = halfToFloat(halves[i]);
+		}
+		return;
+	}
+	const SRGBTables & tables = srgbTables();
+	const unsigned int colorChannels = format.colorChannels();
+	const unsigned char * bytes = (const unsigned char *)src;
+	for(size_t i = 0; i < values; i += format.channels){
+		for(unsigned int c = 0; c < format.channels; ++c){
+			dst[i + c] = c < colorChannels ? tables.toLinear[bytes[i + c]] : float(bytes[i + c]) * (1.0f / 255.0f);
+		}
+	}
+}
+
+/// Convert a row of 'count' linear pixels back to the image format. Negative lobes of the filters can overshoot.
+static void fromLinearRow(const float * src, const FilteredFormat & format, const size_t count, void * dst){
+	const size_t values = count * format.channels;
+	if(format.hdr && format.halfFloat){
+		uint16_t * halves = (uint16_t *)dst;
+		for(size_t i = 0; i < values; ++i){
+			tinyexr::FP32 single;
+			single.f = (std::max)(src[i], 0.0f);
+			halves[i] = tinyexr::float_to_half_full(single).u;
+		}
+	} else if(format.hdr){
+		float * floats = (float *)dst;
+		for(size_t i = 0; i < values; ++i){
+			floats[i] = (std::max)(src[i], 0.0f);
+		}
+	} else {
+		const SRGBTables & tables = srgbTables();
+		const unsigned int colorChannels = format.colorChannels();
+		unsigned char * bytes = (unsigned char *)dst;
+		for(size_t i = 0; i < values; i += format.channels){
+			for(unsigned int c = 0; c < format.channels; ++c){
+				const float value = (std::min)((std::max)(src[i + c], 0.0f), 1.0f);
+				bytes[i + c] = c < colorChannels ? tables.encode(value) : (unsigned char)(value * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+/// Halve an image in linear space, rows first using the vectorized kernels, then columns. Source rows are converted
+/// on demand and kept while the following destination rows need them, float images are read in place.
+static void downscaleImageFiltered(const void * src, const unsigned int height, const FilteredFormat & format, const HalvingFilter & filter, void * dst){
+	const unsigned int width = format.width;
+	const unsigned int dstWidth = (std::max)(1u, width / 2);
+	const unsigned int dstHeight = (std::max)(1u, height / 2);
+	const int taps = int(filter.weights.size());
+	const size_t rowSize = size_t(width) * format.channels;
+	const size_t dstRowSize = size_t(dstWidth) * format.channels;
+	const size_t valueSize = format.hdr ? (format.halfFloat ? sizeof(uint16_t) : sizeof(float)) : sizeof(unsigned char);
+	const bool inPlace = format.hdr && !format.halfFloat;
+	// Consecutive rows land in distinct slots.
+	std::vector<float> cachedRows(inPlace ? 0 : size_t(taps) * rowSize);
+	std::vector<int> cachedIndices(taps, -1);
+	std::vector<float> row(rowSize);
+	std::vector<float> dstRow(dstRowSize);
+	for(unsigned int y = 0; y < dstHeight; ++y){
+		std::fill(row.begin(), row.end(), 0.0f);
+		for(int k = 0; k < taps; ++k){
+			const int sy = (std::min)((std::max)(int(2 * y) + filter.first + k, 0), int(height) - 1);
+			const float * source = (const float *)src + size_t(sy) * rowSize;
+			if(!inPlace){
+				const int slot = sy % taps;
+				source = &cachedRows[size_t(slot) * rowSize];
+				if(cachedIndices[slot] != sy){
+					toLinearRow((const unsigned char *)src + size_t(sy) * rowSize * valueSize, format, width, &cachedRows[size_t(slot) * rowSize]);
+					cachedIndices[slot] = sy;
+				}
+			}
+			PixelKernels::accumulate(source, filter.weights[k], &row[0], rowSize);
+		}
+		for(unsigned int x = 0; x < dstWidth; ++x){
+			float * pixel = &dstRow[size_t(x) * format.channels];
+			for(unsigned int c = 0; c < format.channels; ++c){
+				pixel[c] = 0.0f;
+			}
+			for(int k = 0; k < taps; ++k){
+				const int sx = (std::min)((std::max)(int(2 * x) + filter.first + k, 0), int(width) - 1);
+				const float * source = &row[size_t(sx) * format.channels];
+				const float weight = filter.weights[k];
+				for(unsigned int c = 0; c < format.channels; ++c){
+					pixel[c] += weight * source[c];
+				}
+			}
+		}
+		fromLinearRow(&dstRow[0], format, dstWidth, (unsigned char *)dst + size_t(y) * dstRowSize * valueSize);
+	}
+}
+
+void ImageUtilities::downscaleImage(const void * src, const unsigned int width, const unsigned int height, const unsigned int channels, const bool hdr, void * dst, const bool halfFloat, const bool srgb, const MipFilter filter){
+	// Averages can be computed directly, except for sRGB colors.
+	if(filter == BoxFilter && (hdr || !srgb)){
+		if(hdr && halfFloat){
+			downscaleImageHalf((const uint16_t *)src, width, height, channels, (uint16_t *)dst);
+		} else if(hdr){
+			downscaleImageTyped((const float *)src, width, height, channels, (float *)dst);
+		} else {
+			downscaleImageTyped((const unsigned char *)src, width, height, channels, (unsigned char *)dst);
+		}
+		return;
+	}
+	const FilteredFormat format = { width, channels, hdr, halfFloat, srgb };
+	downscaleImageFiltered(src, height, format, halvingFilter(filter), dst);
+}
+
+bool ImageUtilities::generateMipmaps(ImageView & image, const bool srgb, const MipFilter filter, std::vector<void *> & buffers){
+	if(image.levels.empty()){
+		return false;
+	}
+	const unsigned int first = (unsigned int)image.levels.size();
+	const unsigned int levels = TextureCache::levelsCount(image.width, image.height);
+	size_t size = 0;
+	for(unsigned int level = first; level < levels; ++level){
+		size += image.levelSize(level);
+	}
+	if(size == 0){
+		return true;
+	}
+	unsigned char * buffer = (unsigned char *)malloc(size);
+	if(buffer == NULL){
+		return false;
+	}
+	buffers.push_back(buffer);
+	for(unsigned int level = first; level < levels; ++level){
+		const unsigned int width = (std::max)(1u, image.width >> (level - 1));
+		const unsigned int height = (std::max)(1u, image.height >> (level - 1));
+		downscaleImage(image.levels[level - 1], width, height, image.channels, image.hdr, buffer, image.half, srgb && !image.hdr, filter);
+		image.levels.push_back(buffer);
+		buffer += image.levelSize(level);
+	}
+	return true;
+}
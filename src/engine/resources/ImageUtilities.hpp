@@ -1,5 +1,6 @@
 #ifndef ImageUtilities_h
 #define ImageUtilities_h
+#include "TextureCache.hpp"
 #include <gl3w/gl3w.h>
 #include <string>
 #include <vector>
@@ -12,17 +13,39 @@ public:
 	
 	static bool isHDR(const std::string & path);
 	
-	static int loadImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile = false);
+	/// Decode an image. HDR images are promoted to 32-bit floats, unless 'halfFloat' is provided: color channels stored
+	/// as half-floats are then kept as is, and it is set if the decoded data is 16-bit.
+	static int loadImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile = false, bool * halfFloat = NULL);
+	
+	/// Decode a set of images concurrently, each thread taking the next image to decode. LDR images are flipped
+	/// if 'flipLDR' is set, HDR images never are and keep their half-float channels. Each view references its decoded
+	/// buffer, stored in 'buffers' to be freed by the caller, even on failure. Return false if any image failed to load.
+	static bool loadImages(const std::vector<std::string> & paths, const bool flipLDR, const unsigned int threads, std::vector<ImageView> & images, std::vector<void *> & buffers, const bool externalFile = false);
 	
 	static int saveLDRImage(const std::string & path, const unsigned int width, const unsigned int height, const unsigned int channels, const unsigned char *data, const bool flip, const bool ignoreAlpha = false);
 	
 	static int saveHDRImage(const std::string & path, const unsigned int width, const unsigned int height, const unsigned int channels, const float *data, const bool flip, const bool ignoreAlpha = false);
 	
+	/// Filters used to build mipmap levels.
+	enum MipFilter {
+		BoxFilter, ///< Average of 2x2 pixels.
+		KaiserFilter ///< Kaiser-windowed sinc over 8x8 pixels, sharper.
+	};
+	
+	/// Downscale an image by two in each dimension, to build the next mipmap level.
+	/// The destination should be able to hold max(1,width/2) x max(1,height/2) pixels. HDR images are either floats or half-floats.
+	/// The color channels of sRGB LDR images are filtered in linear space.
+	static void downscaleImage(const void * src, const unsigned int width, const unsigned int height, const unsigned int channels, const bool hdr, void * dst, const bool halfFloat = false, const bool srgb = false, const MipFilter filter = BoxFilter);
+	
+	/// Complete the mip chain of an image down to 1x1, starting from its last level. The new levels are
+	/// stored in a single buffer appended to 'buffers', to be freed by the caller. Return false on failure.
+	static bool generateMipmaps(ImageView & image, const bool srgb, const MipFilter filter, std::vector<void *> & buffers);
+	
 private:
 	
 	static int loadLDRImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, unsigned char **data, const bool flip, const bool externalFile);
 	
-	static int loadHDRImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, float **data, const bool flip, const bool externalFile);
+	static int loadHDRImage(const std::string & path, unsigned int & width, unsigned int & height, unsigned int & channels, void **data, const bool flip, const bool externalFile, bool * halfFloat);
 	
 };
 
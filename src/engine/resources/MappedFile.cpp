@@ -0,0 +1,115 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : _data(NULL), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(NULL) { }
+
+bool MappedFile::open(const std::string & path){
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE){
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping == NULL){
+		CloseHandle(file);
+		return false;
+	}
+	const void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(data == NULL){
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_mapping = mapping;
+	_data = (const char *)data;
+	_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close(){
+	if(_data != NULL){
+		UnmapViewOfFile(_data);
+	}
+	if(_mapping != NULL){
+		CloseHandle(_mapping);
+	}
+	if(_file != INVALID_HANDLE_VALUE){
+		CloseHandle(_file);
+	}
+	_data = NULL;
+	_size = 0;
+	_file = INVALID_HANDLE_VALUE;
+	_mapping = NULL;
+}
+
+#else
+
+MappedFile::MappedFile() : _data(NULL), _size(0) { }
+
+bool MappedFile::open(const std::string & path){
+	close();
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if(file < 0){
+		return false;
+	}
+	struct stat fileStat;
+	if(fstat(file, &fileStat) != 0 || fileStat.st_size == 0){
+		::close(file);
+		return false;
+	}
+	void * data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping stays valid once the descriptor is closed.
+	::close(file);
+	if(data == MAP_FAILED){
+		return false;
+	}
+	_data = (const char *)data;
+	_size = (size_t)fileStat.st_size;
+	return true;
+}
+
+void MappedFile::close(){
+	if(_data != NULL){
+		munmap((void *)_data, _size);
+	}
+	_data = NULL;
+	_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile(){
+	close();
+}
+
+void MappedFile::readahead(const size_t offset, const size_t count) const {
+#ifndef _WIN32
+	if(offset >= _size){
+		return;
+	}
+	// The range has to start on a page boundary.
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t start = offset - (offset % pageSize);
+	const size_t end = (offset + count < _size) ? offset + count : _size;
+	madvise((void*)(_data + start), end - start, MADV_WILLNEED);
+#else
+	(void)offset; (void)count;
+#endif
+}
@@ -0,0 +1,47 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <string>
+#include <cstddef>
+
+/// Read-only memory mapping of a file on disk. The mapping is released when the object is destroyed.
+class MappedFile {
+
+public:
+
+	MappedFile();
+
+	~MappedFile();
+
+	/// Map the whole file at the given path, releasing any previous mapping. Return false on failure.
+	bool open(const std::string & path);
+
+	/// Release the mapping.
+	void close();
+
+	const char * data() const { return _data; }
+
+	size_t size() const { return _size; }
+
+	/// Ask the system to read a range of the file in the background.
+	void readahead(const size_t offset, const size_t count) const;
+
+private:
+
+	MappedFile(const MappedFile &);
+
+	MappedFile & operator= (const MappedFile &);
+
+	const char * _data;
+
+	size_t _size;
+
+#ifdef _WIN32
+	void * _file;
+
+	void * _mapping;
+#endif
+
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "MeshCache.hpp"
+#include "../helpers/Logger.hpp"
+#include <fstream>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+/// Bump the version whenever the layout or the processing applied to the meshes changes.
+static const uint32_t kMeshCacheVersion = 3;
+static const char kMeshCacheMagic[4] = { 'G', 'L', 'T', 'M' };
+
+/// File header, followed by the positions, normals, tangents, binormals, texcoords, indices, levels of detail indices and levels of detail streams.
+struct MeshCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceSize;
+	uint64_t sourceTime;
+	uint64_t sourceHash;
+	uint32_t counts[8];
+};
+
+static_assert(sizeof(MeshCacheHeader) == 64, "Unexpected mesh cache header size.");
+
+static const size_t kStreamsCount = 8;
+static const size_t kStreamSizes[kStreamsCount] = { sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(unsigned int), sizeof(unsigned int), sizeof(MeshLod) };
+
+/// Check that all indices reference one of the vertices.
+static bool indicesInRange(const DataView<unsigned int> & indices, const size_t verticesCount){
+	for(size_t iid = 0; iid < indices.size; ++iid){
+		if(indices.data[iid] >= verticesCount){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool MeshCache::save(const std::string & path, const MeshView & mesh, const SourceStamp & stamp){
+	MeshCacheHeader header;
+	std::memset(&header, 0, sizeof(MeshCacheHeader));
+	std::memcpy(header.magic, kMeshCacheMagic, 4);
+	header.version = kMeshCacheVersion;
+	header.sourceSize = stamp.size;
+	header.sourceTime = stamp.time;
+	header.sourceHash = stamp.hash;
+	const void * streams[kStreamsCount] = { mesh.positions.data, mesh.normals.data, mesh.tangents.data, mesh.binormals.data, mesh.texcoords.data, mesh.indices.data, mesh.lodIndices.data, mesh.lods.data };
+	const size_t counts[kStreamsCount] = { mesh.positions.size, mesh.normals.size, mesh.tangents.size, mesh.binormals.size, mesh.texcoords.size, mesh.indices.size, mesh.lodIndices.size, mesh.lods.size };
+	for(size_t i = 0; i < kStreamsCount; ++i){
+		header.counts[i] = (uint32_t)counts[i];
+	}
+
+	// Write to a temporary file first, so that a cache file is never partially written,
+	// and so that an existing cache that might still be mapped is not truncated.
+	const std::string tempPath = path + ".tmp";
+	std::ofstream outputFile(tempPath, std::ios::binary);
+	if(!outputFile.is_open()){
+		Log::Error() << Log::Resources << "Unable to write mesh cache at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	outputFile.write((const char *)&header, sizeof(MeshCacheHeader));
+	for(size_t i = 0; i < kStreamsCount; ++i){
+		if(counts[i] > 0){
+			outputFile.write((const char *)streams[i], counts[i] * kStreamSizes[i]);
+		}
+	}
+	const bool success = !outputFile.fail();
+	outputFile.close();
+	if(!success){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to write mesh cache at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+#ifdef _WIN32
+	// Windows doesn't replace an existing file when renaming.
+	std::remove(path.c_str());
+#endif
+	if(std::rename(tempPath.c_str(), path.c_str()) != 0){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to write mesh cache at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::load(const std::string & path, MappedFile & file, MeshView & mesh, SourceStamp & stamp){
+	if(!file.open(path)){
+		return false;
+	}
+	if(file.size() < sizeof(MeshCacheHeader)){
+		file.close();
+		return false;
+	}
+	MeshCacheHeader header;
+	std::memcpy(&header, file.data(), sizeof(MeshCacheHeader));
+	if(std::memcmp(header.magic, kMeshCacheMagic, 4) != 0 || header.version != kMeshCacheVersion){
+		file.close();
+		return false;
+	}
+	// Check that the streams exactly fill the file.
+	size_t expectedSize = sizeof(MeshCacheHeader);
+	for(size_t i = 0; i < kStreamsCount; ++i){
+		expectedSize += size_t(header.counts[i]) * kStreamSizes[i];
+	}
+	if(expectedSize != file.size()){
+		file.close();
+		return false;
+	}
+
+	const char * current = file.data() + sizeof(MeshCacheHeader);
+	mesh.positions = DataView<glm::vec3>((const glm::vec3 *)current, header.counts[0]);
+	current += header.counts[0] * kStreamSizes[0];
+	mesh.normals = DataView<glm::vec3>((const glm::vec3 *)current, header.counts[1]);
+	current += header.counts[1] * kStreamSizes[1];
+	mesh.tangents = DataView<glm::vec3>((const glm::vec3 *)current, header.counts[2]);
+	current += header.counts[2] * kStreamSizes[2];
+	mesh.binormals = DataView<glm::vec3>((const glm::vec3 *)current, header.counts[3]);
+	current += header.counts[3] * kStreamSizes[3];
+	mesh.texcoords = DataView<glm::vec2>((const glm::vec2 *)current, header.counts[4]);
+	current += header.counts[4] * kStreamSizes[4];
+	mesh.indices = DataView<unsigned int>((const unsigned int *)current, header.counts[5]);
+	current += header.counts[5] * kStreamSizes[5];
+	mesh.lodIndices = DataView<unsigned int>((const unsigned int *)current, header.counts[6]);
+	current += header.counts[6] * kStreamSizes[6];
+	mesh.lods = DataView<MeshLod>((const MeshLod *)current, header.counts[7]);
+	// The levels of detail have to cover their indices exactly.
+	size_t lodIndicesCount = 0;
+	for(size_t lid = 0; lid < mesh.lods.size; ++lid){
+		lodIndicesCount += mesh.lods.data[lid].count;
+	}
+	// Attributes are either absent or given for each vertex, and indices can't read past the vertex buffers.
+	const size_t verticesCount = mesh.positions.size;
+	const size_t attributesCounts[4] = { mesh.normals.size, mesh.tangents.size, mesh.binormals.size, mesh.texcoords.size };
+	bool consistent = lodIndicesCount == mesh.lodIndices.size;
+	for(size_t aid = 0; aid < 4 && consistent; ++aid){
+		consistent = attributesCounts[aid] == 0 || attributesCounts[aid] == verticesCount;
+	}
+	consistent = consistent && indicesInRange(mesh.indices, verticesCount) && indicesInRange(mesh.lodIndices, verticesCount);
+	if(!consistent){
+		mesh = MeshView();
+		file.close();
+		return false;
+	}
+
+	stamp.size = header.sourceSize;
+	stamp.time = header.sourceTime;
+	stamp.hash = header.sourceHash;
+	return true;
+}
+
+bool MeshCache::restamp(const std::string & path, const SourceStamp & stamp){
+	std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+	if(!file.is_open()){
+		return false;
+	}
+	const uint64_t values[3] = { stamp.size, stamp.time, stamp.hash };
+	file.seekp(offsetof(MeshCacheHeader, sourceSize));
+	file.write((const char *)values, sizeof(values));
+	return !file.fail();
+}
+
+uint64_t MeshCache::hash(const char * data, size_t size, uint64_t previous){
+	uint64_t hash = previous;
+	for(size_t i = 0; i < size; ++i){
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
@@ -0,0 +1,40 @@
+#ifndef MeshCache_h
+#define MeshCache_h
+
+#include "MeshUtilities.hpp"
+#include "MappedFile.hpp"
+#include <string>
+#include <cstdint>
+
+/// Identify the version of a source file a cache was generated from.
+struct SourceStamp {
+	uint64_t size; ///< Size of the source file in bytes.
+	uint64_t time; ///< Modification time on disk in nanoseconds (100ns intervals on Windows), or checksum of the entry in an archive.
+	uint64_t hash; ///< Hash of the source content, 0 if not computed.
+
+	SourceStamp() : size(0), time(0), hash(0) {}
+};
+
+/// Binary mesh cache: a fixed header followed by the raw attribute streams and the indices,
+/// stored in the layout expected by the GPU so that a mapped file can be uploaded directly.
+class MeshCache {
+
+public:
+
+	/// Write the mesh and the stamp of its source to a cache file. Return false on failure.
+	static bool save(const std::string & path, const MeshView & mesh, const SourceStamp & stamp);
+
+	/// Map a cache file and expose its content. Return false if the file is missing or invalid, including
+	/// attribute counts that differ from the positions count and indices out of the vertices range.
+	/// The view is only valid while the file stays mapped.
+	static bool load(const std::string & path, MappedFile & file, MeshView & mesh, SourceStamp & stamp);
+
+	/// Update the source stamp of an existing cache file in place.
+	static bool restamp(const std::string & path, const SourceStamp & stamp);
+
+	/// 64-bit FNV-1a hash of a buffer. Pass the hash of the previous data to hash content in multiple parts.
+	static uint64_t hash(const char * data, size_t size, uint64_t previous = 14695981039346656037ULL);
+
+};
+
+#endif
@@ -1,81 +1,453 @@
 #include "MeshUtilities.hpp"
 #include "../helpers/Logger.hpp"
+#include "ByteSource.hpp"
+#include <glm/gtc/packing.hpp>
 #include <fstream>
 #include <sstream>
+#include <iterator>
+#include <algorithm>
 #include <cstddef>
-#include <map>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <limits>
+
+// The tangent frame orthogonalization is vectorized with SSE2 when available.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_UTILITIES_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
-void MeshUtilities::loadObj( std::istream & in, Mesh & mesh, MeshUtilities::LoadMode mode){
+/// OBJ text scanning helpers.
+/// They all work in place on the file buffer, without any allocation.
+
+/// A face corner, storing the raw one-based position, uv and normal indices.
+struct ObjCorner {
+	long position;
+	long texcoord;
+	long normal;
 	
-	//Init the mesh.
-	mesh.indices.clear();
-	mesh.positions.clear();
-	mesh.normals.clear();
-	mesh.texcoords.clear();
-	// Init temporary vectors.
-	vector<glm::vec3> positions_temp;
-	vector<glm::vec3> normals_temp;
-	vector<glm::vec2> texcoords_temp;
-	vector<string> faces_temp;
+	bool operator==(const ObjCorner & other) const {
+		return position == other.position && texcoord == other.texcoord && normal == other.normal;
+	}
+};
+
+/// Hash a face corner, mixing its three indices.
+static inline size_t hashCorner(const ObjCorner & corner){
+	unsigned long long hash = (unsigned long long)(corner.position) * 0x9E3779B97F4A7C15ull;
+	hash = (hash ^ (hash >> 29) ^ (unsigned long long)(corner.texcoord)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 32) ^ (unsigned long long)(corner.normal)) * 0x94D049BB133111EBull;
+	return size_t(hash ^ (hash >> 31));
+}
+
+static inline bool isBlank(const char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool isDigit(const char c){
+	return c >= '0' && c <= '9';
+}
+
+static inline const char * skipBlanks(const char * cur, const char * end){
+	while(cur < end && isBlank(*cur)){
+		++cur;
+	}
+	return cur;
+}
 
-	string res;
+static inline const char * skipToken(const char * cur, const char * end){
+	while(cur < end && !isBlank(*cur)){
+		++cur;
+	}
+	return cur;
+}
 
-	// Iterate over the lines of the file.
-	while(!in.eof()){
-		getline(in,res);
+/// Parse a float from a token. Common decimal values are converted directly,
+/// others (too many digits, large exponents, inf/nan,...) are delegated to strtof,
+/// so that the result is always identical to std::stof.
+static float parseFloat(const char * begin, const char * end){
+	// Exact powers of ten in single precision.
+	static const float powers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+	
+	const char * cur = begin;
+	bool negative = false;
+	if(cur < end && (*cur == '-' || *cur == '+')){
+		negative = (*cur == '-');
+		++cur;
+	}
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool valid = false;
+	// Integral part.
+	while(cur < end && isDigit(*cur)){
+		mantissa = mantissa * 10 + (*cur - '0');
+		digits += (mantissa != 0);
+		valid = true;
+		++cur;
+	}
+	// Fractional part.
+	if(cur < end && *cur == '.'){
+		++cur;
+		while(cur < end && isDigit(*cur)){
+			mantissa = mantissa * 10 + (*cur - '0');
+			digits += (mantissa != 0);
+			--exponent;
+			valid = true;
+			++cur;
+		}
+	}
+	// Optional exponent.
+	if(valid && cur < end && (*cur == 'e' || *cur == 'E')){
+		const char * expCur = cur + 1;
+		bool expNegative = false;
+		if(expCur < end && (*expCur == '-' || *expCur == '+')){
+			expNegative = (*expCur == '-');
+			++expCur;
+		}
+		if(expCur < end && isDigit(*expCur)){
+			int expValue = 0;
+			while(expCur < end && isDigit(*expCur) && expValue < 1000){
+				expValue = expValue * 10 + (*expCur - '0');
+				++expCur;
+			}
+			exponent += expNegative ? -expValue : expValue;
+			cur = expCur;
+		}
+	}
+	
+	// Fast path: both the mantissa and the power of ten are exactly representable,
+	// a single multiplication/division is then correctly rounded.
+	const bool trailingGarbage = (cur < end) && (*cur == 'x' || *cur == 'X' || isDigit(*cur) || *cur == '.' || *cur == 'e' || *cur == 'E');
+	if(valid && !trailingGarbage && digits <= 8 && mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10){
+		float value = float(mantissa);
+		value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+		return negative ? -value : value;
+	}
+	
+	// Slow path, on a null-terminated copy of the token.
+	char buffer[64];
+	const size_t length = std::min(size_t(end - begin), sizeof(buffer) - 1);
+	std::memcpy(buffer, begin, length);
+	buffer[length] = '\0';
+	return std::strtof(buffer, NULL);
+}
+
+/// Parse a (possibly signed) integer, advancing the cursor.
+static long parseInt(const char * & cur, const char * end){
+	bool negative = false;
+	if(cur < end && (*cur == '-' || *cur == '+')){
+		negative = (*cur == '-');
+		++cur;
+	}
+	long value = 0;
+	while(cur < end && isDigit(*cur)){
+		value = value * 10 + (*cur - '0');
+		++cur;
+	}
+	return negative ? -value : value;
+}
 
+/// Parse a face corner "p", "p/t", "p//n" or "p/t/n".
+/// As in previous versions, a missing normal index falls back to the last index present.
+static ObjCorner parseCorner(const char * cur, const char * end){
+	ObjCorner corner;
+	corner.position = parseInt(cur, end);
+	corner.texcoord = corner.position;
+	corner.normal = corner.position;
+	if(cur < end && *cur == '/'){
+		++cur;
+		corner.texcoord = (cur < end && *cur == '/') ? 0 : parseInt(cur, end);
+		corner.normal = corner.texcoord;
+		if(cur < end && *cur == '/'){
+			++cur;
+			corner.normal = parseInt(cur, end);
+		}
+	}
+	return corner;
+}
+
+/// Fetch an attribute from a one-based index, with a default value for invalid indices.
+template<typename T>
+static inline const T & objAttribute(const std::vector<T> & values, const long index){
+	static const T defaultValue(0.0f);
+	return (index > 0 && size_t(index) <= values.size()) ? values[size_t(index) - 1] : defaultValue;
+}
+
+/// Raw elements of a contiguous range of lines of an OBJ file.
+struct ObjChunk {
+	vector<glm::vec3> positions;
+	vector<glm::vec3> normals;
+	vector<glm::vec2> texcoords;
+	vector<ObjCorner> corners;
+	/// Corners using relative (negative) indices, with a bit mask of the relative components.
+	/// They are resolved against the chunk local counts, and offset when stitching the chunks.
+	vector<std::pair<size_t, unsigned char>> relativeCorners;
+};
+
+/// Parse all lines between begin and end. The range should start at the beginning of a line.
+static void parseObjChunk(const char * begin, const char * end, ObjChunk & chunk){
+	
+	// Rough estimation of the element counts, one element per ~32 bytes.
+	const size_t size = size_t(end - begin);
+	chunk.positions.reserve(size / 96);
+	chunk.corners.reserve(size / 32);
+	
+	const char * cur = begin;
+	// Each line can hold at most 4 tokens that we care about.
+	const char * tokens[4];
+	const char * tokensEnd[4];
+	
+	// Iterate over the lines of the buffer.
+	while(cur < end){
+		const char * lineEnd = static_cast<const char *>(std::memchr(cur, '\n', size_t(end - cur)));
+		if(lineEnd == NULL){
+			lineEnd = end;
+		}
+		const char * lineBegin = cur;
+		cur = lineEnd + 1;
+		
 		// Ignore the line if it is too short or a comment.
-		if(res.empty() || res[0] == '#' || res.size()<2){
+		if(lineEnd - lineBegin < 2 || *lineBegin == '#'){
 			continue;
 		}
-		//We want to split the content of the line at spaces, use a stringstream directly
-		stringstream ss(res);
-		vector<string> tokens;
-		string token;
-		while(ss >> token){
-			tokens.push_back(token);
+		// Split the content of the line at blanks, only keeping the first tokens.
+		size_t tokenCount = 0;
+		const char * tokenCur = skipBlanks(lineBegin, lineEnd);
+		while(tokenCur < lineEnd && tokenCount < 4){
+			tokens[tokenCount] = tokenCur;
+			tokenCur = skipToken(tokenCur, lineEnd);
+			tokensEnd[tokenCount] = tokenCur;
+			++tokenCount;
+			tokenCur = skipBlanks(tokenCur, lineEnd);
 		}
-		if(tokens.size() < 1){
+		if(tokenCount < 1){
 			continue;
 		}
 		// Check what kind of element the line represent.
-		if (tokens[0] == "v") { // Vertex position
+		const size_t keyLength = size_t(tokensEnd[0] - tokens[0]);
+		const char * key = tokens[0];
+		
+		if(keyLength == 1 && key[0] == 'v'){ // Vertex position
 			// We need 3 coordinates.
-			if(tokens.size() < 4){
+			if(tokenCount < 4){
 				continue;
 			}
-			glm::vec3 pos = glm::vec3(stof(tokens[1],NULL),stof(tokens[2],NULL),stof(tokens[3],NULL));
-			positions_temp.push_back(pos);
+			chunk.positions.emplace_back(parseFloat(tokens[1], tokensEnd[1]), parseFloat(tokens[2], tokensEnd[2]), parseFloat(tokens[3], tokensEnd[3]));
 			
-		} else if (tokens[0] == "vn"){ // Vertex normal
+		} else if(keyLength == 2 && key[0] == 'v' && key[1] == 'n'){ // Vertex normal
 			// We need 3 coordinates.
-			if(tokens.size() < 4){
+			if(tokenCount < 4){
 				continue;
 			}
-			glm::vec3 nor = glm::vec3(stof(tokens[1],NULL),stof(tokens[2],NULL),stof(tokens[3],NULL));
-			normals_temp.push_back(nor);
+			chunk.normals.emplace_back(parseFloat(tokens[1], tokensEnd[1]), parseFloat(tokens[2], tokensEnd[2]), parseFloat(tokens[3], tokensEnd[3]));
 			
-		} else if (tokens[0] == "vt") { // Vertex UV
+		} else if(keyLength == 2 && key[0] == 'v' && key[1] == 't'){ // Vertex UV
 			// We need 2 coordinates.
-			if(tokens.size() < 3){
+			if(tokenCount < 3){
 				continue;
 			}
-			glm::vec2 uv = glm::vec2(stof(tokens[1],NULL),stof(tokens[2],NULL));
-			texcoords_temp.push_back(uv);
+			chunk.texcoords.emplace_back(parseFloat(tokens[1], tokensEnd[1]), parseFloat(tokens[2], tokensEnd[2]));
 			
-		} else if (tokens[0] == "f") { // Face indices.
+		} else if(keyLength == 1 && key[0] == 'f'){ // Face indices.
 			// We need 3 elements, each containing at most three indices.
-			if(tokens.size() < 4){
+			if(tokenCount < 4){
 				continue;
 			}
-			faces_temp.push_back(tokens[1]);
-			faces_temp.push_back(tokens[2]);
-			faces_temp.push_back(tokens[3]);
+			for(size_t tid = 1; tid < 4; ++tid){
+				ObjCorner corner = parseCorner(tokens[tid], tokensEnd[tid]);
+				// Resolve relative indices against the elements already parsed in this chunk.
+				unsigned char relative = 0;
+				if(corner.position < 0){
+					corner.position += long(chunk.positions.size()) + 1;
+					relative |= 1;
+				}
+				if(corner.texcoord < 0){
+					corner.texcoord += long(chunk.texcoords.size()) + 1;
+					relative |= 2;
+				}
+				if(corner.normal < 0){
+					corner.normal += long(chunk.normals.size()) + 1;
+					relative |= 4;
+				}
+				if(relative != 0){
+					chunk.relativeCorners.emplace_back(chunk.corners.size(), relative);
+				}
+				chunk.corners.push_back(corner);
+			}
+		}
+		// Ignore s, l, g, matl or others
+	}
+}
 
-		} else { // Ignore s, l, g, matl or others
-			continue;
+/// Copy a chunk array in the complete array, at the given offset.
+template<typename T>
+static inline void copyChunkArray(const vector<T> & chunkArray, vector<T> & array, const size_t offset){
+	if(!chunkArray.empty()){
+		std::copy(chunkArray.begin(), chunkArray.end(), array.begin() + offset);
+	}
+}
+
+void MeshUtilities::loadObj( std::istream & in, Mesh & mesh, MeshUtilities::LoadMode mode){
+	// Read the whole stream in a contiguous buffer and parse it in place.
+	const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	MeshUtilities::loadObj(content.data(), content.size(), mesh, mode);
+}
+
+/// Split a text range in chunks at line boundaries, parsed on up to 'threads' threads and appended to 'chunks'.
+/// Small ranges are parsed on the calling thread only.
+static void parseObjRange(const char * data, const size_t size, const unsigned int threads, vector<ObjChunk> & chunks){
+	const size_t minChunkSize = 256 * 1024;
+	const size_t chunkCount = std::max(size_t(1), std::min(size_t(threads), size / minChunkSize));
+	vector<const char *> bounds(chunkCount + 1, data + size);
+	bounds[0] = data;
+	for(size_t cid = 1; cid < chunkCount; ++cid){
+		const char * split = std::max(bounds[cid-1], data + (size * cid) / chunkCount);
+		const char * lineEnd = static_cast<const char *>(std::memchr(split, '\n', size_t(data + size - split)));
+		bounds[cid] = lineEnd == NULL ? data + size : lineEnd + 1;
+	}
+	
+	// Parse each chunk on its own thread.
+	const size_t first = chunks.size();
+	chunks.resize(first + chunkCount);
+	if(chunkCount == 1){
+		parseObjChunk(bounds[0], bounds[1], chunks[first]);
+	} else {
+		vector<std::thread> workers;
+		for(size_t cid = 0; cid < chunkCount; ++cid){
+			workers.emplace_back(parseObjChunk, bounds[cid], bounds[cid+1], std::ref(chunks[first + cid]));
+		}
+		for(auto & worker : workers){
+			worker.join();
+		}
+	}
+}
+
+/// Assemble the parsed chunks into the mesh structure.
+static void buildObjMesh(vector<ObjChunk> & chunks, Mesh & mesh, const MeshUtilities::LoadMode mode, const unsigned int threads);
+
+void MeshUtilities::loadObj(const char * data, const size_t size, Mesh & mesh, MeshUtilities::LoadMode mode, const unsigned int threads){
+	vector<ObjChunk> chunks;
+	parseObjRange(data, size, threads, chunks);
+	buildObjMesh(chunks, mesh, mode, threads);
+}
+
+void MeshUtilities::loadObj(ByteSource & source, Mesh & mesh, MeshUtilities::LoadMode mode, const unsigned int threads){
+	// Content already in memory is parsed in place.
+	if(source.data() != NULL){
+		MeshUtilities::loadObj(source.data(), source.size(), mesh, mode, threads);
+		return;
+	}
+	// Else parse the file by windows, only keeping the incomplete last line of each one for the next.
+	const size_t windowSize = std::max(1u, threads) * 4 * 1024 * 1024;
+	vector<char> window;
+	vector<ObjChunk> chunks;
+	size_t offset = 0;
+	size_t carried = 0;
+	while(offset < source.size()){
+		const size_t count = std::min(windowSize, source.size() - offset);
+		window.resize(carried + count);
+		if(source.read(offset, count, &window[carried]) != count){
+			Log::Error() << Log::Resources << "Unable to read OBJ content." << std::endl;
+			break;
+		}
+		offset += count;
+		// Fetch the next window while parsing.
+		source.readahead(offset, windowSize);
+		size_t parsed = window.size();
+		if(offset < source.size()){
+			while(parsed > 0 && window[parsed - 1] != '\n'){
+				--parsed;
+			}
+		}
+		if(parsed > 0){
+			parseObjRange(&window[0], parsed, threads, chunks);
+		}
+		carried = window.size() - parsed;
+		if(carried > 0){
+			std::memmove(&window[0], &window[parsed], carried);
+		}
+	}
+	buildObjMesh(chunks, mesh, mode, threads);
+}
+
+static void buildObjMesh(vector<ObjChunk> & chunks, Mesh & mesh, const MeshUtilities::LoadMode mode, const unsigned int threads){
+	
+	//Init the mesh.
+	mesh.indices.clear();
+	mesh.positions.clear();
+	mesh.normals.clear();
+	mesh.texcoords.clear();
+	
+	const size_t chunkCount = chunks.size();
+	if(chunkCount == 0){
+		return;
+	}
+	
+	// Stitch the chunks together.
+	vector<glm::vec3> positions_temp;
+	vector<glm::vec3> normals_temp;
+	vector<glm::vec2> texcoords_temp;
+	vector<ObjCorner> faces_temp;
+	if(chunkCount == 1){
+		positions_temp.swap(chunks[0].positions);
+		normals_temp.swap(chunks[0].normals);
+		texcoords_temp.swap(chunks[0].texcoords);
+		faces_temp.swap(chunks[0].corners);
+		// Relative indices can't point outside of the unique chunk.
+	} else {
+		// Prefix sums of the element counts give the offset of each chunk in the complete arrays.
+		vector<size_t> positionsOffsets(chunkCount + 1, 0);
+		vector<size_t> normalsOffsets(chunkCount + 1, 0);
+		vector<size_t> texcoordsOffsets(chunkCount + 1, 0);
+		vector<size_t> cornersOffsets(chunkCount + 1, 0);
+		for(size_t cid = 0; cid < chunkCount; ++cid){
+			positionsOffsets[cid+1] = positionsOffsets[cid] + chunks[cid].positions.size();
+			normalsOffsets[cid+1] = normalsOffsets[cid] + chunks[cid].normals.size();
+			texcoordsOffsets[cid+1] = texcoordsOffsets[cid] + chunks[cid].texcoords.size();
+			cornersOffsets[cid+1] = cornersOffsets[cid] + chunks[cid].corners.size();
+		}
+		positions_temp.resize(positionsOffsets[chunkCount]);
+		normals_temp.resize(normalsOffsets[chunkCount]);
+		texcoords_temp.resize(texcoordsOffsets[chunkCount]);
+		faces_temp.resize(cornersOffsets[chunkCount]);
+		
+		// Fix relative indices and copy each chunk at its offset, in parallel.
+		auto stitchChunk = [&](const size_t cid){
+			ObjChunk & chunk = chunks[cid];
+			for(const auto & relative : chunk.relativeCorners){
+				ObjCorner & corner = chunk.corners[relative.first];
+				corner.position += (relative.second & 1) ? long(positionsOffsets[cid]) : 0;
+				corner.texcoord += (relative.second & 2) ? long(texcoordsOffsets[cid]) : 0;
+				corner.normal += (relative.second & 4) ? long(normalsOffsets[cid]) : 0;
+			}
+			copyChunkArray(chunk.positions, positions_temp, positionsOffsets[cid]);
+			copyChunkArray(chunk.normals, normals_temp, normalsOffsets[cid]);
+			copyChunkArray(chunk.texcoords, texcoords_temp, texcoordsOffsets[cid]);
+			copyChunkArray(chunk.corners, faces_temp, cornersOffsets[cid]);
+			// Release the chunk memory early.
+			chunk = ObjChunk();
+		};
+		// Streamed files can have many more chunks than threads.
+		std::atomic<size_t> nextChunk(0);
+		auto stitchChunks = [&](){
+			for(size_t cid = nextChunk++; cid < chunkCount; cid = nextChunk++){
+				stitchChunk(cid);
+			}
+		};
+		const size_t workersCount = std::min(chunkCount, size_t(std::max(1u, threads)));
+		vector<std::thread> workers;
+		for(size_t wid = 1; wid < workersCount; ++wid){
+			workers.emplace_back(stitchChunks);
+		}
+		stitchChunks();
+		for(auto & worker : workers){
+			worker.join();
 		}
 	}
 
@@ -104,27 +476,26 @@ void MeshUtilities::loadObj( std::istream & in, Mesh & mesh, MeshUtilities::Load
 	} else if(mode == MeshUtilities::Expanded){
 		// Mode: Expanded
 		// In this mode, vertices are all duplicated. Each face has its set of 3 vertices, not shared with any other face.
+		mesh.positions.reserve(faces_temp.size());
+		mesh.texcoords.reserve(hasUV ? faces_temp.size() : 0);
+		mesh.normals.reserve(hasNormals ? faces_temp.size() : 0);
+		mesh.indices.reserve(faces_temp.size());
 		
 		// For each face, query the needed positions, normals and uvs, and add them to the mesh structure.
 		for(size_t i = 0; i < faces_temp.size(); i++){
-			string str = faces_temp[i];
-			size_t foundF = str.find_first_of("/");
-			size_t foundL = str.find_last_of("/");
+			const ObjCorner & corner = faces_temp[i];
 			
 			// Positions (we are sure they exist).
-			long ind1 = stol(str.substr(0,foundF))-1;
-			mesh.positions.push_back(positions_temp[ind1]);
+			mesh.positions.push_back(objAttribute(positions_temp, corner.position));
 
 			// UVs (second index).
 			if(hasUV){
-				long ind2 = stol(str.substr(foundF+1,foundL))-1;
-				mesh.texcoords.push_back(texcoords_temp[ind2]);
+				mesh.texcoords.push_back(objAttribute(texcoords_temp, corner.texcoord));
 			}
 
 			// Normals (third index, in all cases).
 			if(hasNormals){
-				long ind3 = stol(str.substr(foundL+1))-1;
-				mesh.normals.push_back(normals_temp[ind3]);
+				mesh.normals.push_back(objAttribute(normals_temp, corner.normal));
 			}
 			
 			//Indices (simply a vector of increasing integers).
@@ -135,53 +506,57 @@ void MeshUtilities::loadObj( std::istream & in, Mesh & mesh, MeshUtilities::Load
 		// Mode: Indexed
 		// In this mode, vertices are only duplicated if they were already used in a previous face with a different set of uv/normal coordinates.
 		
-		// Keep track of previously encountered (position,uv,normal).
-		map<string,unsigned int> indices_used;
+		// Keep track of previously encountered (position,uv,normal) in an open-addressing hash table.
+		// Each slot stores the first corner using a given association, the corresponding vertex is the one
+		// that was created for this corner. The table is sized from the corner count, for a load factor below 2/3.
+		const unsigned int emptySlot = 0xFFFFFFFF;
+		size_t capacity = 16;
+		while(capacity < faces_temp.size() + faces_temp.size() / 2){
+			capacity <<= 1;
+		}
+		const size_t mask = capacity - 1;
+		vector<unsigned int> indices_used(capacity, emptySlot);
+		mesh.indices.reserve(faces_temp.size());
 
 		//Positions
 		unsigned int maxInd = 0;
 		for(size_t i = 0; i < faces_temp.size(); i++){
 			
-			string str = faces_temp[i];
+			const ObjCorner & corner = faces_temp[i];
 
+			// Linear probing until we find the association or an empty slot.
+			size_t slot = hashCorner(corner) & mask;
+			while(indices_used[slot] != emptySlot && !(faces_temp[indices_used[slot]] == corner)){
+				slot = (slot + 1) & mask;
+			}
+			
 			//Does the association of attributs already exists ?
-			if(indices_used.count(str)>0){
+			if(indices_used[slot] != emptySlot){
 				// Just store the index in the indices vector.
-				mesh.indices.push_back(indices_used[str]);
+				mesh.indices.push_back(mesh.indices[indices_used[slot]]);
 				// Go to next face.
 				continue;
 			}
 
 			// else, query the associated position/uv/normal, store it, update the indices vector and the list of used elements.
-			size_t foundF = str.find_first_of("/");
-			size_t foundL = str.find_last_of("/");
-			
 			//Positions (we are sure they exist)
-			unsigned int ind1 = stoi(str.substr(0,foundF))-1;
-			mesh.positions.push_back(positions_temp[ind1]);
+			mesh.positions.push_back(objAttribute(positions_temp, corner.position));
 
 			//UVs (second index)
 			if(hasUV){
-				unsigned int ind2 = stoi(str.substr(foundF+1,foundL))-1;
-				mesh.texcoords.push_back(texcoords_temp[ind2]);
+				mesh.texcoords.push_back(objAttribute(texcoords_temp, corner.texcoord));
 			}
 			//Normals (third index, in all cases)
 			if(hasNormals){
-				unsigned int ind3 = stoi(str.substr(foundL+1))-1;
-				mesh.normals.push_back(normals_temp[ind3]);
+				mesh.normals.push_back(objAttribute(normals_temp, corner.normal));
 			}
 
 			mesh.indices.push_back(maxInd);
-			indices_used[str] = maxInd;
+			indices_used[slot] = (unsigned int)i;
 			maxInd++;
 		}
-		indices_used.clear();
 	}
 
-	positions_temp.clear();
-	normals_temp.clear();
-	texcoords_temp.clear();
-	faces_temp.clear();
 	Log::Info() << Log::Verbose << Log::Resources << "Mesh loaded with " << mesh.indices.size()/3 << " faces, " << mesh.positions.size() << " vertices, " << mesh.normals.size() << " normals, " << mesh.texcoords.size() << " texcoords." << std::endl;
 }
 
@@ -211,55 +586,857 @@ void MeshUtilities::centerAndUnitMesh(Mesh & mesh){
 
 }
 
-void MeshUtilities::computeTangentsAndBinormals(Mesh & mesh){
+/// Split [0, count) in contiguous ranges processed by 'threads' threads, the calling thread taking the first one.
+template<typename F>
+static void parallelRanges(const size_t count, const size_t threads, F function){
+	if(threads <= 1){
+		function(size_t(0), count, size_t(0));
+		return;
+	}
+	vector<std::thread> workers;
+	for(size_t tid = 1; tid < threads; ++tid){
+		workers.emplace_back(function, (count * tid) / threads, (count * (tid + 1)) / threads, tid);
+	}
+	function(size_t(0), count / threads, size_t(0));
+	for(auto & worker : workers){
+		worker.join();
+	}
+}
+
+/// Accumulate the tangent and binormal of the faces [begin, end) on their vertices.
+static void accumulateTangents(const Mesh & mesh, const size_t begin, const size_t end, glm::vec3 * tangents, glm::vec3 * binormals){
+	for(size_t fid = 3 * begin; fid < 3 * end; fid += 3){
+		const unsigned int i0 = mesh.indices[fid];
+		const unsigned int i1 = mesh.indices[fid+1];
+		const unsigned int i2 = mesh.indices[fid+2];
+		
+		// Delta positions and uvs.
+		const glm::vec3 deltaPosition1 = mesh.positions[i1] - mesh.positions[i0];
+		const glm::vec3 deltaPosition2 = mesh.positions[i2] - mesh.positions[i0];
+		const glm::vec2 deltaUv1 = mesh.texcoords[i1] - mesh.texcoords[i0];
+		const glm::vec2 deltaUv2 = mesh.texcoords[i2] - mesh.texcoords[i0];
+		
+		// Compute tangent and binormal for the face.
+		const float det = 1.0f / (deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x);
+		const glm::vec3 tangent = det * (deltaPosition1 * deltaUv2.y - deltaPosition2 * deltaUv1.y);
+		const glm::vec3 binormal = det * (deltaPosition2 * deltaUv1.x - deltaPosition1 * deltaUv2.x);
+		
+		// Accumulate them. We don't normalize to get a free weighting based on the size of the face.
+		tangents[i0] += tangent;
+		tangents[i1] += tangent;
+		tangents[i2] += tangent;
+		binormals[i0] += binormal;
+		binormals[i1] += binormal;
+		binormals[i2] += binormal;
+	}
+}
+
+/// Scalar orthogonalization of the tangent against the normal, and orientation along the binormal.
+static inline void orthogonalizeTangent(const glm::vec3 & normal, glm::vec3 & tangent, const glm::vec3 & binormal){
+	tangent = normalize(tangent - normal * dot(normal, tangent));
+	if(dot(cross(normal, tangent), binormal) < 0.0f){
+		tangent *= -1.0f;
+	}
+}
+
+#ifdef MESH_UTILITIES_SSE2
+
+/// Load four consecutive vec3 as three registers of x, y and z components.
+static inline void loadVec3x4(const glm::vec3 * v, __m128 & x, __m128 & y, __m128 & z){
+	const float * f = &v[0].x;
+	const __m128 a = _mm_loadu_ps(f);
+	const __m128 b = _mm_loadu_ps(f + 4);
+	const __m128 c = _mm_loadu_ps(f + 8);
+	x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+}
+
+/// Store three registers of x, y and z components as four consecutive vec3.
+static inline void storeVec3x4(glm::vec3 * v, const __m128 x, const __m128 y, const __m128 z){
+	float * f = &v[0].x;
+	_mm_storeu_ps(f, _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0,0,0,0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0)));
+	_mm_storeu_ps(f + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1,1,1,1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0)));
+	_mm_storeu_ps(f + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3,3,2,2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0)));
+}
+
+/// Orthogonalize four tangents at once, with the same operations order as the scalar version.
+static inline void orthogonalizeTangentsx4(const glm::vec3 * normals, glm::vec3 * tangents, const glm::vec3 * binormals){
+	__m128 nx, ny, nz, tx, ty, tz, bx, by, bz;
+	loadVec3x4(normals, nx, ny, nz);
+	loadVec3x4(tangents, tx, ty, tz);
+	loadVec3x4(binormals, bx, by, bz);
+	// t = t - n * dot(n,t)
+	const __m128 nt = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+	tx = _mm_sub_ps(tx, _mm_mul_ps(nx, nt));
+	ty = _mm_sub_ps(ty, _mm_mul_ps(ny, nt));
+	tz = _mm_sub_ps(tz, _mm_mul_ps(nz, nt));
+	// t = normalize(t)
+	const __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz));
+	const __m128 invLen = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len2));
+	tx = _mm_mul_ps(tx, invLen);
+	ty = _mm_mul_ps(ty, invLen);
+	tz = _mm_mul_ps(tz, invLen);
+	// Flip if dot(cross(n,t), b) < 0.
+	const __m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(ty, nz));
+	const __m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(tz, nx));
+	const __m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(tx, ny));
+	const __m128 orientation = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, bx), _mm_mul_ps(cy, by)), _mm_mul_ps(cz, bz));
+	const __m128 signMask = _mm_and_ps(_mm_cmplt_ps(orientation, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+	storeVec3x4(tangents, _mm_xor_ps(tx, signMask), _mm_xor_ps(ty, signMask), _mm_xor_ps(tz, signMask));
+}
+
+#endif
+
+void MeshUtilities::computeTangentsAndBinormals(Mesh & mesh, const unsigned int threads){
 	if(mesh.indices.size() * mesh.positions.size() * mesh.texcoords.size() == 0){
 		// Missing data, or not the right mode (Points).
 		return;
 	}
+	const size_t verticesCount = mesh.positions.size();
+	const size_t facesCount = mesh.indices.size() / 3;
 	// Start by filling everything with 0 (as we want to accumulate tangents and binormals coming from different faces for each vertex).
-	for(size_t pid = 0; pid < mesh.positions.size(); ++pid){
-		mesh.tangents.push_back(glm::vec3(0.0f));
-		mesh.binormals.push_back(glm::vec3(0.0f));
-	}
+	mesh.tangents.assign(verticesCount, glm::vec3(0.0f));
+	mesh.binormals.assign(verticesCount, glm::vec3(0.0f));
+	
+	// Small meshes are processed on the calling thread only.
+	const size_t minFacesPerThread = 64 * 1024;
+	const size_t threadsCount = std::max(size_t(1), std::min(size_t(threads), facesCount / minFacesPerThread));
+	
 	// Then, compute both vectors for each face and accumulate them.
-	for(size_t fid = 0; fid < mesh.indices.size(); fid += 3){
+	// Each thread accumulates a range of faces in its own buffers, that are then summed.
+	vector<vector<glm::vec3>> localTangents(threadsCount - 1);
+	vector<vector<glm::vec3>> localBinormals(threadsCount - 1);
+	parallelRanges(facesCount, threadsCount, [&](const size_t begin, const size_t end, const size_t tid){
+		if(tid == 0){
+			accumulateTangents(mesh, begin, end, &mesh.tangents[0], &mesh.binormals[0]);
+			return;
+		}
+		localTangents[tid - 1].assign(verticesCount, glm::vec3(0.0f));
+		localBinormals[tid - 1].assign(verticesCount, glm::vec3(0.0f));
+		accumulateTangents(mesh, begin, end, &localTangents[tid - 1][0], &localBinormals[tid - 1][0]);
+	});
+	
+	// Finally, sum the partial results, and enforce orthogonality and good orientation of the basis.
+	const bool hasNormals = mesh.normals.size() == verticesCount;
+	parallelRanges(verticesCount, threadsCount, [&](const size_t begin, const size_t end, const size_t){
+		for(size_t lid = 0; lid < localTangents.size(); ++lid){
+			for(size_t vid = begin; vid < end; ++vid){
+				mesh.tangents[vid] += localTangents[lid][vid];
+				mesh.binormals[vid] += localBinormals[lid][vid];
+			}
+		}
+		if(!hasNormals){
+			for(size_t vid = begin; vid < end; ++vid){
+				mesh.tangents[vid] = normalize(mesh.tangents[vid]);
+			}
+			return;
+		}
+		size_t vid = begin;
+#ifdef MESH_UTILITIES_SSE2
+		for(; vid + 4 <= end; vid += 4){
+			orthogonalizeTangentsx4(&mesh.normals[vid], &mesh.tangents[vid], &mesh.binormals[vid]);
+		}
+#endif
+		for(; vid < end; ++vid){
+			orthogonalizeTangent(mesh.normals[vid], mesh.tangents[vid], mesh.binormals[vid]);
+		}
+	});
+	Log::Info() << Log::Verbose << Log::Resources << "Mesh: " << mesh.tangents.size() << " tangents and binormals computed." << std::endl;
+}
 
-		// Get the vertices of the face.
-		glm::vec3 & v0 = mesh.positions[mesh.indices[fid]];
-		glm::vec3 & v1 = mesh.positions[mesh.indices[fid+1]];
-		glm::vec3 & v2 = mesh.positions[mesh.indices[fid+2]];
-		// Get the uvs of the face.
-		glm::vec2 & uv0 = mesh.texcoords[mesh.indices[fid]];
-		glm::vec2 & uv1 = mesh.texcoords[mesh.indices[fid+1]];
-		glm::vec2 & uv2 = mesh.texcoords[mesh.indices[fid+2]];
+/// Octahedral encoding of a unit vector on the [-1,1]^2 square.
+static glm::vec2 encodeOctahedral(const glm::vec3 & n){
+	const float norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	// Also catches degenerate (NaN) tangents.
+	if(!(norm > 0.0f)){
+		return glm::vec2(0.0f);
+	}
+	const glm::vec3 p = n / norm;
+	if(p.z >= 0.0f){
+		return glm::vec2(p.x, p.y);
+	}
+	// Fold the lower hemisphere over the diagonals.
+	return glm::vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+}
 
-		// Delta positions and uvs.
-		glm::vec3 deltaPosition1 = v1 - v0;
-		glm::vec3 deltaPosition2 = v2 - v0;
-		glm::vec2 deltaUv1 = uv1 - uv0;
-		glm::vec2 deltaUv2 = uv2 - uv0;
+template<typename T>
+static T quantizeSnorm(const float value, const float scale){
+	return T(std::round(glm::clamp(value, -1.0f, 1.0f) * scale));
+}
 
-		// Compute tangent and binormal for the face.
-		float det = 1.0f / (deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x);
-    	glm::vec3 tangent = det * (deltaPosition1 * deltaUv2.y   - deltaPosition2 * deltaUv1.y);
-    	glm::vec3 binormal = det * (deltaPosition2 * deltaUv1.x   - deltaPosition1 * deltaUv2.x);
-
-    	// Accumulate them. We don't normalize to get a free weighting based on the size of the face.
-    	mesh.tangents[mesh.indices[fid]] += tangent;
-    	mesh.tangents[mesh.indices[fid+1]] += tangent;
-    	mesh.tangents[mesh.indices[fid+2]] += tangent;
-
-    	mesh.binormals[mesh.indices[fid]] += binormal;
-    	mesh.binormals[mesh.indices[fid+1]] += binormal;
-    	mesh.binormals[mesh.indices[fid+2]] += binormal;
-	}
-	// Finally, enforce orthogonality and good orientation of the basis.
-	for(size_t tid = 0; tid < mesh.tangents.size(); ++tid){
-		mesh.tangents[tid] = normalize(mesh.tangents[tid] - mesh.normals[tid] * dot(mesh.normals[tid], mesh.tangents[tid]));
-		if(dot(cross(mesh.normals[tid], mesh.tangents[tid]), mesh.binormals[tid]) < 0.0f){
-			mesh.tangents[tid] *= -1.0f;
- 		}
+void MeshUtilities::packVertices(const MeshView & mesh, std::vector<PackedVertex> & vertices){
+	const size_t count = mesh.positions.size;
+	vertices.resize(count);
+	const bool hasNormals = mesh.normals.size == count;
+	const bool hasUV = mesh.texcoords.size == count;
+	const bool hasTangents = hasNormals && mesh.tangents.size == count && mesh.binormals.size == count;
+	
+	for(size_t vid = 0; vid < count; ++vid){
+		PackedVertex & vertex = vertices[vid];
+		vertex.position = mesh.positions.data[vid];
+		
+		if(hasNormals){
+			const glm::vec2 normal = encodeOctahedral(mesh.normals.data[vid]);
+			vertex.normal = glm::i16vec2(quantizeSnorm<short>(normal.x, 32767.0f), quantizeSnorm<short>(normal.y, 32767.0f));
+		} else {
+			vertex.normal = glm::i16vec2(0);
+		}
+		
+		if(hasUV){
+			const glm::vec2 & uv = mesh.texcoords.data[vid];
+			vertex.texcoord = glm::u16vec2(glm::packHalf1x16(uv.x), glm::packHalf1x16(uv.y));
+		} else {
+			vertex.texcoord = glm::u16vec2(0);
+		}
+		
+		if(hasTangents){
+			const glm::vec3 & tangent = mesh.tangents.data[vid];
+			const glm::vec2 octTangent = encodeOctahedral(tangent);
+			// Handedness of the frame, used to rebuild the binormal.
+			const float sign = glm::dot(glm::cross(mesh.normals.data[vid], tangent), mesh.binormals.data[vid]) < 0.0f ? -1.0f : 1.0f;
+			vertex.tangent = glm::i8vec4(quantizeSnorm<signed char>(octTangent.x, 127.0f), quantizeSnorm<signed char>(octTangent.y, 127.0f), 0, quantizeSnorm<signed char>(sign, 127.0f));
+		} else {
+			vertex.tangent = glm::i8vec4(0, 0, 0, 127);
+		}
 	}
-	Log::Info() << Log::Verbose << Log::Resources << "Mesh: " << mesh.tangents.size() << " tangents and binormals computed." << std::endl;
 }
 
+void MeshUtilities::prepareUpload(MeshView & mesh, const bool packed, std::vector<PackedVertex> & vertices, std::vector<uint16_t> & shortIndices){
+	// Meshes with only positions wouldn't benefit from packing.
+	vertices.clear();
+	if(packed && mesh.normals.size > 0){
+		packVertices(mesh, vertices);
+	}
+	mesh.packedVertices = DataView<PackedVertex>(vertices);
+	
+	// All levels of detail share the same element buffer, halved when possible.
+	unsigned int maxIndex = 0;
+	for(size_t iid = 0; iid < mesh.indices.size; ++iid){
+		maxIndex = (std::max)(maxIndex, mesh.indices.data[iid]);
+	}
+	shortIndices.clear();
+	if(maxIndex <= 0xFFFF){
+		shortIndices.reserve(mesh.indices.size + mesh.lodIndices.size);
+		shortIndices.insert(shortIndices.end(), mesh.indices.data, mesh.indices.data + mesh.indices.size);
+		shortIndices.insert(shortIndices.end(), mesh.lodIndices.data, mesh.lodIndices.data + mesh.lodIndices.size);
+	}
+	mesh.shortIndices = DataView<uint16_t>(shortIndices);
+	
+	computeBoundingSphere(mesh.positions, mesh.center, mesh.radius);
+	mesh.prepared = true;
+}
+
+/// Vertex cache optimization, after Tom Forsyth's "Linear-speed vertex cache optimisation".
+
+static const unsigned int kForsythCacheSize = 32;
+
+/// Score of a vertex given its position in the simulated LRU cache and its number of remaining triangles.
+static float forsythVertexScore(const int cachePosition, const unsigned int remainingTriangles){
+	if(remainingTriangles == 0){
+		return -1.0f;
+	}
+	float score = 0.0f;
+	if(cachePosition >= 0){
+		if(cachePosition < 3){
+			// The last triangle vertices get a fixed score, to avoid favouring strips.
+			score = 0.75f;
+		} else {
+			const float scaler = 1.0f / float(kForsythCacheSize - 3);
+			score = std::pow(1.0f - float(cachePosition - 3) * scaler, 1.5f);
+		}
+	}
+	// Boost vertices with few triangles left, to finish them off.
+	score += 2.0f / std::sqrt(float(remainingTriangles));
+	return score;
+}
+
+/// Reorder a list of triangles for the vertex cache.
+static void reorderForVertexCache(vector<unsigned int> & indices, const size_t verticesCount){
+	const size_t trianglesCount = indices.size() / 3;
+	if(trianglesCount == 0){
+		return;
+	}
+	
+	// Vertex to triangles adjacency, stored contiguously.
+	vector<unsigned int> remaining(verticesCount, 0);
+	for(const unsigned int index : indices){
+		++remaining[index];
+	}
+	vector<unsigned int> adjacencyOffsets(verticesCount + 1, 0);
+	for(size_t vid = 0; vid < verticesCount; ++vid){
+		adjacencyOffsets[vid + 1] = adjacencyOffsets[vid] + remaining[vid];
+	}
+	vector<unsigned int> adjacency(indices.size());
+	{
+		vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for(size_t tid = 0; tid < trianglesCount; ++tid){
+			for(size_t k = 0; k < 3; ++k){
+				adjacency[fill[indices[3 * tid + k]]++] = (unsigned int)tid;
+			}
+		}
+	}
+	
+	// Initial vertex scores, triangle scores are only evaluated around the cache.
+	vector<int> cachePositions(verticesCount, -1);
+	vector<float> vertexScores(verticesCount);
+	for(size_t vid = 0; vid < verticesCount; ++vid){
+		vertexScores[vid] = forsythVertexScore(-1, remaining[vid]);
+	}
+	vector<bool> emitted(trianglesCount, false);
+	
+	vector<unsigned int> newIndices;
+	newIndices.reserve(indices.size());
+	// The cache has room for the vertices of the new triangle before trimming.
+	vector<unsigned int> cache;
+	cache.reserve(kForsythCacheSize + 3);
+	vector<unsigned int> newCache;
+	newCache.reserve(kForsythCacheSize + 3);
+	size_t scanCursor = 0;
+	long bestTriangle = -1;
+	
+	for(size_t emittedCount = 0; emittedCount < trianglesCount; ++emittedCount){
+		// Dead end: no candidate in the cache, restart from the first triangle left.
+		if(bestTriangle < 0){
+			while(emitted[scanCursor]){
+				++scanCursor;
+			}
+			bestTriangle = (long)scanCursor;
+		}
+		const size_t tid = (size_t)bestTriangle;
+		emitted[tid] = true;
+		
+		// Emit the triangle, update the adjacency and the cache.
+		newCache.clear();
+		for(size_t k = 0; k < 3; ++k){
+			const unsigned int vid = indices[3 * tid + k];
+			newIndices.push_back(vid);
+			// Remove the triangle from the vertex adjacency list.
+			unsigned int * begin = &adjacency[adjacencyOffsets[vid]];
+			unsigned int * end = begin + remaining[vid];
+			std::swap(*std::find(begin, end, (unsigned int)tid), *(end - 1));
+			--remaining[vid];
+			newCache.push_back(vid);
+		}
+		for(const unsigned int vid : cache){
+			if(vid != newCache[0] && vid != newCache[1] && vid != newCache[2]){
+				newCache.push_back(vid);
+			}
+		}
+		// Vertices pushed out of the cache.
+		for(size_t cid = kForsythCacheSize; cid < newCache.size(); ++cid){
+			cachePositions[newCache[cid]] = -1;
+			vertexScores[newCache[cid]] = forsythVertexScore(-1, remaining[newCache[cid]]);
+		}
+		newCache.resize(std::min(newCache.size(), size_t(kForsythCacheSize)));
+		std::swap(cache, newCache);
+		
+		// Update the scores of the cached vertices and their triangles, and find the best one.
+		for(size_t cid = 0; cid < cache.size(); ++cid){
+			const unsigned int vid = cache[cid];
+			cachePositions[vid] = (int)cid;
+			vertexScores[vid] = forsythVertexScore((int)cid, remaining[vid]);
+		}
+		float bestScore = -1.0f;
+		bestTriangle = -1;
+		for(const unsigned int vid : cache){
+			for(unsigned int aid = adjacencyOffsets[vid]; aid < adjacencyOffsets[vid] + remaining[vid]; ++aid){
+				const unsigned int otid = adjacency[aid];
+				const float score = vertexScores[indices[3*otid]] + vertexScores[indices[3*otid+1]] + vertexScores[indices[3*otid+2]];
+				if(score > bestScore){
+					bestScore = score;
+					bestTriangle = (long)otid;
+				}
+			}
+		}
+	}
+	indices.swap(newIndices);
+}
+
+void MeshUtilities::optimizeVertexCache(Mesh & mesh){
+	reorderForVertexCache(mesh.indices, mesh.positions.size());
+}
+
+/// Number of post-transform cache misses of the triangles [begin, end), with a FIFO cache.
+static size_t simulateFifoCache(const vector<unsigned int> & indices, size_t begin, size_t end, vector<unsigned int> & timestamps, unsigned int & time, const unsigned int cacheSize){
+	size_t misses = 0;
+	for(size_t iid = 3 * begin; iid < 3 * end; ++iid){
+		const unsigned int vid = indices[iid];
+		// A vertex is in the cache if it was inserted less than cacheSize insertions ago.
+		if(time - timestamps[vid] >= cacheSize){
+			timestamps[vid] = time++;
+			++misses;
+		}
+	}
+	return misses;
+}
+
+void MeshUtilities::optimizeOverdraw(Mesh & mesh, const float threshold){
+	const size_t trianglesCount = mesh.indices.size() / 3;
+	if(trianglesCount == 0){
+		return;
+	}
+	const unsigned int cacheSize = 16;
+	
+	// Hard boundaries: triangles where the cache is fully missed, that start a new strip of locality.
+	vector<size_t> hardBoundaries;
+	{
+		vector<unsigned int> timestamps(mesh.positions.size(), 0);
+		unsigned int time = cacheSize + 1;
+		for(size_t tid = 0; tid < trianglesCount; ++tid){
+			if(simulateFifoCache(mesh.indices, tid, tid + 1, timestamps, time, cacheSize) == 3){
+				hardBoundaries.push_back(tid);
+			}
+		}
+	}
+	hardBoundaries.push_back(trianglesCount);
+	
+	// Soft boundaries: split a hard cluster further as long as the cache efficiency stays close to its average.
+	vector<size_t> clusters;
+	for(size_t hid = 0; hid + 1 < hardBoundaries.size(); ++hid){
+		const size_t start = hardBoundaries[hid];
+		const size_t end = hardBoundaries[hid + 1];
+		vector<unsigned int> timestamps(mesh.positions.size(), 0);
+		unsigned int time = cacheSize + 1;
+		const float clusterACMR = float(simulateFifoCache(mesh.indices, start, end, timestamps, time, cacheSize)) / float(end - start);
+		
+		std::fill(timestamps.begin(), timestamps.end(), 0);
+		time = cacheSize + 1;
+		clusters.push_back(start);
+		size_t softStart = start;
+		size_t misses = 0;
+		for(size_t tid = start; tid < end; ++tid){
+			misses += simulateFifoCache(mesh.indices, tid, tid + 1, timestamps, time, cacheSize);
+			const float acmr = float(misses) / float(tid - softStart + 1);
+			if(tid + 1 < end && acmr <= clusterACMR * threshold){
+				clusters.push_back(tid + 1);
+				softStart = tid + 1;
+				misses = 0;
+				// Restart from an empty cache.
+				time += cacheSize + 1;
+			}
+		}
+	}
+	clusters.push_back(trianglesCount);
+	
+	// Area weighted centroid of the mesh.
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	vector<glm::vec3> clusterCentroids(clusters.size() - 1, glm::vec3(0.0f));
+	vector<glm::vec3> clusterNormals(clusters.size() - 1, glm::vec3(0.0f));
+	for(size_t cid = 0; cid + 1 < clusters.size(); ++cid){
+		float clusterArea = 0.0f;
+		for(size_t tid = clusters[cid]; tid < clusters[cid + 1]; ++tid){
+			const glm::vec3 & v0 = mesh.positions[mesh.indices[3*tid]];
+			const glm::vec3 & v1 = mesh.positions[mesh.indices[3*tid+1]];
+			const glm::vec3 & v2 = mesh.positions[mesh.indices[3*tid+2]];
+			const glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+			const float area = glm::length(normal);
+			clusterCentroids[cid] += (v0 + v1 + v2) * (area / 3.0f);
+			clusterNormals[cid] += normal;
+			clusterArea += area;
+		}
+		meshCentroid += clusterCentroids[cid];
+		meshArea += clusterArea;
+		clusterCentroids[cid] /= clusterArea > 0.0f ? clusterArea : 1.0f;
+	}
+	meshCentroid /= meshArea > 0.0f ? meshArea : 1.0f;
+	
+	// Draw first the clusters that face outwards, as they are more likely to occlude the others.
+	vector<float> sortKeys(clusters.size() - 1);
+	vector<size_t> order(clusters.size() - 1);
+	for(size_t cid = 0; cid + 1 < clusters.size(); ++cid){
+		const float normalLength = glm::length(clusterNormals[cid]);
+		sortKeys[cid] = normalLength > 0.0f ? glm::dot(clusterCentroids[cid] - meshCentroid, clusterNormals[cid] / normalLength) : 0.0f;
+		order[cid] = cid;
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b){
+		return sortKeys[a] > sortKeys[b];
+	});
+	
+	vector<unsigned int> newIndices;
+	newIndices.reserve(mesh.indices.size());
+	for(const size_t cid : order){
+		newIndices.insert(newIndices.end(), mesh.indices.begin() + 3 * clusters[cid], mesh.indices.begin() + 3 * clusters[cid + 1]);
+	}
+	mesh.indices.swap(newIndices);
+}
+
+template<typename T>
+static void remapAttribute(vector<T> & attribute, const vector<unsigned int> & remap, const size_t newCount){
+	if(attribute.size() != remap.size()){
+		return;
+	}
+	vector<T> newAttribute(newCount);
+	for(size_t vid = 0; vid < remap.size(); ++vid){
+		if(remap[vid] != 0xFFFFFFFF){
+			newAttribute[remap[vid]] = attribute[vid];
+		}
+	}
+	attribute.swap(newAttribute);
+}
+
+void MeshUtilities::optimizeVertexFetch(Mesh & mesh){
+	// Number vertices in order of first use, unused vertices are removed.
+	vector<unsigned int> remap(mesh.positions.size(), 0xFFFFFFFF);
+	unsigned int newCount = 0;
+	for(unsigned int & index : mesh.indices){
+		if(remap[index] == 0xFFFFFFFF){
+			remap[index] = newCount++;
+		}
+		index = remap[index];
+	}
+	// Levels of detail only use vertices of the full mesh.
+	for(unsigned int & index : mesh.lodIndices){
+		index = remap[index];
+	}
+	remapAttribute(mesh.positions, remap, newCount);
+	remapAttribute(mesh.normals, remap, newCount);
+	remapAttribute(mesh.texcoords, remap, newCount);
+	remapAttribute(mesh.tangents, remap, newCount);
+	remapAttribute(mesh.binormals, remap, newCount);
+}
+
+void MeshUtilities::analyzeVertexCache(const std::vector<unsigned int> & indices, const size_t verticesCount, const unsigned int cacheSize, float & acmr, float & atvr){
+	const size_t trianglesCount = indices.size() / 3;
+	vector<unsigned int> timestamps(verticesCount, 0);
+	unsigned int time = cacheSize + 1;
+	const size_t misses = simulateFifoCache(indices, 0, trianglesCount, timestamps, time, cacheSize);
+	acmr = trianglesCount > 0 ? float(misses) / float(trianglesCount) : 0.0f;
+	atvr = verticesCount > 0 ? float(misses) / float(verticesCount) : 0.0f;
+}
+
+void MeshUtilities::optimize(Mesh & mesh){
+	if(mesh.indices.empty()){
+		return;
+	}
+	float acmrBefore, atvrBefore, acmrAfter, atvrAfter;
+	analyzeVertexCache(mesh.indices, mesh.positions.size(), 16, acmrBefore, atvrBefore);
+	MeshUtilities::optimizeVertexCache(mesh);
+	MeshUtilities::optimizeOverdraw(mesh, 1.05f);
+	MeshUtilities::optimizeVertexFetch(mesh);
+	analyzeVertexCache(mesh.indices, mesh.positions.size(), 16, acmrAfter, atvrAfter);
+	Log::Info() << Log::Verbose << Log::Resources << "Mesh optimized: ACMR " << acmrBefore << " -> " << acmrAfter << ", ATVR " << atvrBefore << " -> " << atvrAfter << "." << std::endl;
+}
+
+/// Levels of detail generation, after Garland and Heckbert's "Surface simplification using quadric error metrics".
+
+/// Meshes or levels with less triangles are not simplified further.
+static const size_t kLodMinTriangles = 128;
+/// A level is only kept if it removes enough triangles from the previous one.
+static const float kLodMinReduction = 0.85f;
+
+/// Sum of the weighted squared distances to a set of planes, and the total weight of these planes.
+struct Quadric {
+	double xx, xy, xz, yy, yz, zz;
+	double x, y, z;
+	double c;
+	double weight;
+	
+	Quadric() : xx(0.0), xy(0.0), xz(0.0), yy(0.0), yz(0.0), zz(0.0), x(0.0), y(0.0), z(0.0), c(0.0), weight(0.0) {}
+	
+	/// Add the plane dot(n, p) + d = 0.
+	void addPlane(const glm::dvec3 & n, const double d, const double w){
+		xx += w * n.x * n.x; xy += w * n.x * n.y; xz += w * n.x * n.z;
+		yy += w * n.y * n.y; yz += w * n.y * n.z; zz += w * n.z * n.z;
+		x += w * n.x * d; y += w * n.y * d; z += w * n.z * d;
+		c += w * d * d;
+		weight += w;
+	}
+	
+	void add(const Quadric & q){
+		xx += q.xx; xy += q.xy; xz += q.xz; yy += q.yy; yz += q.yz; zz += q.zz;
+		x += q.x; y += q.y; z += q.z;
+		c += q.c;
+		weight += q.weight;
+	}
+	
+	/// Weighted squared distance from a point to all the planes.
+	double evaluate(const glm::vec3 & p) const {
+		const double px = p.x, py = p.y, pz = p.z;
+		const double e = xx * px * px + yy * py * py + zz * pz * pz + 2.0 * (xy * px * py + xz * px * pz + yz * py * pz)
+			+ 2.0 * (x * px + y * py + z * pz) + c;
+		return std::max(e, 0.0);
+	}
+};
+
+/// Candidate collapse of a vertex onto one of its neighbours.
+struct Collapse {
+	unsigned int from;
+	unsigned int to;
+	double cost;
+};
+
+/// Triangles using each vertex, stored contiguously.
+static void buildVertexTriangles(const vector<unsigned int> & indices, const size_t verticesCount, vector<unsigned int> & offsets, vector<unsigned int> & triangles){
+	offsets.assign(verticesCount + 1, 0);
+	for(const unsigned int index : indices){
+		++offsets[index + 1];
+	}
+	for(size_t vid = 0; vid < verticesCount; ++vid){
+		offsets[vid + 1] += offsets[vid];
+	}
+	triangles.resize(indices.size());
+	vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for(size_t iid = 0; iid < indices.size(); ++iid){
+		triangles[fill[indices[iid]]++] = (unsigned int)(iid / 3);
+	}
+}
+
+/// Check that collapsing a vertex doesn't flip any of its remaining triangles nor create non-manifold edges.
+static bool isCollapseValid(const Collapse & collapse, const vector<unsigned int> & indices, const vector<glm::vec3> & positions, const vector<unsigned int> & offsets, const vector<unsigned int> & triangles){
+	const unsigned int from = collapse.from;
+	const unsigned int to = collapse.to;
+	// The vertices opposite to the removed edge are the only ones allowed to be shared by both one-rings.
+	unsigned int opposites[2] = { from, from };
+	unsigned int oppositesCount = 0;
+	for(unsigned int aid = offsets[from]; aid < offsets[from + 1]; ++aid){
+		const unsigned int * tri = &indices[3 * triangles[aid]];
+		if(tri[0] != to && tri[1] != to && tri[2] != to){
+			continue;
+		}
+		if(oppositesCount == 2){
+			return false;
+		}
+		opposites[oppositesCount++] = tri[0] ^ tri[1] ^ tri[2] ^ from ^ to;
+	}
+	for(unsigned int aid = offsets[from]; aid < offsets[from + 1]; ++aid){
+		const unsigned int * tri = &indices[3 * triangles[aid]];
+		if(tri[0] == to || tri[1] == to || tri[2] == to){
+			continue;
+		}
+		// Normal before and after moving the vertex.
+		glm::vec3 corners[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+		const glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		for(size_t k = 0; k < 3; ++k){
+			if(tri[k] == from){
+				corners[k] = positions[to];
+			}
+		}
+		const glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		const float beforeLength = glm::length(before);
+		if(beforeLength > 0.0f && glm::dot(before, after) <= 0.25f * beforeLength * glm::length(after)){
+			return false;
+		}
+		// Neighbours of 'from' that are also neighbours of 'to' would end up with duplicated edges.
+		for(size_t k = 0; k < 3; ++k){
+			const unsigned int vid = tri[k];
+			if(vid == from || vid == opposites[0] || vid == opposites[1]){
+				continue;
+			}
+			for(unsigned int bid = offsets[to]; bid < offsets[to + 1]; ++bid){
+				const unsigned int * otri = &indices[3 * triangles[bid]];
+				if(otri[0] == vid || otri[1] == vid || otri[2] == vid){
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+/// Collapse a set of independent edges, cheapest first, until the target triangles count is reached.
+/// Return the number of collapses performed, and update the maximum error introduced.
+static size_t collapseEdges(vector<unsigned int> & indices, const vector<glm::vec3> & positions, const vector<bool> & locked, vector<Quadric> & quadrics, const size_t targetTriangles, double & maxError){
+	const size_t verticesCount = positions.size();
+	vector<unsigned int> offsets;
+	vector<unsigned int> triangles;
+	buildVertexTriangles(indices, verticesCount, offsets, triangles);
+	
+	// Find the cheapest collapse of each free vertex, evaluated at the position of the vertex it is collapsed on.
+	vector<Collapse> candidates(verticesCount);
+	for(size_t vid = 0; vid < verticesCount; ++vid){
+		candidates[vid].from = (unsigned int)vid;
+		candidates[vid].to = (unsigned int)vid;
+		candidates[vid].cost = std::numeric_limits<double>::max();
+	}
+	for(size_t iid = 0; iid < indices.size(); ++iid){
+		const unsigned int a = indices[iid];
+		const unsigned int b = indices[iid % 3 == 2 ? iid - 2 : iid + 1];
+		for(const unsigned int from : { a, b }){
+			const unsigned int to = from == a ? b : a;
+			if(locked[from] || from == to){
+				continue;
+			}
+			Quadric merged = quadrics[from];
+			merged.add(quadrics[to]);
+			const double cost = merged.weight > 0.0 ? merged.evaluate(positions[to]) / merged.weight : 0.0;
+			if(cost < candidates[from].cost){
+				candidates[from].to = to;
+				candidates[from].cost = cost;
+			}
+		}
+	}
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [](const Collapse & collapse){
+		return collapse.from == collapse.to;
+	}), candidates.end());
+	std::sort(candidates.begin(), candidates.end(), [](const Collapse & a, const Collapse & b){
+		return a.cost < b.cost;
+	});
+	
+	// Apply collapses whose neighbourhoods don't overlap, so that each one can be validated on the current triangles.
+	vector<bool> touched(verticesCount, false);
+	vector<unsigned int> remap(verticesCount);
+	for(size_t vid = 0; vid < verticesCount; ++vid){
+		remap[vid] = (unsigned int)vid;
+	}
+	size_t trianglesCount = indices.size() / 3;
+	size_t collapsesCount = 0;
+	for(const Collapse & collapse : candidates){
+		if(trianglesCount <= targetTriangles){
+			break;
+		}
+		if(touched[collapse.from] || touched[collapse.to] || !isCollapseValid(collapse, indices, positions, offsets, triangles)){
+			continue;
+		}
+		for(unsigned int aid = offsets[collapse.from]; aid < offsets[collapse.from + 1]; ++aid){
+			const unsigned int * tri = &indices[3 * triangles[aid]];
+			touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+			if(tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to){
+				--trianglesCount;
+			}
+		}
+		remap[collapse.from] = collapse.to;
+		quadrics[collapse.to].add(quadrics[collapse.from]);
+		maxError = std::max(maxError, collapse.cost);
+		++collapsesCount;
+	}
+	
+	// Update the triangles and remove the degenerate ones.
+	size_t newSize = 0;
+	for(size_t iid = 0; iid < indices.size(); iid += 3){
+		const unsigned int i0 = remap[indices[iid]];
+		const unsigned int i1 = remap[indices[iid+1]];
+		const unsigned int i2 = remap[indices[iid+2]];
+		if(i0 == i1 || i1 == i2 || i2 == i0){
+			continue;
+		}
+		indices[newSize++] = i0;
+		indices[newSize++] = i1;
+		indices[newSize++] = i2;
+	}
+	indices.resize(newSize);
+	return collapsesCount;
+}
+
+void MeshUtilities::generateLods(Mesh & mesh, const unsigned int maxLevels, const float ratio){
+	mesh.lodIndices.clear();
+	mesh.lods.clear();
+	const size_t verticesCount = mesh.positions.size();
+	if(mesh.indices.size() / 3 < kLodMinTriangles || maxLevels == 0){
+		return;
+	}
+	
+	// Find vertices sharing the same position (on attribute seams), they are locked to avoid cracks and texture distortions.
+	vector<unsigned int> order(verticesCount);
+	for(size_t vid = 0; vid < verticesCount; ++vid){
+		order[vid] = (unsigned int)vid;
+	}
+	std::sort(order.begin(), order.end(), [&mesh](const unsigned int a, const unsigned int b){
+		const glm::vec3 & pa = mesh.positions[a];
+		const glm::vec3 & pb = mesh.positions[b];
+		return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && pa.z < pb.z)));
+	});
+	vector<unsigned int> positionIds(verticesCount);
+	vector<bool> locked(verticesCount, false);
+	for(size_t begin = 0; begin < verticesCount;){
+		size_t end = begin + 1;
+		while(end < verticesCount && mesh.positions[order[end]] == mesh.positions[order[begin]]){
+			++end;
+		}
+		for(size_t oid = begin; oid < end; ++oid){
+			positionIds[order[oid]] = order[begin];
+			locked[order[oid]] = end - begin > 1;
+		}
+		begin = end;
+	}
+	
+	// Lock vertices on borders and non-manifold edges, that are not used by exactly two triangles.
+	vector<unsigned long long> edges;
+	edges.reserve(mesh.indices.size());
+	for(size_t iid = 0; iid < mesh.indices.size(); ++iid){
+		const unsigned long long a = positionIds[mesh.indices[iid]];
+		const unsigned long long b = positionIds[mesh.indices[iid % 3 == 2 ? iid - 2 : iid + 1]];
+		if(a != b){
+			edges.push_back(a < b ? ((a << 32) | b) : ((b << 32) | a));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for(size_t begin = 0; begin < edges.size();){
+		size_t end = begin + 1;
+		while(end < edges.size() && edges[end] == edges[begin]){
+			++end;
+		}
+		if(end - begin != 2){
+			locked[(unsigned int)(edges[begin] >> 32)] = true;
+			locked[(unsigned int)(edges[begin] & 0xFFFFFFFF)] = true;
+		}
+		begin = end;
+	}
+	
+	// Initial quadrics from the planes of the adjacent faces, weighted by area.
+	vector<Quadric> quadrics(verticesCount);
+	for(size_t iid = 0; iid < mesh.indices.size(); iid += 3){
+		const glm::dvec3 p0(mesh.positions[mesh.indices[iid]]);
+		const glm::dvec3 p1(mesh.positions[mesh.indices[iid+1]]);
+		const glm::dvec3 p2(mesh.positions[mesh.indices[iid+2]]);
+		const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const double length = glm::length(normal);
+		if(length == 0.0){
+			continue;
+		}
+		const glm::dvec3 n = normal / length;
+		for(size_t k = 0; k < 3; ++k){
+			quadrics[mesh.indices[iid+k]].addPlane(n, -glm::dot(n, p0), 0.5 * length);
+		}
+	}
+	
+	// Simplify progressively, each level starting from the previous one.
+	vector<unsigned int> indices = mesh.indices;
+	double maxError = 0.0;
+	size_t previousTriangles = indices.size() / 3;
+	while(mesh.lods.size() < maxLevels){
+		const size_t targetTriangles = size_t(float(previousTriangles) * ratio);
+		if(targetTriangles < kLodMinTriangles){
+			break;
+		}
+		bool stuck = false;
+		while(indices.size() / 3 > targetTriangles && !stuck){
+			stuck = collapseEdges(indices, mesh.positions, locked, quadrics, targetTriangles, maxError) == 0;
+		}
+		if(float(indices.size() / 3) > kLodMinReduction * float(previousTriangles)){
+			break;
+		}
+		vector<unsigned int> levelIndices = indices;
+		reorderForVertexCache(levelIndices, verticesCount);
+		mesh.lodIndices.insert(mesh.lodIndices.end(), levelIndices.begin(), levelIndices.end());
+		MeshLod lod;
+		lod.count = (unsigned int)levelIndices.size();
+		lod.error = float(std::sqrt(maxError));
+		mesh.lods.push_back(lod);
+		previousTriangles = indices.size() / 3;
+		if(stuck){
+			break;
+		}
+	}
+	
+	Log::Info() << Log::Verbose << Log::Resources << "Mesh: " << mesh.lods.size() << " levels of detail generated, down to " << (previousTriangles * 100 / (mesh.indices.size() / 3)) << "% of the triangles." << std::endl;
+}
+
+void MeshUtilities::computeBoundingSphere(const DataView<glm::vec3> & positions, glm::vec3 & center, float & radius){
+	center = glm::vec3(0.0f);
+	radius = 0.0f;
+	if(positions.size == 0){
+		return;
+	}
+	glm::vec3 mini = positions.data[0];
+	glm::vec3 maxi = positions.data[0];
+	for(size_t vid = 1; vid < positions.size; ++vid){
+		mini = glm::min(mini, positions.data[vid]);
+		maxi = glm::max(maxi, positions.data[vid]);
+	}
+	center = 0.5f * (mini + maxi);
+	for(size_t vid = 0; vid < positions.size; ++vid){
+		radius = std::max(radius, glm::distance(center, positions.data[vid]));
+	}
+}
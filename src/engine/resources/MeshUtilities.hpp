@@ -3,7 +3,18 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+class ByteSource;
+
+/// A simplified level of detail of a mesh.
+struct MeshLod {
+	unsigned int count; ///< Number of indices, stored after the ones of the previous levels.
+	float error; ///< Geometric error introduced by the simplification, in model units.
+};
 
 // A mesh will be represented by a struct. For now, material information and elements/groups are not retrieved from the .obj.
 typedef struct {
@@ -13,8 +24,58 @@ typedef struct {
 	std::vector<glm::vec3> binormals;
 	std::vector<glm::vec2> texcoords;
 	std::vector<unsigned int> indices;
+	std::vector<unsigned int> lodIndices; ///< Indices of the simplified levels of detail, finest first.
+	std::vector<MeshLod> lods;
 } Mesh;
 
+/// Non-owning view on a contiguous array.
+template<typename T>
+struct DataView {
+	const T * data;
+	size_t size;
+	
+	DataView() : data(NULL), size(0) {}
+	
+	DataView(const T * d, size_t s) : data(d), size(s) {}
+	
+	DataView(const std::vector<T> & array) : data(array.empty() ? NULL : &array[0]), size(array.size()) {}
+};
+
+/// Interleaved and quantized vertex (24 bytes): full precision position, octahedral-encoded normal (snorm16),
+/// half-float uv, and octahedral-encoded tangent (snorm8) with the sign of the binormal in w.
+struct PackedVertex {
+	glm::vec3 position;
+	glm::i16vec2 normal;
+	glm::u16vec2 texcoord;
+	glm::i8vec4 tangent;
+};
+
+static_assert(sizeof(PackedVertex) == 24, "Unexpected packed vertex size.");
+
+/// Non-owning view on mesh data, either stored in a Mesh or in a memory-mapped cache file.
+struct MeshView {
+	DataView<glm::vec3> positions;
+	DataView<glm::vec3> normals;
+	DataView<glm::vec3> tangents;
+	DataView<glm::vec3> binormals;
+	DataView<glm::vec2> texcoords;
+	DataView<unsigned int> indices;
+	DataView<unsigned int> lodIndices;
+	DataView<MeshLod> lods;
+	
+	/// Data derived for the upload by MeshUtilities::prepareUpload, so that the upload only has to issue GL calls.
+	bool prepared;
+	DataView<PackedVertex> packedVertices; ///< Empty if packing wasn't requested.
+	DataView<uint16_t> shortIndices; ///< The indices followed by the levels of detail ones, empty if they don't fit on 16 bits.
+	glm::vec3 center; ///< Bounding sphere.
+	float radius;
+	
+	MeshView() : prepared(false), center(0.0f), radius(0.0f) {}
+	
+	MeshView(const Mesh & mesh) : positions(mesh.positions), normals(mesh.normals), tangents(mesh.tangents),
+		binormals(mesh.binormals), texcoords(mesh.texcoords), indices(mesh.indices), lodIndices(mesh.lodIndices), lods(mesh.lods),
+		prepared(false), center(0.0f), radius(0.0f) {}
+};
 
 
 class MeshUtilities {
@@ -30,12 +91,51 @@ public:
 
 	/// Load an obj file from disk into the mesh structure.
 	static void loadObj(std::istream & in, Mesh & mesh, LoadMode mode);
+	
+	/// Load an obj file from a contiguous text buffer into the mesh structure, parsing it in place.
+	/// Big files are split at line boundaries and parsed on up to 'threads' threads.
+	static void loadObj(const char * data, size_t size, Mesh & mesh, LoadMode mode, unsigned int threads = 1);
+	
+	/// Load an obj file from a source, in place if it is in memory, else by windows of a few megabytes.
+	static void loadObj(ByteSource & source, Mesh & mesh, LoadMode mode, unsigned int threads = 1);
 
 	/// Center the mesh and scale it to fit in the [-1,1] box.
 	static void centerAndUnitMesh(Mesh & mesh);
 
-	/// Compute the tangents and binormal vectors for each vertex.
-	static void computeTangentsAndBinormals(Mesh & mesh);
+	/// Compute the tangents and binormal vectors for each vertex, using up to 'threads' threads for big meshes.
+	static void computeTangentsAndBinormals(Mesh & mesh, unsigned int threads = 1);
+	
+	/// Reorder, cluster and remap an indexed mesh for rendering efficiency.
+	static void optimize(Mesh & mesh);
+	
+	/// Reorder the triangles to maximize post-transform vertex cache hits (Forsyth's algorithm).
+	static void optimizeVertexCache(Mesh & mesh);
+	
+	/// Reorder clusters of triangles to reduce overdraw, outward-facing ones first.
+	/// The clusters are split while their cache miss ratio stays under 'threshold' times the original one.
+	static void optimizeOverdraw(Mesh & mesh, const float threshold);
+	
+	/// Reorder the vertices in order of first use by the indices, and remove unused ones.
+	static void optimizeVertexFetch(Mesh & mesh);
+	
+	/// Generate up to 'maxLevels' simplified levels of detail by quadric error edge collapses, each one having
+	/// about 'ratio' times the triangles of the previous one. Vertices are collapsed onto existing neighbours, so that all
+	/// levels share the vertex data. Vertices on borders and attribute seams are preserved.
+	static void generateLods(Mesh & mesh, const unsigned int maxLevels = 4, const float ratio = 0.5f);
+	
+	/// Bounding sphere of a set of positions, centered on their bounding box.
+	static void computeBoundingSphere(const DataView<glm::vec3> & positions, glm::vec3 & center, float & radius);
+	
+	/// Average cache miss ratio (per triangle) and average transformed vertex ratio (per vertex) with a FIFO cache.
+	static void analyzeVertexCache(const std::vector<unsigned int> & indices, const size_t verticesCount, const unsigned int cacheSize, float & acmr, float & atvr);
+	
+	/// Produce the interleaved packed vertex stream of a mesh. Missing attributes are set to 0.
+	/// The binormal is not stored, it should be reconstructed as tangent.w * cross(normal, tangent.xyz).
+	static void packVertices(const MeshView & mesh, std::vector<PackedVertex> & vertices);
+	
+	/// Compute the packed vertices (if requested and the mesh has normals), the 16 bits indices (if they fit) and the
+	/// bounding sphere of a mesh ahead of its upload. The derived arrays are stored in the given vectors, referenced by the view.
+	static void prepareUpload(MeshView & mesh, const bool packed, std::vector<PackedVertex> & vertices, std::vector<uint16_t> & shortIndices);
 	
 };
 
@@ -0,0 +1,253 @@
+#include "PixelKernels.hpp"
+#include <cstring>
+#include <algorithm>
+
+// The widest instruction set enabled for the target is used (see the premake --simd option), there is no runtime dispatch.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define PIXEL_KERNELS_SSSE3
+#include <tmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define PIXEL_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef PIXEL_KERNELS_SSE2
+
+/// Store four pixels given as registers of r, g and b components.
+static inline void storeRGBx4(float * f, const __m128 r, const __m128 g, const __m128 b){
+	_mm_storeu_ps(f, _mm_shuffle_ps(_mm_shuffle_ps(r, g, _MM_SHUFFLE(0,0,0,0)), _mm_shuffle_ps(b, r, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0)));
+	_mm_storeu_ps(f + 4, _mm_shuffle_ps(_mm_shuffle_ps(g, b, _MM_SHUFFLE(1,1,1,1)), _mm_shuffle_ps(r, g, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0)));
+	_mm_storeu_ps(f + 8, _mm_shuffle_ps(_mm_shuffle_ps(b, r, _MM_SHUFFLE(3,3,2,2)), _mm_shuffle_ps(g, b, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0)));
+}
+
+/// Load four pixels as registers of r, g and b components.
+static inline void loadRGBx4(const float * f, __m128 & r, __m128 & g, __m128 & b){
+	const __m128 p0 = _mm_loadu_ps(f);
+	const __m128 p1 = _mm_loadu_ps(f + 4);
+	const __m128 p2 = _mm_loadu_ps(f + 8);
+	r = _mm_shuffle_ps(p0, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+	g = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+	b = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1,1,2,2)), _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+}
+
+#endif
+
+#ifdef PIXEL_KERNELS_AVX2
+
+/// Same shuffles as the SSE2 versions in each 128-bit lane, the lanes hold pixels 0-3 and 4-7.
+static inline void storeRGBx8(float * f, const __m256 r, const __m256 g, const __m256 b){
+	const __m256 o0 = _mm256_shuffle_ps(_mm256_shuffle_ps(r, g, _MM_SHUFFLE(0,0,0,0)), _mm256_shuffle_ps(b, r, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0));
+	const __m256 o1 = _mm256_shuffle_ps(_mm256_shuffle_ps(g, b, _MM_SHUFFLE(1,1,1,1)), _mm256_shuffle_ps(r, g, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0));
+	const __m256 o2 = _mm256_shuffle_ps(_mm256_shuffle_ps(b, r, _MM_SHUFFLE(3,3,2,2)), _mm256_shuffle_ps(g, b, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0));
+	_mm256_storeu_ps(f, _mm256_permute2f128_ps(o0, o1, 0x20));
+	_mm256_storeu_ps(f + 8, _mm256_permute2f128_ps(o2, o0, 0x30));
+	_mm256_storeu_ps(f + 16, _mm256_permute2f128_ps(o1, o2, 0x31));
+}
+
+static inline void loadRGBx8(const float * f, __m256 & r, __m256 & g, __m256 & b){
+	const __m256 a = _mm256_loadu_ps(f);
+	const __m256 c = _mm256_loadu_ps(f + 8);
+	const __m256 e = _mm256_loadu_ps(f + 16);
+	// Gather pixels 0-3 in the low lanes and 4-7 in the high lanes.
+	const __m256 p0 = _mm256_permute2f128_ps(a, c, 0x30);
+	const __m256 p1 = _mm256_permute2f128_ps(a, e, 0x21);
+	const __m256 p2 = _mm256_permute2f128_ps(c, e, 0x30);
+	r = _mm256_shuffle_ps(p0, _mm256_shuffle_ps(p1, p2, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+	g = _mm256_shuffle_ps(_mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(0,0,1,1)), _mm256_shuffle_ps(p1, p2, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+	b = _mm256_shuffle_ps(_mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(1,1,2,2)), _mm256_shuffle_ps(p2, p2, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+}
+
+#endif
+
+void PixelKernels::interleaveRGB(const float * r, const float * g, const float * b, float * dst, const size_t count){
+	size_t i = 0;
+#if defined(PIXEL_KERNELS_AVX2)
+	for(; i + 8 <= count; i += 8){
+		storeRGBx8(dst + 3 * i, _mm256_loadu_ps(r + i), _mm256_loadu_ps(g + i), _mm256_loadu_ps(b + i));
+	}
+#elif defined(PIXEL_KERNELS_SSE2)
+	for(; i + 4 <= count; i += 4){
+		storeRGBx4(dst + 3 * i, _mm_loadu_ps(r + i), _mm_loadu_ps(g + i), _mm_loadu_ps(b + i));
+	}
+#endif
+	for(; i < count; ++i){
+		dst[3 * i + 0] = r[i];
+		dst[3 * i + 1] = g[i];
+		dst[3 * i + 2] = b[i];
+	}
+}
+
+void PixelKernels::interleaveRGB(const uint16_t * r, const uint16_t * g, const uint16_t * b, uint16_t * dst, const size_t count){
+	size_t i = 0;
+#ifdef PIXEL_KERNELS_SSSE3
+	// Byte shuffles placing each channel of 8 pixels in the three output registers, -1 for zero.
+	const __m128i r0 = _mm_setr_epi8(0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5, -1, -1);
+	const __m128i g0 = _mm_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5);
+	const __m128i b0 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1);
+	const __m128i r1 = _mm_setr_epi8(-1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, 10, 11);
+	const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1);
+	const __m128i b1 = _mm_setr_epi8(4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1);
+	const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1, -1, -1);
+	const __m128i g2 = _mm_setr_epi8(10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1);
+	const __m128i b2 = _mm_setr_epi8(-1, -1, 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15);
+	for(; i + 8 <= count; i += 8){
+		const __m128i rs = _mm_loadu_si128((const __m128i *)(r + i));
+		const __m128i gs = _mm_loadu_si128((const __m128i *)(g + i));
+		const __m128i bs = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i * out = (__m128i *)(dst + 3 * i);
+		_mm_storeu_si128(out + 0, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(rs, r0), _mm_shuffle_epi8(gs, g0)), _mm_shuffle_epi8(bs, b0)));
+		_mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(rs, r1), _mm_shuffle_epi8(gs, g1)), _mm_shuffle_epi8(bs, b1)));
+		_mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(rs, r2), _mm_shuffle_epi8(gs, g2)), _mm_shuffle_epi8(bs, b2)));
+	}
+#endif
+	for(; i < count; ++i){
+		dst[3 * i + 0] = r[i];
+		dst[3 * i + 1] = g[i];
+		dst[3 * i + 2] = b[i];
+	}
+}
+
+void PixelKernels::deinterleaveRGB(const float * src, float * r, float * g, float * b, const size_t count){
+	size_t i = 0;
+#if defined(PIXEL_KERNELS_AVX2)
+	for(; i + 8 <= count; i += 8){
+		__m256 rs, gs, bs;
+		loadRGBx8(src + 3 * i, rs, gs, bs);
+		_mm256_storeu_ps(r + i, rs);
+		_mm256_storeu_ps(g + i, gs);
+		_mm256_storeu_ps(b + i, bs);
+	}
+#elif defined(PIXEL_KERNELS_SSE2)
+	for(; i + 4 <= count; i += 4){
+		__m128 rs, gs, bs;
+		loadRGBx4(src + 3 * i, rs, gs, bs);
+		_mm_storeu_ps(r + i, rs);
+		_mm_storeu_ps(g + i, gs);
+		_mm_storeu_ps(b + i, bs);
+	}
+#endif
+	for(; i < count; ++i){
+		r[i] = src[3 * i + 0];
+		g[i] = src[3 * i + 1];
+		b[i] = src[3 * i + 2];
+	}
+}
+
+void PixelKernels::deinterleaveRGBA(const float * src, float * r, float * g, float * b, float * a, const size_t count){
+	size_t i = 0;
+#ifdef PIXEL_KERNELS_SSE2
+	// Four pixels form a 4x4 matrix, transposed into the four channels.
+	for(; i + 4 <= count; i += 4){
+		__m128 p0 = _mm_loadu_ps(src + 4 * i);
+		__m128 p1 = _mm_loadu_ps(src + 4 * i + 4);
+		__m128 p2 = _mm_loadu_ps(src + 4 * i + 8);
+		__m128 p3 = _mm_loadu_ps(src + 4 * i + 12);
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+		_mm_storeu_ps(r + i, p0);
+		_mm_storeu_ps(g + i, p1);
+		_mm_storeu_ps(b + i, p2);
+		_mm_storeu_ps(a + i, p3);
+	}
+#endif
+	for(; i < count; ++i){
+		r[i] = src[4 * i + 0];
+		g[i] = src[4 * i + 1];
+		b[i] = src[4 * i + 2];
+		a[i] = src[4 * i + 3];
+	}
+}
+
+void PixelKernels::copyOpaqueRGBA(const unsigned char * src, unsigned char * dst, const size_t count){
+	size_t i = 0;
+#if defined(PIXEL_KERNELS_AVX2)
+	// Alpha is the high byte of each little-endian pixel.
+	const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+	for(; i + 8 <= count; i += 8){
+		const __m256i pixels = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+		_mm256_storeu_si256((__m256i *)(dst + 4 * i), _mm256_or_si256(pixels, alpha));
+	}
+#elif defined(PIXEL_KERNELS_SSE2)
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	for(; i + 4 <= count; i += 4){
+		const __m128i pixels = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		_mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_or_si128(pixels, alpha));
+	}
+#endif
+	for(; i < count; ++i){
+		dst[4 * i + 0] = src[4 * i + 0];
+		dst[4 * i + 1] = src[4 * i + 1];
+		dst[4 * i + 2] = src[4 * i + 2];
+		dst[4 * i + 3] = 255;
+	}
+}
+
+/// Exchange the content of two non-overlapping rows.
+static inline void swapRows(unsigned char * a, unsigned char * b, const size_t size){
+	size_t i = 0;
+#if defined(PIXEL_KERNELS_AVX2)
+	for(; i + 32 <= size; i += 32){
+		const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(a + i), vb);
+		_mm256_storeu_si256((__m256i *)(b + i), va);
+	}
+#elif defined(PIXEL_KERNELS_SSE2)
+	for(; i + 16 <= size; i += 16){
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		_mm_storeu_si128((__m128i *)(a + i), vb);
+		_mm_storeu_si128((__m128i *)(b + i), va);
+	}
+#endif
+	// Remaining bytes, or the whole row without SIMD, by chunks.
+	unsigned char tmp[64];
+	while(i < size){
+		const size_t chunk = (std::min)(sizeof(tmp), size - i);
+		std::memcpy(tmp, a + i, chunk);
+		std::memcpy(a + i, b + i, chunk);
+		std::memcpy(b + i, tmp, chunk);
+		i += chunk;
+	}
+}
+
+void PixelKernels::flipRows(void * data, const size_t rowSize, const size_t rows){
+	unsigned char * bytes = (unsigned char *)data;
+	for(size_t y = 0; y < rows / 2; ++y){
+		swapRows(bytes + y * rowSize, bytes + (rows - 1 - y) * rowSize, rowSize);
+	}
+}
+
+void PixelKernels::accumulate(const float * src, const float weight, float * dst, const size_t count){
+	size_t i = 0;
+#if defined(PIXEL_KERNELS_AVX2)
+	const __m256 w8 = _mm256_set1_ps(weight);
+	for(; i + 8 <= count; i += 8){
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(w8, _mm256_loadu_ps(src + i))));
+	}
+#elif defined(PIXEL_KERNELS_SSE2)
+	const __m128 w4 = _mm_set1_ps(weight);
+	for(; i + 4 <= count; i += 4){
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w4, _mm_loadu_ps(src + i))));
+	}
+#endif
+	for(; i < count; ++i){
+		dst[i] += weight * src[i];
+	}
+}
+
+const char * PixelKernels::instructionSet(){
+#if defined(PIXEL_KERNELS_AVX2)
+	return "AVX2";
+#elif defined(PIXEL_KERNELS_SSSE3)
+	return "SSSE3";
+#elif defined(PIXEL_KERNELS_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
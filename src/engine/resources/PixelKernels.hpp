@@ -0,0 +1,39 @@
+#ifndef PixelKernels_h
+#define PixelKernels_h
+
+#include <cstddef>
+#include <cstdint>
+
+/// Pixel layout conversions used when decoding and encoding images: planar to interleaved channels and back,
+/// rows flip and alpha fill, and the weighted row sums of the mipmap filters. Vectorized with SSE2, SSSE3 or AVX2 depending on the target, with scalar fallbacks.
+class PixelKernels {
+
+public:
+
+	/// Interleave three planes of 'count' values into RGB pixels.
+	static void interleaveRGB(const float * r, const float * g, const float * b, float * dst, const size_t count);
+
+	/// Half-float version.
+	static void interleaveRGB(const uint16_t * r, const uint16_t * g, const uint16_t * b, uint16_t * dst, const size_t count);
+
+	/// Split 'count' RGB pixels into three planes.
+	static void deinterleaveRGB(const float * src, float * r, float * g, float * b, const size_t count);
+
+	/// Split 'count' RGBA pixels into four planes.
+	static void deinterleaveRGBA(const float * src, float * r, float * g, float * b, float * a, const size_t count);
+
+	/// Copy 'count' RGBA8 pixels, setting their alpha to 255. The source and destination can be the same.
+	static void copyOpaqueRGBA(const unsigned char * src, unsigned char * dst, const size_t count);
+
+	/// Reverse the order of the rows of an image, in place.
+	static void flipRows(void * data, const size_t rowSize, const size_t rows);
+
+	/// Add 'count' values multiplied by a weight to the destination.
+	static void accumulate(const float * src, const float weight, float * dst, const size_t count);
+
+	/// Name of the instruction set used by the kernels.
+	static const char * instructionSet();
+
+};
+
+#endif
@@ -1,8 +1,28 @@
 #include "ResourcesManager.hpp"
 #include "MeshUtilities.hpp"
+#include "ImageUtilities.hpp"
+#include "BlockCompression.hpp"
 #include "../helpers/Logger.hpp"
+#include "../helpers/ThreadPool.hpp"
+#include "../helpers/Profiler.hpp"
+#include "FileWatcher.hpp"
+#include "ByteSource.hpp"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <chrono>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 #include <tinydir/tinydir.h>
 #include <miniz/miniz.h>
 
@@ -45,12 +65,18 @@ Resources& Resources::manager(){
 }
 
 #ifdef RESOURCES_PACKAGED
-Resources::Resources(const std::string & root) : _rootPath(root + ".zip"){
-	Log::Info() << Log::Resources << "Loading resources from archive (" << _rootPath << ")." << std::endl;
-	parseArchive(_rootPath);
+Resources::Resources(const std::string & root) : _rootPath(root), _cachePath(root + "_cache"), _textureBytes(0), _meshBytes(0), _memoryBudget(0), _requestsCount(0), _recording(NULL), _loadingThreads(std::max(1u, std::thread::hardware_concurrency())), _packedVertices(false), _cpuMipmaps(false), _mipmapFilter(ImageUtilities::KaiserFilter), _compression(false), _compressionFormats(0){
+	// Prefer the asset pack when there is one, as its files can be used in place.
+	if(_pack.open(_rootPath + ".pack")){
+		Log::Info() << Log::Resources << "Loading resources from pack (" << _rootPath << ".pack)." << std::endl;
+		parsePack();
+	} else {
+		Log::Info() << Log::Resources << "Loading resources from archive (" << _rootPath << ".zip)." << std::endl;
+		parseArchive(_rootPath + ".zip");
+	}
 }
 #else
-Resources::Resources(const std::string & root) : _rootPath(root){
+Resources::Resources(const std::string & root) : _rootPath(root), _cachePath(root + "_cache"), _textureBytes(0), _meshBytes(0), _memoryBudget(0), _requestsCount(0), _recording(NULL), _loadingThreads(std::max(1u, std::thread::hardware_concurrency())), _packedVertices(false), _cpuMipmaps(false), _mipmapFilter(ImageUtilities::KaiserFilter), _compression(false), _compressionFormats(0){
 	Log::Info() << Log::Resources << "Loading resources from disk (" << _rootPath << ")." << std::endl;
 	parseDirectory(_rootPath);
 }
@@ -58,23 +84,28 @@ Resources::Resources(const std::string & root) : _rootPath(root){
 
 
 void Resources::parseArchive(const std::string & archivePath){
+	Profiler::Scope scope(Profiler::Index, archivePath);
 	
-	mz_zip_archive zip_archive = {0};
-	int status = mz_zip_reader_init_file(&zip_archive, archivePath.c_str(), 0);
+	// The archive is kept open, so that its central directory is only parsed once.
+	_archive.reset(new mz_zip_archive());
+	int status = mz_zip_reader_init_file(_archive.get(), archivePath.c_str(), 0);
 	if (!status){
-		Log::Error() << Log::Resources << "Unable to load zip file \"" << archivePath << "\" (" << mz_zip_get_error_string(mz_zip_get_last_error(&zip_archive)) << ")." << std::endl;
+		Log::Error() << Log::Resources << "Unable to load zip file \"" << archivePath << "\" (" << mz_zip_get_error_string(mz_zip_get_last_error(_archive.get())) << ")." << std::endl;
+		_archive.reset();
+		return;
 	}
+	_archiveFile = ByteSource::open(archivePath);
 	
 	// Get and print information about each file in the archive.
-	for (unsigned int i = 0; i < (unsigned int)mz_zip_reader_get_num_files(&zip_archive); ++i){
+	for (unsigned int i = 0; i < (unsigned int)mz_zip_reader_get_num_files(_archive.get()); ++i){
 		mz_zip_archive_file_stat file_stat;
 		
-		if (!mz_zip_reader_file_stat(&zip_archive, i, &file_stat)){
+		if (!mz_zip_reader_file_stat(_archive.get(), i, &file_stat)){
 			Log::Error() << Log::Resources << "Error reading file infos." << std::endl;
-			mz_zip_reader_end(&zip_archive);
+			continue;
 		}
 		
-		if(mz_zip_reader_is_file_a_directory(&zip_archive, i)){
+		if(mz_zip_reader_is_file_a_directory(_archive.get(), i)){
 			continue;
 		}
 		
@@ -82,102 +113,48 @@ void Resources::parseArchive(const std::string & archivePath){
 		const std::string fileNameWithExt = filePath.substr(filePath.find_last_of("/\\") + 1);
 		// Filter empty files and system files.
 		if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
-			if(_files.count(fileNameWithExt) == 0){
-				_files[fileNameWithExt] = filePath;
+			if(_files.add(fileNameWithExt, filePath)){
+				// Entries are then extracted by index, without any lookup in the archive.
+				_archiveIndices[filePath] = i;
 			} else {
 				// If the file already exists somewhere else in the hierarchy, warn about this.
 				Log::Error() << Log::Resources << "Error: asset named \"" << fileNameWithExt << "\" alread exists." << std::endl;
 			}
 		}
 	}
-	mz_zip_reader_end(&zip_archive);
+	_files.finalize();
 }
 
-void Resources::parseDirectory(const std::string & directoryPath){
-	// Open directory.
-	tinydir_dir dir;
-	
-	if(tinydir_open_wrap(&dir, directoryPath) == -1){
-		tinydir_close(&dir);
-		Log::Error() << Log::Resources << "Unable to open resources directory at path \"" << directoryPath << "\"" << std::endl;
-	}
-	// For each file in dir.
-	while (dir.has_next) {
-		tinydir_file file;
-		if(tinydir_readfile(&dir, &file) == -1){
-			// Handle any read error.
-			Log::Error() << Log::Resources << "Error getting file in directory \"" << TCHARToString(dir.path) << "\"" << std::endl;
-			
-		} else if(file.is_dir){
-			// Extract subdirectory name, check that it isn't a special dir, and recursively aprse it.
-			const std::string dirName = TCHARToString(file.name);
-			if(dirName.size() > 0 && dirName != "." && dirName != ".."){
-				// @CHECK: "/" separator on Windows.
-				parseDirectory(directoryPath + "/" + dirName);
-			}
-			
-		} else {
-			// Else, we have a regular file.
-			const std::string fileNameWithExt = TCHARToString(file.name);
-			// Filter empty files and system files.
-			if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
-				if(_files.count(fileNameWithExt) == 0){
-					// Store the file and its path.
-					// @CHECK: "/" separator on Windows.
-					_files[fileNameWithExt] = TCHARToString(dir.path) + "/" + fileNameWithExt;
-					
-				} else {
-					// If the file already exists somewhere else in the hierarchy, warn about this.
-					Log::Error() << Log::Resources << "Error: asset named \"" << fileNameWithExt << "\" alread exists." << std::endl;
-				}
+void Resources::parsePack(){
+	Profiler::Scope scope(Profiler::Index, _rootPath + ".pack");
+	for(size_t i = 0; i < _pack.count(); ++i){
+		const std::string filePath = _pack.path(i);
+		const std::string fileNameWithExt = filePath.substr(filePath.find_last_of("/\\") + 1);
+		// Filter empty files and system files.
+		if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
+			if(!_files.add(fileNameWithExt, filePath)){
+				// If the file already exists somewhere else in the hierarchy, warn about this.
+				Log::Error() << Log::Resources << "Error: asset named \"" << fileNameWithExt << "\" alread exists." << std::endl;
 			}
 		}
-		// Get to next file.
-		if (tinydir_next(&dir) == -1){
-			// Reach end of dir early.
-			break;
-		}
-		
 	}
-	tinydir_close(&dir);
+	_files.finalize();
 }
 
-
-/// Image path utilities.
-
-const std::vector<std::string> Resources::getCubemapPaths(const std::string & name){
-	const std::vector<std::string> names { name + "_px", name + "_nx", name + "_py", name + "_ny", name + "_pz", name + "_nz" };
+void Resources::parseDirectory(const std::string & directoryPath){
+	Profiler::Scope scope(Profiler::Index, directoryPath);
 	std::vector<std::string> paths;
-	paths.reserve(6);
-	for(auto & faceName : names){
-		const std::string filePath = getImagePath(faceName);
-		// If a face is missing, cancel the whole loading.
-		if(filePath.empty()){
-			return std::vector<std::string>();
+	Resources::listFiles(directoryPath, paths);
+	
+	for(const auto & filePath : paths){
+		const std::string fileNameWithExt = filePath.substr(filePath.find_last_of("/\\") + 1);
+		// Store the file and its path.
+		if(!_files.add(fileNameWithExt, filePath)){
+			// If the file already exists somewhere else in the hierarchy, warn about this.
+			Log::Error() << Log::Resources << "Error: asset named \"" << fileNameWithExt << "\" alread exists." << std::endl;
 		}
-		// Else append the path.
-		paths.push_back(filePath);
 	}
-	return paths;
-}
-
-const std::string Resources::getImagePath(const std::string & name){
-	std::string path = "";
-	// Check if the file exists with an image extension.
-	if(_files.count(name + ".png") > 0){
-		path = _files[name + ".png"];
-	} else if(_files.count(name + ".jpg") > 0){
-		path = _files[name + ".jpg"];
-	} else if(_files.count(name + ".jpeg") > 0){
-		path = _files[name + ".jpeg"];
-	} else if(_files.count(name + ".bmp") > 0){
-		path = _files[name + ".bmp"];
-	} else if(_files.count(name + ".tga") > 0){
-		path = _files[name + ".tga"];
-	} else if(_files.count(name + ".exr") > 0){
-		path = _files[name + ".exr"];
-	}
-	return path;
+	_files.finalize();
 }
 
 
@@ -185,161 +162,915 @@ const std::string Resources::getImagePath(const std::string & name){
 
 #ifdef RESOURCES_PACKAGED
 
-char * Resources::getRawData(const std::string & path, size_t & size) {
-	char * rawContent;
-	mz_zip_archive zip_archive = {0};
-	int status = mz_zip_reader_init_file(&zip_archive, _rootPath.c_str(), 0);
-	if (!status){
-		Log::Error() << Log::Resources << "Unable to load zip file at path \"" << _rootPath << "\" (" << mz_zip_get_error_string(mz_zip_get_last_error(&zip_archive)) << ")." << std::endl;
-		return NULL;
+std::unique_ptr<ByteSource> Resources::openSource(const std::string & path) {
+	if(_pack.isOpen()){
+		const long index = _pack.find(path);
+		if(index < 0){
+			return std::unique_ptr<ByteSource>();
+		}
+		// Stored entries are used in place, compressed ones are inflated at once.
+		Profiler::Scope scope(Profiler::Read, path);
+		size_t size = 0;
+		char * buffer = NULL;
+		const char * data = _pack.data((size_t)index, size, buffer);
+		if(data == NULL){
+			return std::unique_ptr<ByteSource>();
+		}
+		scope.setBytesRead(buffer != NULL ? size : 0);
+		return std::unique_ptr<ByteSource>(new MemorySource(data, size, buffer));
 	}
-	rawContent = (char*)mz_zip_reader_extract_file_to_heap(&zip_archive, path.c_str(), &size, 0);
-	mz_zip_reader_end(&zip_archive);
-	return rawContent;
+	if(!_archive){
+		Log::Error() << Log::Resources << "Unable to load zip file at path \"" << _rootPath << ".zip\"." << std::endl;
+		return std::unique_ptr<ByteSource>();
+	}
+	const auto entry = _archiveIndices.find(path);
+	if(entry == _archiveIndices.end()){
+		return std::unique_ptr<ByteSource>();
+	}
+	// Archive entries are inflated progressively, as they are read.
+	std::unique_ptr<ZipSource> source(new ZipSource(_archive.get(), entry->second, _archiveMutex));
+	if(!source->valid()){
+		return std::unique_ptr<ByteSource>();
+	}
+	return std::unique_ptr<ByteSource>(source.release());
+}
+
+bool Resources::getFileStamp(const std::string & path, SourceStamp & stamp) {
+	if(_pack.isOpen()){
+		const long index = _pack.find(path);
+		if(index < 0){
+			return false;
+		}
+		// Pack entries store the hash of their content, used as the modification time.
+		_pack.stamp((size_t)index, stamp);
+		return true;
+	}
+	const auto entry = _archiveIndices.find(path);
+	if(!_archive || entry == _archiveIndices.end()){
+		return false;
+	}
+	// Archive entries have no modification time, use their checksum instead.
+	mz_zip_archive_file_stat file_stat;
+	std::lock_guard<std::mutex> lock(_archiveMutex);
+	if(!mz_zip_reader_file_stat(_archive.get(), entry->second, &file_stat)){
+		return false;
+	}
+	stamp.size = file_stat.m_uncomp_size;
+	stamp.time = file_stat.m_crc32;
+	return true;
+}
+
+size_t Resources::readaheadSource(const std::string & path) {
+	if(_pack.isOpen()){
+		const long index = _pack.find(path);
+		return index < 0 ? 0 : _pack.readahead((size_t)index);
+	}
+	const auto entry = _archiveIndices.find(path);
+	if(!_archive || !_archiveFile || entry == _archiveIndices.end()){
+		return 0;
+	}
+	mz_zip_archive_file_stat file_stat;
+	{
+		std::lock_guard<std::mutex> lock(_archiveMutex);
+		if(!mz_zip_reader_file_stat(_archive.get(), entry->second, &file_stat)){
+			return 0;
+		}
+	}
+	// The local header precedes the compressed data: 30 bytes, the name, and a margin for the extra field.
+	const size_t headerSize = 30 + std::strlen(file_stat.m_filename) + 1024;
+	const size_t storedSize = (size_t)file_stat.m_comp_size + headerSize;
+	_archiveFile->readahead((size_t)file_stat.m_local_header_ofs, storedSize);
+	return storedSize;
 }
 
 #else
 	
-char * Resources::getRawData(const std::string & path, size_t & size) {
-	return Resources::loadRawDataFromExternalFile(path, size);
+std::unique_ptr<ByteSource> Resources::openSource(const std::string & path) {
+	return ByteSource::open(path);
+}
+
+bool Resources::getFileStamp(const std::string & path, SourceStamp & stamp) {
+	return Resources::getExternalFileStamp(path, stamp);
+}
+
+size_t Resources::readaheadSource(const std::string & path) {
+	std::unique_ptr<ByteSource> source = ByteSource::open(path);
+	if(!source){
+		return 0;
+	}
+	source->readahead(0, source->size());
+	return source->size();
 }
 	
 #endif
 	
 
+/// Hash the content of a source, by blocks if it is not in memory.
+static uint64_t hashSource(ByteSource & source){
+	if(source.data() != NULL){
+		return MeshCache::hash(source.data(), source.size());
+	}
+	uint64_t hash = MeshCache::hash(NULL, 0);
+	std::vector<char> block(std::min(source.size(), size_t(1024 * 1024)));
+	for(size_t offset = 0; offset < source.size(); offset += block.size()){
+		const size_t readCount = source.read(offset, block.size(), &block[0]);
+		if(readCount == 0){
+			break;
+		}
+		hash = MeshCache::hash(&block[0], readCount, hash);
+	}
+	return hash;
+}
+
+bool Resources::isSourceUnchanged(const std::string & path, const SourceStamp & cachedStamp, SourceStamp & stamp){
+	if(!getFileStamp(path, stamp) || stamp.size != cachedStamp.size){
+		return false;
+	}
+	if(stamp.time == cachedStamp.time){
+		stamp.hash = cachedStamp.hash;
+		return true;
+	}
+	// The file was touched, compare the content.
+	std::unique_ptr<ByteSource> source = openSource(path);
+	if(!source){
+		return false;
+	}
+	stamp.hash = hashSource(*source);
+	return stamp.hash == cachedStamp.hash;
+}
+
+bool Resources::getBakedImages(const std::vector<std::string> & paths, const bool cubemap, std::vector<ImageView> & images, std::vector<std::unique_ptr<MappedFile>> & files, const std::string & suffix, const TextureProcessing * processing){
+	images.resize(paths.size());
+	for(size_t pid = 0; pid < paths.size(); ++pid){
+		const std::string & path = paths[pid];
+		const std::string bakedPath = _cachePath + "/" + path.substr(path.find_last_of("/\\") + 1) + suffix;
+		files.emplace_back(new MappedFile());
+		SourceStamp cachedStamp;
+		SourceStamp stamp;
+		TextureProcessing cachedProcessing;
+		if(!TextureCache::load(bakedPath, *files.back(), images[pid], cachedStamp, cachedProcessing)){
+			return false;
+		}
+		// Produced with other settings.
+		if(processing != NULL && !(cachedProcessing == *processing)){
+			return false;
+		}
+		// 2D LDR images are flipped at load time, HDR images and cubemap faces aren't.
+		const bool expectedFlip = !cubemap && !images[pid].hdr;
+		if(images[pid].flipped != expectedFlip || !isSourceUnchanged(path, cachedStamp, stamp)){
+			return false;
+		}
+		if(stamp.time != cachedStamp.time){
+			TextureCache::restamp(bakedPath, stamp);
+		}
+	}
+	return true;
+}
+
 const std::string Resources::getString(const std::string & filename){
-	std::string path = "";
-	if(_files.count(filename) > 0){
-		path = _files[filename];
-	} else if(_files.count(filename + ".txt") > 0){
-		path = _files[filename + ".txt"];
-	} else {
+	if(_recording != NULL){
+		_recording->add(AssetManifest::File, filename);
+	}
+	std::string path = _files.file(filename);
+	if(path.empty()){
+		path = _files.file(filename + ".txt");
+	}
+	if(path.empty()){
 		Log::Error() << Log::Resources << "Unable to find text file named \"" << filename << "\"." << std::endl;
 		return "";
 	}
 	
-	size_t rawSize = 0;
-	char* rawContent = Resources::manager().getRawData(path, rawSize);
-	const std::string content(rawContent, rawSize);
-	free(rawContent);
+	std::unique_ptr<ByteSource> source = openSource(path);
+	if(!source){
+		return "";
+	}
+	Profiler::Scope scope(Profiler::Read, path);
+	std::string content(source->size(), '\0');
+	if(!content.empty()){
+		content.resize(source->read(0, content.size(), &content[0]));
+	}
+	scope.setBytesRead(content.size());
 	return content;
 }
 
-/// Mesh method.
+/// Background loading.
+
+/// A resource requested for background loading. Files are found on the main thread, a loading thread
+/// then reads and decodes them, and the GL upload happens back on the main thread.
+struct Resources::LoadRequest {
+
+	enum Type {
+		Texture, Cubemap, Mesh
+	};
+
+	Type type;
+	std::string name;
+	bool srgb;
+	/// For each mip level, the image or the six faces. For meshes, the OBJ file.
+	std::vector<std::vector<std::string>> paths;
+	std::shared_ptr<AsyncTexture> texture;
+	std::shared_ptr<AsyncMesh> mesh;
+
+	/// Loaded data, referencing the decoded buffers, the mapped baked files or the processed mesh.
+	std::vector<std::vector<ImageView>> images;
+	std::vector<void *> buffers;
+	std::vector<std::unique_ptr<MappedFile>> files;
+	::Mesh geometry;
+	MeshView geometryView;
+	/// Packed vertices and narrowed indices prepared for the upload.
+	std::vector<PackedVertex> packedVertices;
+	std::vector<uint16_t> shortIndices;
+	/// Space in the upload ring holding the images instead, when staged.
+	UploadRing::Allocation staging;
+	/// Threads the decoding, compression and mesh processing steps can use.
+	unsigned int threads;
+	/// A newer request for the same resource was queued, this one won't be uploaded. Main thread only.
+	bool superseded;
+
+	/// Shared with the loading threads.
+	bool started;
+	bool loaded;
+	bool success;
+
+	LoadRequest() : srgb(false), threads(1), superseded(false), started(false), loaded(false), success(false) {}
+
+	~LoadRequest(){
+		for(void * buffer : buffers){
+			free(buffer);
+		}
+	}
+};
+
+/// Find a cached resource and mark it as used by the current request.
+template<typename T>
+static std::shared_ptr<AsyncResource<T>> findCached(std::map<std::string, CachedResource<T>> & cache, const std::string & name, const unsigned long long requestId){
+	const auto entry = cache.find(name);
+	if(entry == cache.end()){
+		return nullptr;
+	}
+	entry->second.lastUse = requestId;
+	return entry->second.resource;
+}
+
+const TextureInfos & Resources::getPlaceholder(const bool cubemap, const bool srgb){
+	TextureInfos & placeholder = _placeholders[(cubemap ? 2 : 0) + (srgb ? 1 : 0)];
+	if(placeholder.id == 0){
+		// Grey for colors, and a flat normal, a mid roughness and no occlusion for linear data.
+		const unsigned char pixel[4] = { 128, 128, (unsigned char)(srgb ? 128 : 255), 255 };
+		ImageView image;
+		image.width = 1;
+		image.height = 1;
+		image.channels = 4;
+		image.levels.push_back(pixel);
+		if(cubemap){
+			placeholder = GLUtilities::loadTextureCubemap({ std::vector<ImageView>(6, image) }, srgb);
+		} else {
+			placeholder = GLUtilities::loadTexture({ image }, srgb);
+		}
+	}
+	return placeholder;
+}
+
+const std::shared_ptr<AsyncTexture> Resources::requestTexture(const std::string & name, const std::vector<std::vector<std::string>> & paths, const bool cubemap, const bool srgb){
+	std::shared_ptr<LoadRequest> request(new LoadRequest());
+	request->type = cubemap ? LoadRequest::Cubemap : LoadRequest::Texture;
+	request->name = name;
+	request->srgb = srgb;
+	request->paths = paths;
+	request->texture = std::make_shared<AsyncTexture>();
+	request->texture->infos = getPlaceholder(cubemap, srgb);
+	CachedResource<TextureInfos> & entry = _textures[name];
+	entry.resource = request->texture;
+	entry.lastUse = ++_requestsCount;
+	entry.paths = paths;
+	entry.srgb = srgb;
+	submitRequest(request);
+	return request->texture;
+}
+
+void Resources::submitRequest(const std::shared_ptr<LoadRequest> & request){
+	if(!_pool){
+		_pool.reset(new ThreadPool(_loadingThreads));
+	}
+	_requests.push_back(request);
+	// Requests finished by the main thread before a worker is available shouldn't keep their resource referenced.
+	const std::weak_ptr<LoadRequest> queued(request);
+	_pool->push([this, queued](){
+		const std::shared_ptr<LoadRequest> request = queued.lock();
+		if(request){
+			processRequest(*request, 1);
+		}
+	});
+}
+
+void Resources::processRequest(LoadRequest & request, const unsigned int threads){
+	{
+		std::lock_guard<std::mutex> lock(_requestsMutex);
+		if(request.started){
+			return;
+		}
+		request.started = true;
+	}
+	request.threads = threads;
+	if(request.type == LoadRequest::Mesh){
+		loadMeshData(request);
+	} else {
+		loadTextureData(request);
+	}
+	{
+		std::lock_guard<std::mutex> lock(_requestsMutex);
+		request.loaded = true;
+	}
+	_requestsCondition.notify_all();
+}
+
+/// Processing applied to a texture before its compression: the format depends on the color space and on normal maps
+/// (recognized by their name), and a lone base level gets its mips generated with the current filter.
+static TextureProcessing compressionProcessing(const std::string & name, const bool srgb, const size_t levels, const ImageUtilities::MipFilter filter){
+	TextureProcessing processing;
+	processing.srgb = srgb;
+	processing.normalMap = name.find("normal") != std::string::npos;
+	processing.mipFilter = levels == 1 ? (uint32_t)filter : TextureProcessing::LoadedLevels;
+	return processing;
+}
+
+void Resources::loadTextureData(LoadRequest & request){
+	const bool cubemap = request.type == LoadRequest::Cubemap;
+	request.images.resize(request.paths.size());
+
+	// Use the compressed versions if they are all available, produced with the current settings in a format the GPU supports.
+	const TextureProcessing processing = compressionProcessing(request.name, request.srgb, request.paths.size(), _mipmapFilter);
+	bool baked = _compression;
+	for(size_t lid = 0; lid < request.paths.size() && baked; ++lid){
+		baked = getBakedImages(request.paths[lid], cubemap, request.images[lid], request.files, ".bc.tex", &processing);
+		for(size_t iid = 0; iid < request.images[lid].size() && baked; ++iid){
+			baked = (_compressionFormats & (1u << request.images[lid][iid].compression)) != 0;
+		}
+	}
+	if(baked){
+		request.success = true;
+		stageTextureData(request);
+		return;
+	}
+	request.files.clear();
+
+	// Else the baked versions with their mipmaps.
+	baked = true;
+	for(size_t lid = 0; lid < request.paths.size() && baked; ++lid){
+		baked = getBakedImages(request.paths[lid], cubemap, request.images[lid], request.files);
+	}
+	if(baked && (request.srgb || _compression)){
+		// Baked mips are filtered as linear data with the filter of the baker. Only keep the base level of sRGB textures,
+		// and of the ones to compress so that their cache matches the current filter. Their mips are filtered again below.
+		for(auto & images : request.images){
+			for(ImageView & image : images){
+				if(_compression || !image.hdr){
+					image.levels.resize(1);
+				}
+			}
+		}
+	}
+	if(!baked){
+		request.files.clear();
+
+		// Else decode all faces and levels at once, 2D LDR images are flipped, HDR images and cubemap faces aren't.
+		std::vector<std::string> paths;
+		for(const auto & levelPaths : request.paths){
+			paths.insert(paths.end(), levelPaths.begin(), levelPaths.end());
+		}
+		std::vector<ImageView> images;
+		if(!ImageUtilities::loadImages(paths, !cubemap, request.threads, images, request.buffers)){
+			return;
+		}
+		size_t iid = 0;
+		for(size_t lid = 0; lid < request.paths.size(); ++lid){
+			request.images[lid].assign(images.begin() + iid, images.begin() + iid + request.paths[lid].size());
+			iid += request.paths[lid].size();
+		}
+	}
+	// A lone base level gets its mip chain here rather than on the GPU, which can't generate it for compressed textures.
+	if((_cpuMipmaps || _compression) && request.images.size() == 1){
+		Profiler::Scope scope(Profiler::Mipmaps, request.name);
+		for(ImageView & image : request.images[0]){
+			if(!ImageUtilities::generateMipmaps(image, request.srgb, _mipmapFilter, request.buffers)){
+				return;
+			}
+		}
+	}
+	if(_compression){
+		compressTextureData(request);
+	}
+	request.success = true;
+	stageTextureData(request);
+}
+
+void Resources::compressTextureData(LoadRequest & request){
+	Profiler::Scope scope(Profiler::Compress, request.name);
+	const bool cubemap = request.type == LoadRequest::Cubemap;
+	// Normal maps are recognized by their name, shaders rebuild their third component.
+	const TextureProcessing processing = compressionProcessing(request.name, request.srgb, request.images.size(), _mipmapFilter);
+	const bool normalMap = processing.normalMap;
+	// All levels and faces have to share the format picked for the base levels.
+	BlockCompression::Format format = BlockCompression::None;
+	for(size_t iid = 0; iid < request.images[0].size(); ++iid){
+		const BlockCompression::Format imageFormat = BlockCompression::chooseFormat(request.images[0][iid], request.srgb, normalMap);
+		if(iid == 0 || imageFormat == format){
+			format = imageFormat;
+		} else {
+			format = request.srgb ? BlockCompression::BC3 : BlockCompression::BC7;
+		}
+	}
+	// HDR 2D textures are lookup tables, keep their precision.
+	if(format == BlockCompression::BC6H && !cubemap){
+		return;
+	}
+	if(format == BlockCompression::BC4 && (_compressionFormats & (1u << BlockCompression::BC4)) == 0){
+		format = BlockCompression::BC7;
+	}
+	if((_compressionFormats & (1u << format)) == 0){
+		return;
+	}
+
+	for(size_t lid = 0; lid < request.images.size(); ++lid){
+		for(size_t iid = 0; iid < request.images[lid].size(); ++iid){
+			ImageView & image = request.images[lid][iid];
+			size_t size = 0;
+			for(unsigned int level = 0; level < image.levels.size(); ++level){
+				size += BlockCompression::imageSize(format, std::max(1u, image.width >> level), std::max(1u, image.height >> level));
+			}
+			unsigned char * data = (unsigned char *)malloc(size);
+			if(data == NULL){
+				return;
+			}
+			request.buffers.push_back(data);
+			ImageView compressed = image;
+			compressed.compression = format;
+			size_t offset = 0;
+			for(unsigned int level = 0; level < image.levels.size(); ++level){
+				BlockCompression::encode(image, level, format, request.threads, data + offset);
+				compressed.levels[level] = data + offset;
+				offset += compressed.levelSize(level);
+			}
+			image = compressed;
+
+			// Cache the result next to the baked files.
+			const std::string & path = request.paths[lid][iid];
+			SourceStamp stamp;
+			std::unique_ptr<ByteSource> source = openSource(path);
+			if(source && getFileStamp(path, stamp) && Resources::createDirectory(_cachePath)){
+				stamp.hash = hashSource(*source);
+				TextureCache::save(_cachePath + "/" + path.substr(path.find_last_of("/\\") + 1) + ".bc.tex", image, stamp, processing);
+			}
+		}
+	}
+}
+
+/// Space taken by an image level in the upload ring, where each level starts aligned.
+static size_t stagedSize(const size_t size){
+	return (size + UploadRing::alignment - 1) / UploadRing::alignment * UploadRing::alignment;
+}
+
+void Resources::stageTextureData(LoadRequest & request){
+	// The pixels are copied here, so that the main thread only has to issue the transfers from the ring.
+	size_t size = 0;
+	for(const auto & images : request.images){
+		for(const ImageView & image : images){
+			for(unsigned int level = 0; level < image.levels.size(); ++level){
+				size += stagedSize(image.levelSize(level));
+			}
+		}
+	}
+	if(!_uploadRing.allocate(size, request.staging)){
+		// Disabled or full, upload from the loaded data.
+		return;
+	}
+	size_t offset = 0;
+	for(auto & images : request.images){
+		for(ImageView & image : images){
+			for(unsigned int level = 0; level < image.levels.size(); ++level){
+				const size_t levelSize = image.levelSize(level);
+				std::memcpy(request.staging.data + offset, image.levels[level], levelSize);
+				// Levels are now referenced by their offset in the bound pixel buffer.
+				image.levels[level] = (const void *)(request.staging.offset + offset);
+				offset += stagedSize(levelSize);
+			}
+		}
+	}
+	for(void * buffer : request.buffers){
+		free(buffer);
+	}
+	request.buffers.clear();
+	request.files.clear();
+}
+
+void Resources::loadMeshData(LoadRequest & request){
+	const std::string & path = request.paths[0][0];
+
+	// Check if a processed version of the mesh is cached and up to date.
+	const std::string cachePath = _cachePath + "/" + request.name + ".mesh";
+	SourceStamp stamp;
+	SourceStamp cachedStamp;
+	request.files.emplace_back(new MappedFile());
+	if(MeshCache::load(cachePath, *request.files[0], request.geometryView, cachedStamp) && isSourceUnchanged(path, cachedStamp, stamp)){
+		// Upload directly from the mapped file.
+		// The content didn't change, only record the new modification time.
+		if(cachedStamp.time != stamp.time){
+			MeshCache::restamp(cachePath, stamp);
+		}
+		MeshUtilities::prepareUpload(request.geometryView, _packedVertices, request.packedVertices, request.shortIndices);
+		request.success = true;
+		return;
+	}
+	request.files.clear();
+	const bool hasStamp = getFileStamp(path, stamp);
+
+	::Mesh & mesh = request.geometry;
+	std::unique_ptr<ByteSource> source = openSource(path);
+	if(source && source->size() > 0){
+		{
+			// Parse the OBJ in place if possible, else by windows.
+			Profiler::Scope scope(Profiler::Parse, path);
+			MeshUtilities::loadObj(*source, mesh, MeshUtilities::Indexed, request.threads);
+			scope.setBytesRead(source->size());
+			scope.setBytesDecoded(mesh.positions.size() * sizeof(glm::vec3) + mesh.normals.size() * sizeof(glm::vec3) + mesh.texcoords.size() * sizeof(glm::vec2) + mesh.indices.size() * sizeof(unsigned int));
+		}
+		stamp.hash = hashSource(*source);
+		source.reset();
+		// Improve vertex cache usage, overdraw and fetch locality.
+		MeshUtilities::optimize(mesh);
+		{
+			// If uv or positions are missing, tangent/binormals won't be computed.
+			Profiler::Scope scope(Profiler::Tangents, path);
+			MeshUtilities::computeTangentsAndBinormals(mesh, request.threads);
+			scope.setBytesDecoded((mesh.tangents.size() + mesh.binormals.size()) * sizeof(glm::vec3));
+		}
+		// Simplified versions for distant objects and shadow maps.
+		MeshUtilities::generateLods(mesh);
+
+	} else {
+		Log::Error() << Log::Resources << "Unable to load mesh named " << request.name << "." << std::endl;
+		return;
+	}
+
+	// Store the processed mesh for the next runs.
+	if(hasStamp && Resources::createDirectory(_cachePath)){
+		MeshCache::save(cachePath, mesh, stamp);
+	}
+	request.geometryView = MeshView(mesh);
+	// Leave only the GL calls to the main thread.
+	MeshUtilities::prepareUpload(request.geometryView, _packedVertices, request.packedVertices, request.shortIndices);
+	request.success = true;
+}
+
+void Resources::uploadRequest(LoadRequest & request){
+	// The newer request will upload the current content, release the space it might have staged.
+	if(request.superseded){
+		if(request.staging.size > 0){
+			_uploadRing.submit(request.staging);
+		}
+		return;
+	}
+	if(!request.success){
+		// Forget about the resource, so that a later request tries again. A reloaded resource keeps its previous version.
+		const auto mesh = _meshes.find(request.name);
+		if(request.mesh && !request.mesh->ready && mesh != _meshes.end() && mesh->second.resource == request.mesh){
+			_meshes.erase(mesh);
+		}
+		const auto texture = _textures.find(request.name);
+		if(request.texture && !request.texture->ready && texture != _textures.end() && texture->second.resource == request.texture){
+			_textures.erase(texture);
+		}
+		return;
+	}
+
+	Profiler::Scope scope(Profiler::Upload, request.name);
+	// When reloading, replace the previous version.
+	if(request.mesh && request.mesh->ready){
+		_meshBytes -= request.mesh->infos.bytes;
+		GLUtilities::deleteMesh(request.mesh->infos);
+	}
+	if(request.texture && request.texture->ready){
+		_textureBytes -= request.texture->infos.bytes;
+		GLUtilities::deleteTexture(request.texture->infos);
+	}
+
+	// Staged images are read from the upload ring.
+	const bool staged = request.staging.size > 0;
+	if(staged){
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadRing.buffer());
+	}
+	switch(request.type){
+		case LoadRequest::Mesh:
+			// Setup GL buffers and attributes.
+			request.mesh->infos = GLUtilities::setupBuffers(request.geometryView, _packedVertices);
+			request.mesh->ready = true;
+			_meshBytes += request.mesh->infos.bytes;
+			break;
+		case LoadRequest::Cubemap:
+			request.texture->infos = GLUtilities::loadTextureCubemap(request.images, request.srgb);
+			request.texture->ready = true;
+			_textureBytes += request.texture->infos.bytes;
+			break;
+		case LoadRequest::Texture:
+		default:
+		{
+			std::vector<ImageView> levels;
+			for(const auto & images : request.images){
+				levels.push_back(images[0]);
+			}
+			request.texture->infos = GLUtilities::loadTexture(levels, request.srgb);
+			request.texture->ready = true;
+			_textureBytes += request.texture->infos.bytes;
+			break;
+		}
+	}
+	if(staged){
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		_uploadRing.submit(request.staging);
+	}
+	scope.setBytesUploaded(request.mesh ? request.mesh->infos.bytes : request.texture->infos.bytes);
+	// Make room for the new resource if needed.
+	if(_memoryBudget > 0 && _textureBytes + _meshBytes > _memoryBudget){
+		collect(false);
+	}
+}
+
+void Resources::finishRequest(const std::shared_ptr<LoadRequest> request){
+	_uploadRing.retire();
+	// Load it directly if no thread took care of it yet, the main thread is waiting anyway.
+	processRequest(*request, _loadingThreads);
+	{
+		std::unique_lock<std::mutex> lock(_requestsMutex);
+		_requestsCondition.wait(lock, [&request](){ return request->loaded; });
+	}
+	_requests.erase(std::remove(_requests.begin(), _requests.end(), request), _requests.end());
+	uploadRequest(*request);
+}
+
+void Resources::finishRequest(const std::shared_ptr<AsyncTexture> & texture){
+	// A reloaded texture can have several requests, the last one holding the current content.
+	while(true){
+		const auto request = std::find_if(_requests.begin(), _requests.end(), [&texture](const std::shared_ptr<LoadRequest> & other){
+			return other->texture == texture;
+		});
+		if(request == _requests.end()){
+			return;
+		}
+		finishRequest(*request);
+	}
+}
+
+void Resources::finishRequest(const std::shared_ptr<AsyncMesh> & mesh){
+	while(true){
+		const auto request = std::find_if(_requests.begin(), _requests.end(), [&mesh](const std::shared_ptr<LoadRequest> & other){
+			return other->mesh == mesh;
+		});
+		if(request == _requests.end()){
+			return;
+		}
+		finishRequest(*request);
+	}
+}
 
-const MeshInfos Resources::getMesh(const std::string & name){
-	if(_meshes.count(name) > 0){
-		return _meshes[name];
+size_t Resources::pumpUploads(const double budgetMs){
+	const auto start = std::chrono::steady_clock::now();
+	// Make room in the upload ring for the next requests.
+	_uploadRing.retire();
+	auto request = _requests.begin();
+	while(request != _requests.end()){
+		const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if(elapsed >= budgetMs){
+			break;
+		}
+		bool loaded;
+		{
+			std::lock_guard<std::mutex> lock(_requestsMutex);
+			loaded = (*request)->loaded;
+		}
+		// Requests are uploaded as soon as they are loaded, not necessarily in order.
+		if(!loaded){
+			++request;
+			continue;
+		}
+		const std::shared_ptr<LoadRequest> current = *request;
+		request = _requests.erase(request);
+		uploadRequest(*current);
 	}
+	return _requests.size();
+}
 
-	MeshInfos infos;
-	std::string completeName;
+void Resources::finishUploads(){
+	while(!_requests.empty()){
+		finishRequest(_requests.front());
+	}
+}
+
+const Resources::Stats Resources::stats() const {
+	Stats stats;
+	for(const auto & texture : _textures){
+		if(texture.second.resource->ready){
+			++stats.textures;
+		}
+	}
+	for(const auto & mesh : _meshes){
+		if(mesh.second.resource->ready){
+			++stats.meshes;
+		}
+	}
+	stats.textureBytes = _textureBytes;
+	stats.meshBytes = _meshBytes;
+	stats.programs = _programs.size();
+	return stats;
+}
+
+void Resources::setMemoryBudget(const size_t bytes){
+	_memoryBudget = bytes;
+	if(_memoryBudget > 0 && _textureBytes + _meshBytes > _memoryBudget){
+		collect(false);
+	}
+}
+
+void Resources::collect(const bool all){
+	// Only uploaded resources that nobody else references can be released, the least recently requested first.
+	std::vector<std::pair<unsigned long long, std::string>> textures;
+	std::vector<std::pair<unsigned long long, std::string>> meshes;
+	for(const auto & texture : _textures){
+		const CachedResource<TextureInfos> & entry = texture.second;
+		if(entry.resource->ready && entry.resource.use_count() == 1){
+			textures.emplace_back(entry.lastUse, texture.first);
+		}
+	}
+	for(const auto & mesh : _meshes){
+		const CachedResource<MeshInfos> & entry = mesh.second;
+		if(entry.resource->ready && entry.resource.use_count() == 1){
+			meshes.emplace_back(entry.lastUse, mesh.first);
+		}
+	}
+	std::sort(textures.begin(), textures.end());
+	std::sort(meshes.begin(), meshes.end());
 	
-	// Load geometry. For now we only support OBJs.
-	Mesh mesh;
-	const std::string meshText = getString(name + ".obj");
-	if(!meshText.empty()){
-		std::stringstream meshStream(meshText);
+	const size_t residentBytes = _textureBytes + _meshBytes;
+	size_t released = 0;
+	size_t tid = 0;
+	size_t mid = 0;
+	while(tid < textures.size() || mid < meshes.size()){
+		if(!all && (_memoryBudget == 0 || _textureBytes + _meshBytes <= _memoryBudget)){
+			break;
+		}
+		// Merge both lists by last use.
+		if(mid == meshes.size() || (tid < textures.size() && textures[tid].first < meshes[mid].first)){
+			const auto texture = _textures.find(textures[tid++].second);
+			_textureBytes -= texture->second.resource->infos.bytes;
+			GLUtilities::deleteTexture(texture->second.resource->infos);
+			_textures.erase(texture);
+		} else {
+			const auto mesh = _meshes.find(meshes[mid++].second);
+			_meshBytes -= mesh->second.resource->infos.bytes;
+			GLUtilities::deleteMesh(mesh->second.resource->infos);
+			_meshes.erase(mesh);
+		}
+		++released;
+	}
 	
-		MeshUtilities::loadObj(meshStream, mesh, MeshUtilities::Indexed);
-		// If uv or positions are missing, tangent/binormals won't be computed.
-		MeshUtilities::computeTangentsAndBinormals(mesh);
-		
-	} else {
+	// Programs don't count in the budget, release the unused ones along with everything else.
+	if(all){
+		for(auto program = _programs.begin(); program != _programs.end();){
+			if(program->second.use_count() == 1){
+				program = _programs.erase(program);
+				++released;
+			} else {
+				++program;
+			}
+		}
+	}
+	if(released > 0){
+		Log::Info() << Log::Resources << "Released " << released << " resources (" << (residentBytes - _textureBytes - _meshBytes) / (1024 * 1024) << "MB)." << std::endl;
+	}
+}
+
+
+/// Mesh methods.
+
+const std::shared_ptr<AsyncMesh> Resources::getMesh(const std::string & name){
+	const std::shared_ptr<AsyncMesh> mesh = getMeshAsync(name);
+	finishRequest(mesh);
+	return mesh;
+}
+
+const std::shared_ptr<AsyncMesh> Resources::getMeshAsync(const std::string & name){
+	if(_recording != NULL){
+		_recording->add(AssetManifest::Mesh, name);
+	}
+	const std::shared_ptr<AsyncMesh> cached = findCached(_meshes, name, ++_requestsCount);
+	if(cached){
+		return cached;
+	}
+
+	// Load geometry. For now we only support OBJs.
+	const std::string & path = _files.file(name + ".obj");
+	if(path.empty()){
 		Log::Error() << Log::Resources << "Unable to load mesh named " << name << "." << std::endl;
-		return infos;
+		return std::make_shared<AsyncMesh>();
 	}
-	
-	// Setup GL buffers and attributes.
-	infos = GLUtilities::setupBuffers(mesh);
-	_meshes[name] = infos;
-	return infos;
+
+	std::shared_ptr<LoadRequest> request(new LoadRequest());
+	request->type = LoadRequest::Mesh;
+	request->name = name;
+	request->paths = { { path } };
+	request->mesh = std::make_shared<AsyncMesh>();
+	CachedResource<MeshInfos> & entry = _meshes[name];
+	entry.resource = request->mesh;
+	entry.lastUse = _requestsCount;
+	entry.paths = request->paths;
+	submitRequest(request);
+	return request->mesh;
 }
 
 
 /// Texture methods.
 
-const TextureInfos Resources::getTexture(const std::string & name, bool srgb){
-	
-	// If texture already loaded, return it.
-	if(_textures.count(name) > 0){
-		return _textures[name];
+const std::shared_ptr<AsyncTexture> Resources::getTexture(const std::string & name, bool srgb){
+	const std::shared_ptr<AsyncTexture> texture = getTextureAsync(name, srgb);
+	finishRequest(texture);
+	return texture;
+}
+
+const std::shared_ptr<AsyncTexture> Resources::getCubemap(const std::string & name, bool srgb){
+	const std::shared_ptr<AsyncTexture> texture = getCubemapAsync(name, srgb);
+	finishRequest(texture);
+	return texture;
+}
+
+const std::shared_ptr<AsyncTexture> Resources::getTextureAsync(const std::string & name, bool srgb){
+	if(_recording != NULL){
+		_recording->add(AssetManifest::Texture, name, srgb);
 	}
-	// Else, find the corresponding file.
-	TextureInfos infos;
-	std::string path = getImagePath(name);
-	
-	if(!path.empty()){
-		// Else, load it and store the infos.
-		infos = GLUtilities::loadTexture({path}, srgb);
-		_textures[name] = infos;
-		return infos;
+	// If texture already loaded or loading, return it.
+	const std::shared_ptr<AsyncTexture> cached = findCached(_textures, name, ++_requestsCount);
+	if(cached){
+		return cached;
 	}
-	// Else, maybe there are custom mipmap levels.
-	// In this case the true name is name_mipmaplevel.
-	
-	// How many mipmap levels can we accumulate?
-	std::vector<std::string> paths;
-	unsigned int lastMipmap = 0;
-	std::string mipmapPath = getImagePath(name + "_" + std::to_string(lastMipmap));
-	while(!mipmapPath.empty()) {
-		// Transfer them to the final paths vector.
-		paths.push_back(mipmapPath);
-		++lastMipmap;
-		mipmapPath = getImagePath(name + "_" + std::to_string(lastMipmap));
-	}
-	if(!paths.empty()){
-		// We found the texture files.
-		// Load them and store the infos.
-		infos = GLUtilities::loadTexture(paths, srgb);
-		_textures[name] = infos;
-		return infos;
+	// Else, find the corresponding files.
+	std::vector<std::vector<std::string>> paths;
+	if(findTexturePaths(name, false, paths)){
+		return requestTexture(name, paths, false, srgb);
 	}
-	
-	// If couldn't file the image, return empty texture infos.
+
+	// If couldn't file the image, keep the placeholder.
 	Log::Error() << Log::Resources << "Unable to find texture named \"" << name << "\"." << std::endl;
-	return infos;
+	std::shared_ptr<AsyncTexture> texture = std::make_shared<AsyncTexture>();
+	texture->infos = getPlaceholder(false, srgb);
+	return texture;
 }
 
-
-const TextureInfos Resources::getCubemap(const std::string & name, bool srgb){
-	// If texture already loaded, return it.
-	if(_textures.count(name) > 0){
-		return _textures[name];
+const std::shared_ptr<AsyncTexture> Resources::getCubemapAsync(const std::string & name, bool srgb){
+	if(_recording != NULL){
+		_recording->add(AssetManifest::Cubemap, name, srgb);
+	}
+	// If texture already loaded or loading, return it.
+	const std::shared_ptr<AsyncTexture> cached = findCached(_textures, name, ++_requestsCount);
+	if(cached){
+		return cached;
 	}
 	// Else, find the corresponding files.
-	TextureInfos infos;
-	std::vector<std::string> paths = getCubemapPaths(name);
-	if(!paths.empty()){
-		// We found the texture files.
-		// Load them and store the infos.
-		infos = GLUtilities::loadTextureCubemap({paths}, srgb);
-		_textures[name] = infos;
-		return infos;
+	std::vector<std::vector<std::string>> paths;
+	if(findTexturePaths(name, true, paths)){
+		return requestTexture(name, paths, true, srgb);
+	}
+	Log::Error() << Log::Resources << "Unable to find cubemap named \"" << name << "\"." << std::endl;
+	// Nothing found, keep the placeholder.
+	std::shared_ptr<AsyncTexture> texture = std::make_shared<AsyncTexture>();
+	texture->infos = getPlaceholder(true, srgb);
+	return texture;
+}
+
+bool Resources::findTexturePaths(const std::string & name, const bool cubemap, std::vector<std::vector<std::string>> & paths) const {
+	paths.clear();
+	const AssetIndex::Image * image = _files.image(name);
+	if(image == NULL){
+		return false;
+	}
+	if(!cubemap && !image->path.empty()){
+		paths.push_back({ image->path });
+		return true;
+	}
+	if(cubemap && image->isCubemap()){
+		paths.emplace_back(image->faces, image->faces + 6);
+		return true;
 	}
 	// Else, maybe there are custom mipmap levels.
 	// In this case the true name is name_mipmaplevel.
-	
-	// How many mipmap levels can we accumulate?
-	std::vector<std::vector<std::string>> allPaths;
-	unsigned int lastMipmap = 0;
-	std::vector<std::string> mipmapPaths = getCubemapPaths(name + "_" + std::to_string(lastMipmap));
-	while(!mipmapPaths.empty()) {
-		// Transfer them to the final paths vector.
-		allPaths.push_back(mipmapPaths);
-		++lastMipmap;
-		mipmapPaths = getCubemapPaths(name + "_" + std::to_string(lastMipmap));
-	}
-	if(!allPaths.empty()){
-		// We found the texture files.
-		// Load them and store the infos.
-		infos = GLUtilities::loadTextureCubemap(allPaths, srgb);
-		_textures[name] = infos;
-		return infos;
+	for(size_t lid = 0; lid < image->levels.size(); ++lid){
+		const AssetIndex::Image * level = image->levels[lid];
+		if(cubemap && level->isCubemap()){
+			paths.emplace_back(level->faces, level->faces + 6);
+		} else if(!cubemap && !level->path.empty()){
+			paths.push_back({ level->path });
+		} else {
+			break;
+		}
 	}
-	Log::Error() << Log::Resources << "Unable to find cubemap named \"" << name << "\"." << std::endl;
-	// Nothing found, return empty texture.
-	return infos;
+	return !paths.empty();
 }
 
 /// Program/shaders methods.
@@ -380,6 +1111,292 @@ void Resources::reload() {
 	Log::Info() << Log::Resources << "Shader programs reloaded." << std::endl;
 }
 
+void Resources::setHotReload(const bool enable){
+#ifdef RESOURCES_PACKAGED
+	if(enable){
+		Log::Warning() << Log::Resources << "Hot reload is not available for packaged resources." << std::endl;
+	}
+#else
+	if(!enable){
+		_watcher.reset();
+		return;
+	}
+	if(_watcher){
+		return;
+	}
+	_watcher.reset(new FileWatcher());
+	if(!_watcher->watch(_rootPath)){
+		_watcher.reset();
+		return;
+	}
+	Log::Info() << Log::Resources << "Watching resources for changes" << (_watcher->polling() ? " (polling)." : ".") << std::endl;
+#endif
+}
+
+size_t Resources::reloadChanged(){
+	if(!_watcher){
+		return 0;
+	}
+	std::vector<std::string> paths;
+	_watcher->changes(paths);
+	if(paths.empty()){
+		return 0;
+	}
+	
+	size_t reloaded = 0;
+	bool newFiles = false;
+	std::vector<std::string> changedPaths;
+	for(const auto & path : paths){
+		const std::string fileNameWithExt = path.substr(path.find_last_of("/\\") + 1);
+		const std::string & indexedPath = _files.file(fileNameWithExt);
+		if(indexedPath.empty()){
+			// New file, available to the next requests.
+			newFiles = _files.add(fileNameWithExt, path) || newFiles;
+			continue;
+		}
+		if(indexedPath != path){
+			// Another file with the same name, ignored by the resources.
+			continue;
+		}
+		changedPaths.push_back(path);
+		
+		// Shaders: reload the programs using them.
+		const size_t dotPos = fileNameWithExt.find_last_of('.');
+		const std::string extension = dotPos != std::string::npos ? fileNameWithExt.substr(dotPos + 1) : "";
+		if(extension != "vert" && extension != "frag"){
+			continue;
+		}
+		const std::string shaderName = fileNameWithExt.substr(0, dotPos);
+		for(auto & program : _programs){
+			const std::string & programShader = extension == "vert" ? program.second->vertexName() : program.second->fragmentName();
+			if(programShader == shaderName){
+				Log::Info() << Log::Resources << "Reloading program " << program.first << "." << std::endl;
+				program.second->reload();
+				++reloaded;
+			}
+		}
+	}
+	if(newFiles){
+		_files.finalize();
+	}
+	if(changedPaths.empty()){
+		return reloaded;
+	}
+	
+	// Textures and meshes built from the modified files.
+	const auto usesChangedFile = [&changedPaths](const std::vector<std::vector<std::string>> & sources){
+		for(const auto & levelSources : sources){
+			for(const auto & source : levelSources){
+				if(std::find(changedPaths.begin(), changedPaths.end(), source) != changedPaths.end()){
+					return true;
+				}
+			}
+		}
+		return false;
+	};
+	for(auto & texture : _textures){
+		if(usesChangedFile(texture.second.paths) && reloadResource(texture.first, texture.second)){
+			++reloaded;
+		}
+	}
+	for(auto & mesh : _meshes){
+		if(usesChangedFile(mesh.second.paths) && reloadResource(mesh.first, mesh.second)){
+			++reloaded;
+		}
+	}
+	return reloaded;
+}
+
+bool Resources::reloadResource(const std::string & name, CachedResource<TextureInfos> & entry){
+	std::shared_ptr<LoadRequest> request(new LoadRequest());
+	request->type = entry.resource->infos.cubemap ? LoadRequest::Cubemap : LoadRequest::Texture;
+	request->srgb = entry.srgb;
+	request->texture = entry.resource;
+	return submitReload(name, entry.paths, request);
+}
+
+bool Resources::reloadResource(const std::string & name, CachedResource<MeshInfos> & entry){
+	std::shared_ptr<LoadRequest> request(new LoadRequest());
+	request->type = LoadRequest::Mesh;
+	request->mesh = entry.resource;
+	return submitReload(name, entry.paths, request);
+}
+
+bool Resources::submitReload(const std::string & name, const std::vector<std::vector<std::string>> & paths, const std::shared_ptr<LoadRequest> & request){
+	// A request that hasn't started yet will read the new content. Started ones might have read the
+	// previous content and finish after the new request, so they are superseded and won't be uploaded.
+	bool pending = false;
+	{
+		std::lock_guard<std::mutex> lock(_requestsMutex);
+		for(const auto & other : _requests){
+			if(other->texture == request->texture && other->mesh == request->mesh){
+				pending = pending || !other->started;
+				other->superseded = other->superseded || other->started;
+			}
+		}
+	}
+	if(pending){
+		return false;
+	}
+	Log::Info() << Log::Resources << "Reloading " << name << "." << std::endl;
+	request->name = name;
+	request->paths = paths;
+	submitRequest(request);
+	return true;
+}
+
+/// Manifest methods.
+
+void Resources::recordManifest(AssetManifest * manifest){
+	_recording = manifest;
+}
+
+bool Resources::loadManifest(const std::string & name, AssetManifest & manifest){
+	const std::string & path = _files.file(name + ".manifest");
+	if(path.empty()){
+		return false;
+	}
+	std::unique_ptr<ByteSource> source = openSource(path);
+	if(!source){
+		return false;
+	}
+	std::string content(source->size(), '\0');
+	if(!content.empty()){
+		content.resize(source->read(0, content.size(), &content[0]));
+	}
+	manifest.parse(content);
+	return !manifest.empty();
+}
+
+bool Resources::saveManifest(const std::string & name, const AssetManifest & manifest){
+#ifdef RESOURCES_PACKAGED
+	Log::Warning() << Log::Resources << "Manifest " << name << " can't be saved with packaged resources." << std::endl;
+	return false;
+#else
+	// Replace the existing manifest wherever it is, else create it at the root.
+	const std::string fileName = name + ".manifest";
+	std::string path = _files.file(fileName);
+	if(path.empty()){
+		path = _rootPath + "/" + fileName;
+	}
+	std::ofstream file(path);
+	if(!file.is_open()){
+		Log::Error() << Log::Resources << "Unable to save manifest to \"" << path << "\"." << std::endl;
+		return false;
+	}
+	file << manifest.serialize();
+	file.close();
+	_files.add(fileName, path);
+	Log::Info() << Log::Resources << "Saved manifest with " << manifest.entries().size() << " resources to \"" << path << "\"." << std::endl;
+	return true;
+#endif
+}
+
+void Resources::prefetch(const AssetManifest & manifest){
+	// Files of the resources not loaded yet, along with their processed versions that are read instead when up to date.
+	// Missing resources are skipped, the scene will report them.
+	std::vector<std::pair<std::string, std::string>> files;
+	std::vector<AssetManifest::Entry> requests;
+	for(const auto & entry : manifest.entries()){
+		if(entry.type == AssetManifest::Mesh && _meshes.count(entry.name) == 0){
+			const std::string & path = _files.file(entry.name + ".obj");
+			if(!path.empty()){
+				files.emplace_back(path, _cachePath + "/" + entry.name + ".mesh");
+				requests.push_back(entry);
+			}
+		} else if((entry.type == AssetManifest::Texture || entry.type == AssetManifest::Cubemap) && _textures.count(entry.name) == 0){
+			std::vector<std::vector<std::string>> paths;
+			if(!findTexturePaths(entry.name, entry.type == AssetManifest::Cubemap, paths)){
+				continue;
+			}
+			for(const auto & levelPaths : paths){
+				for(const auto & path : levelPaths){
+					files.emplace_back(path, _cachePath + "/" + path.substr(path.find_last_of("/\\") + 1) + (_compression ? ".bc.tex" : ".tex"));
+				}
+			}
+			requests.push_back(entry);
+		} else if(entry.type == AssetManifest::File){
+			std::string path = _files.file(entry.name);
+			if(path.empty()){
+				path = _files.file(entry.name + ".txt");
+			}
+			if(!path.empty()){
+				files.emplace_back(path, "");
+			}
+		}
+	}
+	
+	// Issue all reads up front, the system fetches the files in the background while the first ones are decoded.
+	{
+		Profiler::Scope scope(Profiler::Read, "prefetch");
+		size_t bytes = 0;
+		for(const auto & file : files){
+			std::unique_ptr<ByteSource> cached;
+			if(!file.second.empty()){
+				cached = ByteSource::open(file.second);
+			}
+			if(cached){
+				cached->readahead(0, cached->size());
+				bytes += cached->size();
+			} else {
+				bytes += readaheadSource(file.first);
+			}
+		}
+		Log::Info() << Log::Resources << "Prefetching " << files.size() << " files (" << bytes / (1024 * 1024) << "MB)." << std::endl;
+	}
+	
+	// Then start loading, the scene requests will find the resources in the cache.
+	for(const auto & entry : requests){
+		if(entry.type == AssetManifest::Mesh){
+			getMeshAsync(entry.name);
+		} else if(entry.type == AssetManifest::Texture){
+			getTextureAsync(entry.name, entry.srgb);
+		} else if(entry.type == AssetManifest::Cubemap){
+			getCubemapAsync(entry.name, entry.srgb);
+		}
+	}
+}
+
+void Resources::setLoadingThreads(const unsigned int threads){
+	// The workers are idle once pending requests are finished, the pool is recreated with the new size by the next request.
+	finishUploads();
+	_pool.reset();
+	_loadingThreads = std::max(1u, threads);
+}
+
+void Resources::setUploadBuffer(const size_t bytes){
+	// The loading threads might be writing to the current buffer.
+	finishUploads();
+	_uploadRing.init(bytes);
+}
+
+void Resources::setCPUMipmaps(const bool enable, const ImageUtilities::MipFilter filter){
+	// The loading threads read the settings.
+	finishUploads();
+	_cpuMipmaps = enable;
+	_mipmapFilter = filter;
+}
+
+void Resources::setTextureCompression(const bool enable){
+	finishUploads();
+	_compression = enable;
+	// Supported formats are queried here, on the main thread.
+	_compressionFormats = 0;
+	const BlockCompression::Format formats[] = { BlockCompression::BC1, BlockCompression::BC3, BlockCompression::BC4, BlockCompression::BC5, BlockCompression::BC6H, BlockCompression::BC7 };
+	for(const BlockCompression::Format format : formats){
+		if(enable && GLUtilities::supportsCompression(format)){
+			_compressionFormats |= 1u << format;
+		} else if(enable){
+			Log::Warning() << Log::OpenGL << BlockCompression::name(format) << " compression unsupported, the textures using it will stay uncompressed." << std::endl;
+		}
+	}
+}
+
+void Resources::setPackedVertices(const bool packed){
+	finishUploads();
+	_packedVertices = packed;
+}
+
 
 /// Static utilities methods.
 
@@ -391,7 +1408,8 @@ char * Resources::loadRawDataFromExternalFile(const std::string & path, size_t &
 		return NULL;
 	}
 	std::ifstream::pos_type fileSize = inputFile.tellg();
-	rawContent = new char[fileSize];
+	// Allocated with malloc, like all the raw buffers returned by Resources.
+	rawContent = (char*)malloc(std::max(size_t(fileSize), size_t(1)));
 	inputFile.seekg(0, std::ios::beg);
 	inputFile.read(&rawContent[0], fileSize);
 	inputFile.close();
@@ -399,6 +1417,93 @@ char * Resources::loadRawDataFromExternalFile(const std::string & path, size_t &
 	return rawContent;
 }
 
+bool Resources::createDirectory(const std::string & path){
+	struct stat dirStat;
+	if(stat(path.c_str(), &dirStat) == 0){
+		return (dirStat.st_mode & S_IFDIR) != 0;
+	}
+#ifdef _WIN32
+	const int status = _mkdir(path.c_str());
+#else
+	const int status = mkdir(path.c_str(), 0755);
+#endif
+	// Another loading thread might have created it in the meantime.
+	if(status != 0 && errno == EEXIST && stat(path.c_str(), &dirStat) == 0 && (dirStat.st_mode & S_IFDIR) != 0){
+		return true;
+	}
+	if(status != 0){
+		Log::Error() << Log::Resources << "Unable to create directory at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Resources::getExternalFileStamp(const std::string & path, SourceStamp & stamp){
+	struct stat fileStat;
+	if(stat(path.c_str(), &fileStat) != 0){
+		return false;
+	}
+	stamp.size = (uint64_t)fileStat.st_size;
+	// Seconds are too coarse: a same-size edit in the same second would be considered unchanged.
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if(GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)){
+		// In 100ns intervals.
+		stamp.time = (uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32) | uint64_t(attributes.ftLastWriteTime.dwLowDateTime);
+	} else {
+		stamp.time = (uint64_t)fileStat.st_mtime;
+	}
+#elif defined(__APPLE__)
+	stamp.time = uint64_t(fileStat.st_mtimespec.tv_sec) * 1000000000ull + uint64_t(fileStat.st_mtimespec.tv_nsec);
+#else
+	stamp.time = uint64_t(fileStat.st_mtim.tv_sec) * 1000000000ull + uint64_t(fileStat.st_mtim.tv_nsec);
+#endif
+	return true;
+}
+
+void Resources::listFiles(const std::string & directoryPath, std::vector<std::string> & paths){
+	// Open directory.
+	tinydir_dir dir;
+	
+	if(tinydir_open_wrap(&dir, directoryPath) == -1){
+		tinydir_close(&dir);
+		Log::Error() << Log::Resources << "Unable to open resources directory at path \"" << directoryPath << "\"" << std::endl;
+	}
+	// For each file in dir.
+	while (dir.has_next) {
+		tinydir_file file;
+		if(tinydir_readfile(&dir, &file) == -1){
+			// Handle any read error.
+			Log::Error() << Log::Resources << "Error getting file in directory \"" << TCHARToString(dir.path) << "\"" << std::endl;
+			
+		} else if(file.is_dir){
+			// Extract subdirectory name, check that it isn't a special dir, and recursively aprse it.
+			const std::string dirName = TCHARToString(file.name);
+			if(dirName.size() > 0 && dirName != "." && dirName != ".."){
+				// @CHECK: "/" separator on Windows.
+				listFiles(directoryPath + "/" + dirName, paths);
+			}
+			
+		} else {
+			// Else, we have a regular file.
+			const std::string fileNameWithExt = TCHARToString(file.name);
+			// Filter empty files and system files.
+			if(fileNameWithExt.size() > 0 && fileNameWithExt.at(0) != '.' ){
+				// Store the file path.
+				// @CHECK: "/" separator on Windows.
+				paths.push_back(TCHARToString(dir.path) + "/" + fileNameWithExt);
+			}
+		}
+		// Get to next file.
+		if (tinydir_next(&dir) == -1){
+			// Reach end of dir early.
+			break;
+		}
+		
+	}
+	tinydir_close(&dir);
+}
+
 std::string Resources::loadStringFromExternalFile(const std::string & filename) {
 	std::ifstream in;
 	// Open a stream to the file.
@@ -426,5 +1531,11 @@ std::string Resources::trim(const std::string & str, const std::string & del){
 }
 
 
-Resources::~Resources(){ }
+Resources::~Resources(){
+	// Finish the background loads first, they rely on the other members.
+	_pool.reset();
+	if(_archive){
+		mz_zip_reader_end(_archive.get());
+	}
+}
 
@@ -3,11 +3,47 @@
 
 #include "../helpers/GLUtilities.hpp"
 #include "../helpers/ProgramInfos.hpp"
+#include "../helpers/UploadRing.hpp"
+#include "MeshCache.hpp"
+#include "TextureCache.hpp"
+#include "ImageUtilities.hpp"
+#include "AssetPack.hpp"
+#include "AssetIndex.hpp"
+#include "AssetManifest.hpp"
 #include <gl3w/gl3w.h>
+#include <miniz/miniz.h>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+
+class ThreadPool;
+class ByteSource;
+class FileWatcher;
+
+/// Resource loaded in the background. The infos are updated on the main thread once the data has been uploaded.
+template<typename T>
+struct AsyncResource {
+	T infos; ///< Placeholder content until ready.
+	bool ready;
+	AsyncResource() : ready(false) {}
+};
+
+typedef AsyncResource<TextureInfos> AsyncTexture;
+typedef AsyncResource<MeshInfos> AsyncMesh;
+
+/// Resource kept by the manager. It can be released once the manager holds the only reference to it.
+template<typename T>
+struct CachedResource {
+	std::shared_ptr<AsyncResource<T>> resource;
+	unsigned long long lastUse; ///< Index of the last request, for least recently used eviction.
+	std::vector<std::vector<std::string>> paths; ///< Source files, to reload the resource when they change.
+	bool srgb; ///< Textures only.
+	CachedResource() : lastUse(0), srgb(false) {}
+};
 
 class Resources {
 	
@@ -28,23 +64,120 @@ private:
 	
 	void parseArchive(const std::string & archivePath);
 	
+	void parsePack();
+	
 	void parseDirectory(const std::string & directoryPath);
 	
-	const std::string getImagePath(const std::string & name);
+	/// Read-only access to the content of a resource file, by ranges. Files on disk are mapped, asset pack entries
+	/// are used in place and archive entries are inflated progressively. NULL if the file can't be opened.
+	std::unique_ptr<ByteSource> openSource(const std::string & path);
+	
+	/// Get the size and modification time (or checksum when packaged) of a resource file.
+	bool getFileStamp(const std::string & path, SourceStamp & stamp);
+	
+	/// Ask the system to read a resource file in the background, as stored: compressed entries are not inflated.
+	/// Return the number of bytes requested, 0 if the file can't be found.
+	size_t readaheadSource(const std::string & path);
+	
+	/// Check if a resource file still matches the stamp stored in a cached or baked file.
+	/// The size and modification time are compared first, then the content hash.
+	bool isSourceUnchanged(const std::string & path, const SourceStamp & cachedStamp, SourceStamp & stamp);
+	
+	/// Map the baked versions of a set of images, if they all exist and are up to date. Compressed versions use the ".bc.tex" suffix.
+	/// If a processing is given, the baked files have to match it.
+	bool getBakedImages(const std::vector<std::string> & paths, const bool cubemap, std::vector<ImageView> & images, std::vector<std::unique_ptr<MappedFile>> & files, const std::string & suffix = ".tex", const TextureProcessing * processing = NULL);
+	
+	/// Background loading, see LoadRequest.
+	struct LoadRequest;
+	
+	/// 1x1 texture displayed while the real one is loading.
+	const TextureInfos & getPlaceholder(const bool cubemap, const bool srgb);
+	
+	/// Find the files of a texture or cubemap, either a single image or custom mipmap levels. Return false if there are none.
+	bool findTexturePaths(const std::string & name, const bool cubemap, std::vector<std::vector<std::string>> & paths) const;
+	
+	const std::shared_ptr<AsyncTexture> requestTexture(const std::string & name, const std::vector<std::vector<std::string>> & paths, const bool cubemap, const bool srgb);
+	
+	/// Queue a request on the loading threads.
+	void submitRequest(const std::shared_ptr<LoadRequest> & request);
+	
+	/// Load the CPU data of a request, unless another thread already started it. Can be called from any thread.
+	/// Its steps are split on 'threads' threads: pool workers use one, the other workers being busy with other requests.
+	void processRequest(LoadRequest & request, const unsigned int threads);
+	
+	void loadTextureData(LoadRequest & request);
+	
+	/// Replace the loaded images by block compressed versions, and save these in the cache.
+	void compressTextureData(LoadRequest & request);
 	
-	const std::vector<std::string> getCubemapPaths(const std::string & name);
+	/// Copy the loaded images to the upload ring when there is room, releasing their sources.
+	void stageTextureData(LoadRequest & request);
 	
-	char * getRawData(const std::string & path, size_t & size);
+	void loadMeshData(LoadRequest & request);
+	
+	/// Wait for a request to be loaded and upload it.
+	void finishRequest(const std::shared_ptr<LoadRequest> request);
+	
+	void finishRequest(const std::shared_ptr<AsyncTexture> & texture);
+	
+	void finishRequest(const std::shared_ptr<AsyncMesh> & mesh);
+	
+	/// GL upload of a loaded request, on the main thread.
+	void uploadRequest(LoadRequest & request);
+	
+	/// Load again a resource from its source files, keeping the current version until the new one is uploaded.
+	bool reloadResource(const std::string & name, CachedResource<TextureInfos> & entry);
+	
+	bool reloadResource(const std::string & name, CachedResource<MeshInfos> & entry);
+	
+	bool submitReload(const std::string & name, const std::vector<std::vector<std::string>> & paths, const std::shared_ptr<LoadRequest> & request);
 	
 public:
 
 	const std::string getString(const std::string & filename);
 	
-	const MeshInfos getMesh(const std::string & name);
+	/// Load a mesh and wait for it to be uploaded. As for asynchronous requests, keep the handle while using the mesh:
+	/// its GL ids can change when reloaded, and it can be released once no handle remains.
+	const std::shared_ptr<AsyncMesh> getMesh(const std::string & name);
+	
+	/// Load a texture and wait for it to be uploaded. The handle keeps its placeholder if loading failed.
+	const std::shared_ptr<AsyncTexture> getTexture(const std::string & name, bool srgb = true);
+	
+	const std::shared_ptr<AsyncTexture> getCubemap(const std::string & name, bool srgb = true);
+	
+	/// Request a mesh to be loaded in the background, the handle becomes ready when uploaded by pumpUploads.
+	const std::shared_ptr<AsyncMesh> getMeshAsync(const std::string & name);
 	
-	const TextureInfos getTexture(const std::string & name, bool srgb = true);
+	/// Request a texture to be loaded in the background. Until uploaded by pumpUploads, the handle contains a placeholder.
+	const std::shared_ptr<AsyncTexture> getTextureAsync(const std::string & name, bool srgb = true);
 	
-	const TextureInfos getCubemap(const std::string & name, bool srgb = true);
+	const std::shared_ptr<AsyncTexture> getCubemapAsync(const std::string & name, bool srgb = true);
+	
+	/// Upload resources loaded in the background until the time budget (in milliseconds) is spent.
+	/// To be called on the main thread each frame. Return the number of requests still pending.
+	size_t pumpUploads(const double budgetMs);
+	
+	/// Wait for all requests to be loaded and upload them.
+	void finishUploads();
+	
+	/// Resident resources and the GPU memory they use.
+	struct Stats {
+		size_t textures;
+		size_t textureBytes;
+		size_t meshes;
+		size_t meshBytes;
+		size_t programs;
+		Stats() : textures(0), textureBytes(0), meshes(0), meshBytes(0), programs(0) {}
+	};
+	
+	const Stats stats() const;
+	
+	/// Set the GPU memory budget of textures and meshes, in bytes (0 for no limit). When it is exceeded,
+	/// the least recently requested resources that are not used anymore are released.
+	void setMemoryBudget(const size_t bytes);
+	
+	/// Release the resources that are not used anymore, either until the budget is met or all of them.
+	void collect(const bool all = false);
 	
 	const std::string getShader(const std::string & name, const ShaderType & type);
 	
@@ -54,10 +187,60 @@ public:
 	
 	void reload();
 	
+	/// Watch the resources directory for modified files (unavailable when packaged).
+	void setHotReload(const bool enable);
+	
+	/// Reload the shaders, textures and meshes whose files were modified since the last call,
+	/// along with the programs using them. Return the number of reloaded resources.
+	size_t reloadChanged();
+	
+	/// Record the resources requested from now on in a manifest, until called with NULL.
+	void recordManifest(AssetManifest * manifest);
+	
+	/// Read the manifest named 'name.manifest' from the resources. Return false if there is none.
+	bool loadManifest(const std::string & name, AssetManifest & manifest);
+	
+	/// Save a manifest as 'name.manifest' in the resources directory, replacing the existing one (unavailable when packaged).
+	bool saveManifest(const std::string & name, const AssetManifest & manifest);
+	
+	/// Ask the system to read all the files of the manifest resources in the background, then request
+	/// the resources so that they are decoded while the following ones are still read.
+	void prefetch(const AssetManifest & manifest);
+	
+	/// Set the number of threads used when loading resources. Pending requests are finished first.
+	void setLoadingThreads(const unsigned int threads);
+	
+	/// Stream texture uploads through a persistently mapped pixel buffer of the given size in bytes,
+	/// written by the loading threads (0 to upload from client memory). Pending requests are finished first.
+	void setUploadBuffer(const size_t bytes);
+	
+	/// Generate the mip levels of the textures decoded from now on with the given filter, on the loading threads
+	/// instead of on the GPU. sRGB textures are filtered in linear space. Pending requests are finished first.
+	void setCPUMipmaps(const bool enable, const ImageUtilities::MipFilter filter = ImageUtilities::KaiserFilter);
+	
+	/// Compress the textures loaded from now on on the loading threads, caching the results. Colors use BC1/BC3,
+	/// textures named "*normal*" BC5, other data BC4/BC7 and HDR cubemaps BC6H. Formats unsupported by the GPU
+	/// and HDR 2D textures stay uncompressed. Their mip chains are always generated on the CPU. Pending requests are finished first.
+	void setTextureCompression(const bool enable);
+	
+	/// Upload the meshes loaded from now on with interleaved quantized vertices. Pending requests are finished first.
+	void setPackedVertices(const bool packed);
+	
+	bool packedVertices() const { return _packedVertices; }
+	
+	/// Load a whole file from disk, in a buffer that the caller has to release with free.
 	static char * loadRawDataFromExternalFile(const std::string & path, size_t & size);
 	
 	static std::string loadStringFromExternalFile(const std::string & filename);
 	
+	/// Size and modification time of a file on disk, with sub-second precision.
+	static bool getExternalFileStamp(const std::string & path, SourceStamp & stamp);
+	
+	/// Create a directory if it doesn't exist yet. Safe to call concurrently from the loading threads.
+	static bool createDirectory(const std::string & path);
+	
+	static void listFiles(const std::string & directoryPath, std::vector<std::string> & paths);
+	
 	static std::string trim(const std::string & str, const std::string & del);
 	
 private:
@@ -72,14 +255,79 @@ private:
 	
 	const std::string _rootPath;
 	
-	std::map<std::string, std::string> _files;
+	/// Directory where processed resources are cached.
+	const std::string _cachePath;
+	
+	/// Files by name, and images by base name.
+	AssetIndex _files;
+	
+	/// Archive opened once when packaged, and the index of each file path in it.
+	std::unique_ptr<mz_zip_archive> _archive;
+	
+	std::unordered_map<std::string, unsigned int> _archiveIndices;
+	
+	/// The archive file, only used to prefetch entries.
+	std::unique_ptr<ByteSource> _archiveFile;
+	
+	/// The archive can't be read by multiple threads at once.
+	std::mutex _archiveMutex;
+	
+	/// Memory-mapped asset pack, used instead of the archive when present.
+	AssetPack _pack;
 	
-	std::map<std::string, TextureInfos> _textures;
+	std::map<std::string, CachedResource<TextureInfos>> _textures;
 	
-	std::map<std::string, MeshInfos> _meshes;
+	std::map<std::string, CachedResource<MeshInfos>> _meshes;
+	
+	/// Resident GPU memory and its limit (0 for no limit), in bytes.
+	size_t _textureBytes;
+	
+	size_t _meshBytes;
+	
+	size_t _memoryBudget;
+	
+	/// Requests counter, to order the resources by last use.
+	unsigned long long _requestsCount;
+	
+	/// Loading threads, started with the first request.
+	std::unique_ptr<ThreadPool> _pool;
+	
+	/// Requests not uploaded yet, in submission order. Only accessed on the main thread.
+	std::vector<std::shared_ptr<LoadRequest>> _requests;
+	
+	/// Protect the state of the requests shared with the loading threads.
+	std::mutex _requestsMutex;
+	
+	std::condition_variable _requestsCondition;
+	
+	/// Pixel buffer memory the loading threads copy textures to.
+	UploadRing _uploadRing;
+	
+	/// Placeholders for 2D linear, 2D sRGB, cube linear, cube sRGB textures.
+	TextureInfos _placeholders[4];
 	
 	std::map<std::string, std::shared_ptr<ProgramInfos>> _programs;
 	
+	/// Manifest recording the requests, NULL if not recording.
+	AssetManifest * _recording;
+	
+	/// Modified files notifications, when hot reloading.
+	std::unique_ptr<FileWatcher> _watcher;
+	
+	unsigned int _loadingThreads;
+	
+	bool _packedVertices;
+	
+	/// Generate the missing mip levels on the loading threads, and the filter used.
+	bool _cpuMipmaps;
+	
+	ImageUtilities::MipFilter _mipmapFilter;
+	
+	/// Compress the textures on the loading threads, and the formats supported by the GPU (bits indexed by format).
+	bool _compression;
+	
+	unsigned int _compressionFormats;
+	
 };
 
 #endif
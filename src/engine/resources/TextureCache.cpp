@@ -0,0 +1,156 @@
+#include "TextureCache.hpp"
+#include "../helpers/Logger.hpp"
+#include <fstream>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+/// Bump the version whenever the layout or the processing applied to the images changes.
+static const uint32_t kTextureCacheVersion = 4;
+static const char kTextureCacheMagic[4] = { 'G', 'L', 'T', 'X' };
+
+enum TextureCacheFlags {
+	TextureHDR = 1, TextureFlipped = 2, TextureHalf = 4, TextureSRGB = 8, TextureNormalMap = 16
+};
+
+/// File header, followed by each mip level in order.
+struct TextureCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceSize;
+	uint64_t sourceTime;
+	uint64_t sourceHash;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+	uint32_t channels;
+	uint32_t flags;
+	uint32_t compression;
+	uint32_t mipFilter;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(TextureCacheHeader) == 64, "Unexpected texture cache header size.");
+
+
+size_t ImageView::levelSize(unsigned int level) const {
+	const size_t levelWidth = std::max(1u, width >> level);
+	const size_t levelHeight = std::max(1u, height >> level);
+	if(compression != BlockCompression::None){
+		return BlockCompression::imageSize(compression, (unsigned int)levelWidth, (unsigned int)levelHeight);
+	}
+	const size_t channelSize = hdr ? (half ? sizeof(uint16_t) : sizeof(float)) : sizeof(unsigned char);
+	return levelWidth * levelHeight * channels * channelSize;
+}
+
+bool TextureCache::save(const std::string & path, const ImageView & image, const SourceStamp & stamp, const TextureProcessing & processing){
+	TextureCacheHeader header;
+	std::memset(&header, 0, sizeof(TextureCacheHeader));
+	std::memcpy(header.magic, kTextureCacheMagic, 4);
+	header.version = kTextureCacheVersion;
+	header.sourceSize = stamp.size;
+	header.sourceTime = stamp.time;
+	header.sourceHash = stamp.hash;
+	header.width = image.width;
+	header.height = image.height;
+	header.levels = (uint32_t)image.levels.size();
+	header.channels = image.channels;
+	header.flags = (image.hdr ? TextureHDR : 0) | (image.half ? TextureHalf : 0) | (image.flipped ? TextureFlipped : 0);
+	header.flags |= (processing.srgb ? TextureSRGB : 0) | (processing.normalMap ? TextureNormalMap : 0);
+	header.compression = (uint32_t)image.compression;
+	header.mipFilter = processing.mipFilter;
+
+	// Same as mesh caches, write to a temporary file first.
+	const std::string tempPath = path + ".tmp";
+	std::ofstream outputFile(tempPath, std::ios::binary);
+	if(!outputFile.is_open()){
+		Log::Error() << Log::Resources << "Unable to write baked texture at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	outputFile.write((const char *)&header, sizeof(TextureCacheHeader));
+	for(unsigned int level = 0; level < header.levels; ++level){
+		outputFile.write((const char *)image.levels[level], image.levelSize(level));
+	}
+	const bool success = !outputFile.fail();
+	outputFile.close();
+	if(!success){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to write baked texture at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+#ifdef _WIN32
+	std::remove(path.c_str());
+#endif
+	if(std::rename(tempPath.c_str(), path.c_str()) != 0){
+		std::remove(tempPath.c_str());
+		Log::Error() << Log::Resources << "Unable to write baked texture at path \"" << path << "\"." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool TextureCache::load(const std::string & path, MappedFile & file, ImageView & image, SourceStamp & stamp, TextureProcessing & processing){
+	if(!file.open(path)){
+		return false;
+	}
+	if(file.size() < sizeof(TextureCacheHeader)){
+		file.close();
+		return false;
+	}
+	TextureCacheHeader header;
+	std::memcpy(&header, file.data(), sizeof(TextureCacheHeader));
+	if(std::memcmp(header.magic, kTextureCacheMagic, 4) != 0 || header.version != kTextureCacheVersion
+	   || header.levels == 0 || header.levels > levelsCount(header.width, header.height) || header.compression > BlockCompression::BC7){
+		file.close();
+		return false;
+	}
+	image.width = header.width;
+	image.height = header.height;
+	image.channels = header.channels;
+	image.hdr = (header.flags & TextureHDR) != 0;
+	image.half = image.hdr && (header.flags & TextureHalf) != 0;
+	image.flipped = (header.flags & TextureFlipped) != 0;
+	image.compression = BlockCompression::Format(header.compression);
+	image.levels.resize(header.levels);
+
+	// Check that the levels exactly fill the file.
+	size_t offset = sizeof(TextureCacheHeader);
+	for(unsigned int level = 0; level < header.levels; ++level){
+		image.levels[level] = file.data() + offset;
+		offset += image.levelSize(level);
+	}
+	if(offset != file.size()){
+		image.levels.clear();
+		file.close();
+		return false;
+	}
+	stamp.size = header.sourceSize;
+	stamp.time = header.sourceTime;
+	stamp.hash = header.sourceHash;
+	processing.srgb = (header.flags & TextureSRGB) != 0;
+	processing.normalMap = (header.flags & TextureNormalMap) != 0;
+	processing.mipFilter = header.mipFilter;
+	return true;
+}
+
+bool TextureCache::restamp(const std::string & path, const SourceStamp & stamp){
+	std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+	if(!file.is_open()){
+		return false;
+	}
+	const uint64_t values[3] = { stamp.size, stamp.time, stamp.hash };
+	file.seekp(offsetof(TextureCacheHeader, sourceSize));
+	file.write((const char *)values, sizeof(values));
+	return !file.fail();
+}
+
+unsigned int TextureCache::levelsCount(unsigned int width, unsigned int height){
+	unsigned int levels = 1;
+	unsigned int size = std::max(width, height);
+	while(size > 1){
+		size /= 2;
+		++levels;
+	}
+	return levels;
+}
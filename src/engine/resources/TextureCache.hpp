@@ -0,0 +1,64 @@
+#ifndef TextureCache_h
+#define TextureCache_h
+
+#include "MeshCache.hpp"
+#include "MappedFile.hpp"
+#include "BlockCompression.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/// Non-owning view on a decoded image and its mip chain, either in memory or in a memory-mapped baked file.
+/// LDR images have 4 unsigned byte channels, HDR images 3 float or half-float channels. Compressed images
+/// keep the description of their source but store blocks of pixels.
+struct ImageView {
+	unsigned int width;
+	unsigned int height;
+	unsigned int channels;
+	bool hdr;
+	bool half; ///< HDR channels are 16-bit floats.
+	bool flipped;
+	BlockCompression::Format compression;
+	std::vector<const void *> levels;
+
+	ImageView() : width(0), height(0), channels(0), hdr(false), half(false), flipped(false), compression(BlockCompression::None) {}
+
+	/// Size in bytes of a given mip level.
+	size_t levelSize(unsigned int level) const;
+};
+
+/// Processing applied to the source of a baked file. A baked file is stale if it doesn't match the current settings.
+struct TextureProcessing {
+	bool srgb; ///< Levels filtered and blocks encoded as sRGB colors.
+	bool normalMap; ///< Blocks encoded as a normal map.
+	uint32_t mipFilter; ///< ImageUtilities::MipFilter used to generate the levels, or LoadedLevels.
+
+	/// All the levels come from source files.
+	static const uint32_t LoadedLevels = 0xFFFFFFFF;
+
+	TextureProcessing() : srgb(false), normalMap(false), mipFilter(LoadedLevels) {}
+
+	bool operator==(const TextureProcessing & other) const { return srgb == other.srgb && normalMap == other.normalMap && mipFilter == other.mipFilter; }
+};
+
+/// Baked texture format: a fixed header followed by all mip levels, ready to be uploaded to the GPU.
+class TextureCache {
+
+public:
+
+	/// Write the image levels, the stamp of its source and the processing applied to it to a baked file. Return false on failure.
+	static bool save(const std::string & path, const ImageView & image, const SourceStamp & stamp, const TextureProcessing & processing);
+
+	/// Map a baked file and expose its content. Return false if the file is missing or invalid.
+	/// The view is only valid while the file stays mapped.
+	static bool load(const std::string & path, MappedFile & file, ImageView & image, SourceStamp & stamp, TextureProcessing & processing);
+
+	/// Update the source stamp of an existing baked file in place.
+	static bool restamp(const std::string & path, const SourceStamp & stamp);
+
+	/// Number of levels in a full mip chain down to 1x1.
+	static unsigned int levelsCount(unsigned int width, unsigned int height);
+
+};
+
+#endif
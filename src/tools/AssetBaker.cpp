@@ -0,0 +1,203 @@
+#include "Config.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "resources/MeshUtilities.hpp"
+#include "resources/ImageUtilities.hpp"
+#include "resources/MeshCache.hpp"
+#include "resources/TextureCache.hpp"
+#include "helpers/Logger.hpp"
+#include <stdio.h>
+#include <string>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+
+/// Offline baking of the resources: meshes are parsed and processed, images are decoded and
+/// their mipmaps generated, so that loading them at runtime only requires mapping the files.
+/// Only the assets whose sources changed since the last run are rebuilt.
+
+enum BakeResult {
+	Baked, UpToDate, Failed
+};
+
+/// Check if a baked file was generated from the current version of a source file.
+/// If only the modification time changed, the baked file is restamped.
+bool isUpToDate(const std::string & sourcePath, const std::string & bakedPath, const SourceStamp & cachedStamp, SourceStamp & stamp, bool (*restamp)(const std::string &, const SourceStamp &)){
+	if(cachedStamp.size != stamp.size){
+		return false;
+	}
+	if(cachedStamp.time == stamp.time){
+		stamp.hash = cachedStamp.hash;
+		return true;
+	}
+	size_t rawSize = 0;
+	char * rawContent = Resources::loadRawDataFromExternalFile(sourcePath, rawSize);
+	if(rawContent == NULL){
+		return false;
+	}
+	stamp.hash = MeshCache::hash(rawContent, rawSize);
+	free(rawContent);
+	if(stamp.hash != cachedStamp.hash){
+		return false;
+	}
+	restamp(bakedPath, stamp);
+	return true;
+}
+
+BakeResult bakeMesh(const std::string & sourcePath, const std::string & bakedPath, SourceStamp & stamp, const bool force){
+	if(!force){
+		MappedFile bakedFile;
+		MeshView cachedMesh;
+		SourceStamp cachedStamp;
+		const bool exists = MeshCache::load(bakedPath, bakedFile, cachedMesh, cachedStamp);
+		bakedFile.close();
+		if(exists && isUpToDate(sourcePath, bakedPath, cachedStamp, stamp, &MeshCache::restamp)){
+			return UpToDate;
+		}
+	}
+	size_t rawSize = 0;
+	char * rawContent = Resources::loadRawDataFromExternalFile(sourcePath, rawSize);
+	if(rawContent == NULL){
+		return Failed;
+	}
+	// Same processing as in Resources::getMesh.
+	Mesh mesh;
+	MeshUtilities::loadObj(rawContent, rawSize, mesh, MeshUtilities::Indexed, std::max(1u, std::thread::hardware_concurrency()));
+	stamp.hash = MeshCache::hash(rawContent, rawSize);
+	free(rawContent);
+	if(mesh.positions.empty()){
+		return Failed;
+	}
+	MeshUtilities::optimize(mesh);
+	MeshUtilities::computeTangentsAndBinormals(mesh, std::max(1u, std::thread::hardware_concurrency()));
+	MeshUtilities::generateLods(mesh);
+	return MeshCache::save(bakedPath, mesh, stamp) ? Baked : Failed;
+}
+
+BakeResult bakeImage(const std::string & sourcePath, const std::string & bakedPath, const bool cubemapFace, const ImageUtilities::MipFilter filter, SourceStamp & stamp, const bool force){
+	if(!force){
+		MappedFile bakedFile;
+		ImageView cachedImage;
+		SourceStamp cachedStamp;
+		TextureProcessing cachedProcessing;
+		const bool exists = TextureCache::load(bakedPath, bakedFile, cachedImage, cachedStamp, cachedProcessing);
+		bakedFile.close();
+		// Baked with another filter, bake again.
+		if(exists && cachedProcessing.mipFilter == (uint32_t)filter && isUpToDate(sourcePath, bakedPath, cachedStamp, stamp, &TextureCache::restamp)){
+			return UpToDate;
+		}
+	}
+
+	ImageView image;
+	image.hdr = ImageUtilities::isHDR(sourcePath);
+	// Same orientation as GLUtilities::loadTexture: 2D LDR images are flipped, cubemap faces and HDR images aren't.
+	image.flipped = !cubemapFace && !image.hdr;
+	image.channels = image.hdr ? 3 : 4;
+	void * data = NULL;
+	// HDR images stored as half-floats are baked as is.
+	if(ImageUtilities::loadImage(sourcePath, image.width, image.height, image.channels, &data, image.flipped, true, &image.half) != 0 || data == NULL){
+		free(data);
+		return Failed;
+	}
+
+	// Generate the full mip chain. Whether an image is used as sRGB is only known at runtime, all are filtered as linear data,
+	// and sRGB textures only use the base level.
+	std::vector<void *> buffers(1, data);
+	image.levels.push_back(data);
+	if(!ImageUtilities::generateMipmaps(image, false, filter, buffers)){
+		for(void * buffer : buffers){
+			free(buffer);
+		}
+		return Failed;
+	}
+
+	// Hash the source for the stale check.
+	size_t rawSize = 0;
+	char * rawContent = Resources::loadRawDataFromExternalFile(sourcePath, rawSize);
+	stamp.hash = rawContent != NULL ? MeshCache::hash(rawContent, rawSize) : 0;
+	free(rawContent);
+
+	TextureProcessing processing;
+	processing.mipFilter = (uint32_t)filter;
+	const bool success = TextureCache::save(bakedPath, image, stamp, processing);
+	for(void * buffer : buffers){
+		free(buffer);
+	}
+	return success ? Baked : Failed;
+}
+
+/// The main function
+
+int main(int argc, char** argv) {
+
+	// Arguments parsing.
+	std::map<std::string, std::string> arguments;
+	Config::parseFromArgs(argc, argv, arguments);
+	// By default, use the same locations as the Resources manager.
+	const std::string resourcesPath = arguments.count("resources") > 0 ? arguments["resources"] : "../../../resources";
+	const std::string outputPath = arguments.count("output") > 0 ? arguments["output"] : (resourcesPath + "_cache");
+	const bool force = arguments.count("force") > 0;
+	const ImageUtilities::MipFilter filter = arguments.count("mip-filter") > 0 && arguments["mip-filter"] == "kaiser" ? ImageUtilities::KaiserFilter : ImageUtilities::BoxFilter;
+
+	std::vector<std::string> paths;
+	Resources::listFiles(resourcesPath, paths);
+	if(paths.empty() || !Resources::createDirectory(outputPath)){
+		Log::Error() << Log::Utilities << "Specify a valid resources directory (--resources <dir>) and output directory (--output <dir>), [--force], [--mip-filter box|kaiser]." << std::endl;
+		return 3;
+	}
+
+	const std::vector<std::string> imageExtensions = { "png", "jpg", "jpeg", "bmp", "tga", "exr" };
+	const std::vector<std::string> faceSuffixes = { "_px", "_nx", "_py", "_ny", "_pz", "_nz" };
+
+	std::ofstream manifest(outputPath + "/manifest.txt");
+	manifest << "# type baked-file source-size source-time source-hash source-path" << std::endl;
+
+	unsigned int counts[3] = { 0, 0, 0 };
+	for(const auto & path : paths){
+		const std::string fileNameWithExt = path.substr(path.find_last_of("/\\") + 1);
+		const std::string::size_type extPos = fileNameWithExt.find_last_of(".");
+		if(extPos == std::string::npos){
+			continue;
+		}
+		const std::string name = fileNameWithExt.substr(0, extPos);
+		std::string extension = fileNameWithExt.substr(extPos + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		SourceStamp stamp;
+		if(!Resources::getExternalFileStamp(path, stamp)){
+			continue;
+		}
+
+		// Baked files are named the same way Resources looks them up.
+		std::string type;
+		std::string bakedName;
+		BakeResult result;
+		if(extension == "obj"){
+			type = "mesh";
+			bakedName = name + ".mesh";
+			result = bakeMesh(path, outputPath + "/" + bakedName, stamp, force);
+		} else if(std::find(imageExtensions.begin(), imageExtensions.end(), extension) != imageExtensions.end()){
+			const bool cubemapFace = name.size() > 3 && std::find(faceSuffixes.begin(), faceSuffixes.end(), name.substr(name.size() - 3)) != faceSuffixes.end();
+			type = "texture";
+			bakedName = fileNameWithExt + ".tex";
+			result = bakeImage(path, outputPath + "/" + bakedName, cubemapFace, filter, stamp, force);
+		} else {
+			continue;
+		}
+
+		++counts[result];
+		if(result == Failed){
+			Log::Error() << Log::Utilities << "Unable to bake " << path << "." << std::endl;
+			continue;
+		}
+		if(result == Baked){
+			Log::Info() << Log::Utilities << "Baked " << path << "." << std::endl;
+		}
+		manifest << type << " " << bakedName << " " << stamp.size << " " << stamp.time << " " << stamp.hash << " " << path << std::endl;
+	}
+	manifest.close();
+
+	Log::Info() << Log::Utilities << "Baking done: " << counts[Baked] << " baked, " << counts[UpToDate] << " up to date, " << counts[Failed] << " failed." << std::endl;
+	return counts[Failed] == 0 ? 0 : 1;
+}
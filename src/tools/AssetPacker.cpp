@@ -0,0 +1,46 @@
+#include "Config.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "resources/AssetPack.hpp"
+#include "helpers/Logger.hpp"
+#include <stdio.h>
+#include <string>
+#include <map>
+#include <vector>
+
+/// Build an asset pack from the resources directory, to be mapped at runtime in packaged mode
+/// instead of the zip archive. Files are stored by their path relative to the resources directory.
+
+/// The main function
+
+int main(int argc, char** argv) {
+
+	// Arguments parsing.
+	std::map<std::string, std::string> arguments;
+	Config::parseFromArgs(argc, argv, arguments);
+	// By default, write the pack next to the resources directory, where Resources looks for it.
+	const std::string resourcesPath = arguments.count("resources") > 0 ? arguments["resources"] : "../../../resources";
+	const std::string outputPath = arguments.count("output") > 0 ? arguments["output"] : (resourcesPath + ".pack");
+	const bool compress = arguments.count("compress") > 0;
+
+	std::vector<std::string> paths;
+	Resources::listFiles(resourcesPath, paths);
+	if(paths.empty()){
+		Log::Error() << Log::Utilities << "Specify a valid resources directory (--resources <dir>), [--output <file>] [--compress]." << std::endl;
+		return 3;
+	}
+
+	std::vector<std::pair<std::string, std::string>> files;
+	for(const auto & path : paths){
+		std::string packPath = path.substr(resourcesPath.size());
+		while(!packPath.empty() && (packPath[0] == '/' || packPath[0] == '\\')){
+			packPath = packPath.substr(1);
+		}
+		files.emplace_back(packPath, path);
+	}
+
+	if(!AssetPack::write(outputPath, files, compress)){
+		return 1;
+	}
+	Log::Info() << Log::Utilities << "Packed " << files.size() << " files in " << outputPath << "." << std::endl;
+	return 0;
+}
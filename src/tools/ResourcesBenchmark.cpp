@@ -0,0 +1,1090 @@
+#include "Config.hpp"
+#include "resources/ResourcesManager.hpp"
+#include "resources/MeshUtilities.hpp"
+#include "resources/MeshCache.hpp"
+#include "resources/ImageUtilities.hpp"
+#include "resources/AssetIndex.hpp"
+#include "resources/PixelKernels.hpp"
+#include "resources/BlockCompression.hpp"
+#include "helpers/Logger.hpp"
+#include <glm/gtc/packing.hpp>
+#include <stdio.h>
+#include <string>
+#include <map>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+/// Timings of the resources loading code paths, on the bundled assets.
+
+/// Reference implementation: the previous stringstream-based OBJ parser, kept for comparison.
+
+void loadObjReference(std::istream & in, Mesh & mesh, MeshUtilities::LoadMode mode){
+	mesh.indices.clear();
+	mesh.positions.clear();
+	mesh.normals.clear();
+	mesh.texcoords.clear();
+	std::vector<glm::vec3> positions_temp;
+	std::vector<glm::vec3> normals_temp;
+	std::vector<glm::vec2> texcoords_temp;
+	std::vector<std::string> faces_temp;
+
+	std::string res;
+	while(!in.eof()){
+		getline(in,res);
+		if(res.empty() || res[0] == '#' || res.size()<2){
+			continue;
+		}
+		std::stringstream ss(res);
+		std::vector<std::string> tokens;
+		std::string token;
+		while(ss >> token){
+			tokens.push_back(token);
+		}
+		if(tokens.size() < 1){
+			continue;
+		}
+		if (tokens[0] == "v" && tokens.size() >= 4) {
+			positions_temp.push_back(glm::vec3(stof(tokens[1],NULL),stof(tokens[2],NULL),stof(tokens[3],NULL)));
+		} else if (tokens[0] == "vn" && tokens.size() >= 4){
+			normals_temp.push_back(glm::vec3(stof(tokens[1],NULL),stof(tokens[2],NULL),stof(tokens[3],NULL)));
+		} else if (tokens[0] == "vt" && tokens.size() >= 3) {
+			texcoords_temp.push_back(glm::vec2(stof(tokens[1],NULL),stof(tokens[2],NULL)));
+		} else if (tokens[0] == "f" && tokens.size() >= 4) {
+			faces_temp.push_back(tokens[1]);
+			faces_temp.push_back(tokens[2]);
+			faces_temp.push_back(tokens[3]);
+		}
+	}
+	if(positions_temp.size() == 0){
+		return;
+	}
+	const bool hasUV = texcoords_temp.size()>0;
+	const bool hasNormals = normals_temp.size()>0;
+
+	if (mode == MeshUtilities::Points){
+		mesh.positions = positions_temp;
+		if(hasNormals){
+			mesh.normals = normals_temp;
+		}
+		if(hasUV){
+			mesh.texcoords = texcoords_temp;
+		}
+		return;
+	}
+	std::map<std::string,unsigned int> indices_used;
+	unsigned int maxInd = 0;
+	for(size_t i = 0; i < faces_temp.size(); i++){
+		const std::string str = faces_temp[i];
+		if(mode == MeshUtilities::Indexed && indices_used.count(str)>0){
+			mesh.indices.push_back(indices_used[str]);
+			continue;
+		}
+		const size_t foundF = str.find_first_of("/");
+		const size_t foundL = str.find_last_of("/");
+		mesh.positions.push_back(positions_temp[stol(str.substr(0,foundF))-1]);
+		if(hasUV){
+			mesh.texcoords.push_back(texcoords_temp[stol(str.substr(foundF+1,foundL))-1]);
+		}
+		if(hasNormals){
+			mesh.normals.push_back(normals_temp[stol(str.substr(foundL+1))-1]);
+		}
+		mesh.indices.push_back(maxInd);
+		if(mode == MeshUtilities::Indexed){
+			indices_used[str] = maxInd;
+		}
+		maxInd++;
+	}
+}
+
+template<typename T>
+bool sameArrays(const std::vector<T> & a, const std::vector<T> & b){
+	return a.size() == b.size() && (a.empty() || std::memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0);
+}
+
+bool sameMeshes(const Mesh & a, const Mesh & b){
+	return sameArrays(a.positions, b.positions) && sameArrays(a.normals, b.normals)
+		&& sameArrays(a.texcoords, b.texcoords) && sameArrays(a.indices, b.indices);
+}
+
+/// Return the average duration of a function over a number of iterations, in milliseconds.
+template<typename F>
+double timeIt(const unsigned int iterations, F function){
+	const auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterations; ++i){
+		function();
+	}
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / double(iterations);
+}
+
+/// Generate the OBJ text of a regular grid with size x size quads, split in two triangles each.
+/// Positions, uvs and normals have distinct indices to exercise the vertex deduplication.
+std::string generateGridObj(const unsigned int size){
+	std::stringstream obj;
+	for(unsigned int y = 0; y <= size; ++y){
+		for(unsigned int x = 0; x <= size; ++x){
+			const float u = float(x) / float(size);
+			const float v = float(y) / float(size);
+			obj << "v " << (2.0f * u - 1.0f) << " " << (0.1f * std::sin(10.0f * u) * std::cos(10.0f * v)) << " " << (2.0f * v - 1.0f) << "\n";
+			obj << "vt " << u << " " << v << "\n";
+		}
+	}
+	obj << "vn 0.0 1.0 0.0\n";
+	for(unsigned int y = 0; y < size; ++y){
+		for(unsigned int x = 0; x < size; ++x){
+			const unsigned int i0 = y * (size + 1) + x + 1;
+			const unsigned int i1 = i0 + 1;
+			const unsigned int i2 = i0 + size + 1;
+			const unsigned int i3 = i2 + 1;
+			obj << "f " << i0 << "/" << i0 << "/1 " << i1 << "/" << i1 << "/1 " << i3 << "/" << i3 << "/1\n";
+			obj << "f " << i0 << "/" << i0 << "/1 " << i3 << "/" << i3 << "/1 " << i2 << "/" << i2 << "/1\n";
+		}
+	}
+	return obj.str();
+}
+
+/// Benchmarks.
+
+int benchmarkObj(const std::vector<std::pair<std::string, std::string>> & files, const unsigned int iterations, const unsigned int threads){
+	
+	const std::vector<std::string> modeNames = { "Expanded", "Points", "Indexed" };
+	const std::vector<MeshUtilities::LoadMode> modes = { MeshUtilities::Expanded, MeshUtilities::Points, MeshUtilities::Indexed };
+
+	int errors = 0;
+	double totalReference = 0.0;
+	double totalCurrent = 0.0;
+	double totalParallel = 0.0;
+	for(const auto & file : files){
+		const std::string & content = file.second;
+		
+		for(size_t mid = 0; mid < modes.size(); ++mid){
+			Mesh reference;
+			Mesh current;
+			const double referenceTime = timeIt(iterations, [&](){
+				std::stringstream contentStream(content);
+				loadObjReference(contentStream, reference, modes[mid]);
+			});
+			const double currentTime = timeIt(iterations, [&](){
+				MeshUtilities::loadObj(content.data(), content.size(), current, modes[mid]);
+			});
+			bool identical = sameMeshes(reference, current);
+			totalReference += referenceTime;
+			totalCurrent += currentTime;
+			
+			// Compose the line first, as the loader logs verbose messages.
+			std::stringstream line;
+			line << file.first << " (" << modeNames[mid] << "): " << referenceTime << "ms -> " << currentTime << "ms, x" << (referenceTime / std::max(currentTime, 1e-6));
+			
+			// Multi-threaded parsing.
+			if(threads > 1){
+				Mesh parallel;
+				const double parallelTime = timeIt(iterations, [&](){
+					MeshUtilities::loadObj(content.data(), content.size(), parallel, modes[mid], threads);
+				});
+				identical = identical && sameMeshes(reference, parallel);
+				totalParallel += parallelTime;
+				line << ", " << threads << " threads: " << parallelTime << "ms, x" << (referenceTime / std::max(parallelTime, 1e-6));
+			}
+			errors += identical ? 0 : 1;
+			Log::Info() << Log::Utilities << line.str() << (identical ? "" : " MISMATCH") << std::endl;
+		}
+	}
+	std::stringstream line;
+	line << "OBJ loading total: " << totalReference << "ms -> " << totalCurrent << "ms, x" << (totalReference / std::max(totalCurrent, 1e-6));
+	if(threads > 1){
+		line << ", " << threads << " threads: " << totalParallel << "ms, x" << (totalReference / std::max(totalParallel, 1e-6));
+	}
+	Log::Info() << Log::Utilities << line.str() << "." << std::endl;
+	return errors == 0 ? 0 : 2;
+}
+
+int benchmarkMeshCache(const std::vector<std::pair<std::string, std::string>> & files, const unsigned int iterations, const std::string & cacheDirectory){
+	
+	if(!Resources::createDirectory(cacheDirectory)){
+		return 1;
+	}
+	int errors = 0;
+	double totalParse = 0.0;
+	double totalCache = 0.0;
+	for(const auto & file : files){
+		const std::string & content = file.second;
+		const std::string cachePath = cacheDirectory + "/" + file.first + ".mesh";
+		SourceStamp stamp;
+		stamp.size = content.size();
+		stamp.hash = MeshCache::hash(content.data(), content.size());
+		
+		// Full processing: parsing and tangents computation.
+		Mesh mesh;
+		const double parseTime = timeIt(iterations, [&](){
+			MeshUtilities::loadObj(content.data(), content.size(), mesh, MeshUtilities::Indexed);
+			MeshUtilities::computeTangentsAndBinormals(mesh);
+		});
+		MeshCache::save(cachePath, mesh, stamp);
+		
+		// Mapping the cached version, touching all the data as an upload would.
+		bool identical = true;
+		const double cacheTime = timeIt(iterations, [&](){
+			MappedFile cacheFile;
+			MeshView view;
+			SourceStamp cachedStamp;
+			identical = MeshCache::load(cachePath, cacheFile, view, cachedStamp) && cachedStamp.hash == stamp.hash;
+			Mesh copy;
+			copy.positions.assign(view.positions.data, view.positions.data + view.positions.size);
+			copy.normals.assign(view.normals.data, view.normals.data + view.normals.size);
+			copy.tangents.assign(view.tangents.data, view.tangents.data + view.tangents.size);
+			copy.binormals.assign(view.binormals.data, view.binormals.data + view.binormals.size);
+			copy.texcoords.assign(view.texcoords.data, view.texcoords.data + view.texcoords.size);
+			copy.indices.assign(view.indices.data, view.indices.data + view.indices.size);
+			identical = identical && sameMeshes(mesh, copy) && sameArrays(mesh.tangents, copy.tangents) && sameArrays(mesh.binormals, copy.binormals);
+		});
+		totalParse += parseTime;
+		totalCache += cacheTime;
+		errors += identical ? 0 : 1;
+		Log::Info() << Log::Utilities << file.first << " (cache): " << parseTime << "ms -> " << cacheTime << "ms, x" << (parseTime / std::max(cacheTime, 1e-6)) << (identical ? "" : " MISMATCH") << std::endl;
+	}
+	Log::Info() << Log::Utilities << "Mesh cache total: " << totalParse << "ms -> " << totalCache << "ms, x" << (totalParse / std::max(totalCache, 1e-6)) << "." << std::endl;
+	return errors == 0 ? 0 : 2;
+}
+
+/// Decode an octahedral-encoded unit vector, as in the packed vertex shaders.
+glm::vec3 decodeOctahedral(const glm::vec2 & e){
+	glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	const float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+int benchmarkPacking(const std::vector<std::pair<std::string, std::string>> & files, const unsigned int iterations){
+	
+	for(const auto & file : files){
+		const std::string & content = file.second;
+		Mesh mesh;
+		MeshUtilities::loadObj(content.data(), content.size(), mesh, MeshUtilities::Indexed);
+		MeshUtilities::computeTangentsAndBinormals(mesh);
+		std::vector<PackedVertex> vertices;
+		const double packTime = timeIt(iterations, [&](){
+			MeshUtilities::packVertices(mesh, vertices);
+		});
+		
+		// Measure the precision loss on each attribute.
+		float maxNormalError = 0.0f;
+		float maxTangentError = 0.0f;
+		float maxUVError = 0.0f;
+		for(size_t vid = 0; vid < vertices.size(); ++vid){
+			const PackedVertex & vertex = vertices[vid];
+			if(!mesh.normals.empty()){
+				const glm::vec3 normal = decodeOctahedral(glm::vec2(vertex.normal) / 32767.0f);
+				maxNormalError = std::max(maxNormalError, std::acos(glm::clamp(glm::dot(normal, glm::normalize(mesh.normals[vid])), -1.0f, 1.0f)));
+			}
+			// Skip degenerate tangents.
+			if(!mesh.tangents.empty() && !std::isnan(mesh.tangents[vid].x)){
+				const glm::vec3 tangent = decodeOctahedral(glm::vec2(vertex.tangent.x, vertex.tangent.y) / 127.0f);
+				maxTangentError = std::max(maxTangentError, std::acos(glm::clamp(glm::dot(tangent, mesh.tangents[vid]), -1.0f, 1.0f)));
+			}
+			if(!mesh.texcoords.empty()){
+				const glm::vec2 uv(glm::unpackHalf1x16(vertex.texcoord.x), glm::unpackHalf1x16(vertex.texcoord.y));
+				maxUVError = std::max(maxUVError, glm::length(uv - mesh.texcoords[vid]));
+			}
+		}
+		const size_t separateSize = sizeof(glm::vec3) * (mesh.positions.size() + mesh.normals.size() + mesh.tangents.size() + mesh.binormals.size()) + sizeof(glm::vec2) * mesh.texcoords.size();
+		const size_t packedSize = sizeof(PackedVertex) * vertices.size();
+		Log::Info() << Log::Utilities << file.first << " (packed): " << separateSize << "B -> " << packedSize << "B, x" << (double(separateSize) / std::max(double(packedSize), 1.0)) << ", " << packTime << "ms. Max errors: normal " << glm::degrees(maxNormalError) << "deg, tangent " << glm::degrees(maxTangentError) << "deg, uv " << maxUVError << "." << std::endl;
+	}
+	return 0;
+}
+
+int benchmarkOptimization(const std::vector<std::pair<std::string, std::string>> & files){
+	
+	for(const auto & file : files){
+		const std::string & content = file.second;
+		Mesh mesh;
+		MeshUtilities::loadObj(content.data(), content.size(), mesh, MeshUtilities::Indexed);
+		if(mesh.indices.empty()){
+			continue;
+		}
+		const size_t verticesCount = mesh.positions.size();
+		float acmr[4], atvr[4];
+		MeshUtilities::analyzeVertexCache(mesh.indices, verticesCount, 16, acmr[0], atvr[0]);
+		double times[3];
+		times[0] = timeIt(1, [&](){ MeshUtilities::optimizeVertexCache(mesh); });
+		MeshUtilities::analyzeVertexCache(mesh.indices, verticesCount, 16, acmr[1], atvr[1]);
+		times[1] = timeIt(1, [&](){ MeshUtilities::optimizeOverdraw(mesh, 1.05f); });
+		MeshUtilities::analyzeVertexCache(mesh.indices, verticesCount, 16, acmr[2], atvr[2]);
+		times[2] = timeIt(1, [&](){ MeshUtilities::optimizeVertexFetch(mesh); });
+		MeshUtilities::analyzeVertexCache(mesh.indices, mesh.positions.size(), 16, acmr[3], atvr[3]);
+		Log::Info() << Log::Utilities << file.first << " (optimize): ACMR " << acmr[0] << " -> " << acmr[1] << " (cache, " << times[0] << "ms) -> " << acmr[2] << " (overdraw, " << times[1] << "ms) -> " << acmr[3] << " (fetch, " << times[2] << "ms), ATVR " << atvr[0] << " -> " << atvr[3] << "." << std::endl;
+	}
+	return 0;
+}
+
+/// The previous serial tangents computation, as a reference.
+void computeTangentsAndBinormalsReference(Mesh & mesh){
+	if(mesh.indices.size() * mesh.positions.size() * mesh.texcoords.size() == 0){
+		return;
+	}
+	mesh.tangents.clear();
+	mesh.binormals.clear();
+	for(size_t tid = 0; tid < mesh.positions.size(); ++tid){
+		mesh.tangents.push_back(glm::vec3(0.0f));
+		mesh.binormals.push_back(glm::vec3(0.0f));
+	}
+	for(size_t fid = 0; fid + 2 < mesh.indices.size(); fid += 3){
+		const unsigned int i0 = mesh.indices[fid];
+		const unsigned int i1 = mesh.indices[fid+1];
+		const unsigned int i2 = mesh.indices[fid+2];
+		const glm::vec3 deltaPosition1 = mesh.positions[i1] - mesh.positions[i0];
+		const glm::vec3 deltaPosition2 = mesh.positions[i2] - mesh.positions[i0];
+		const glm::vec2 deltaUv1 = mesh.texcoords[i1] - mesh.texcoords[i0];
+		const glm::vec2 deltaUv2 = mesh.texcoords[i2] - mesh.texcoords[i0];
+		const float det = 1.0f / (deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x);
+		const glm::vec3 tangent = det * (deltaPosition1 * deltaUv2.y - deltaPosition2 * deltaUv1.y);
+		const glm::vec3 binormal = det * (deltaPosition2 * deltaUv1.x - deltaPosition1 * deltaUv2.x);
+		mesh.tangents[i0] += tangent;
+		mesh.tangents[i1] += tangent;
+		mesh.tangents[i2] += tangent;
+		mesh.binormals[i0] += binormal;
+		mesh.binormals[i1] += binormal;
+		mesh.binormals[i2] += binormal;
+	}
+	for(size_t tid = 0; tid < mesh.tangents.size(); ++tid){
+		mesh.tangents[tid] = glm::normalize(mesh.tangents[tid] - mesh.normals[tid] * glm::dot(mesh.normals[tid], mesh.tangents[tid]));
+		if(glm::dot(glm::cross(mesh.normals[tid], mesh.tangents[tid]), mesh.binormals[tid]) < 0.0f){
+			mesh.tangents[tid] *= -1.0f;
+		}
+	}
+}
+
+/// Maximum difference between two sets of vectors, degenerate (NaN) vectors have to match.
+float maxDifference(const std::vector<glm::vec3> & a, const std::vector<glm::vec3> & b){
+	if(a.size() != b.size()){
+		return std::numeric_limits<float>::infinity();
+	}
+	float maxError = 0.0f;
+	for(size_t vid = 0; vid < a.size(); ++vid){
+		for(int i = 0; i < 3; ++i){
+			if(std::isnan(a[vid][i]) || std::isnan(b[vid][i])){
+				maxError = std::isnan(a[vid][i]) == std::isnan(b[vid][i]) ? maxError : std::numeric_limits<float>::infinity();
+				continue;
+			}
+			const float scale = std::max(1.0f, std::abs(a[vid][i]));
+			maxError = std::max(maxError, std::abs(a[vid][i] - b[vid][i]) / scale);
+		}
+	}
+	return maxError;
+}
+
+int benchmarkTangents(const std::vector<std::pair<std::string, std::string>> & files, const unsigned int iterations, const unsigned int threads){
+	
+	int errors = 0;
+	for(const auto & file : files){
+		const std::string & content = file.second;
+		Mesh mesh;
+		MeshUtilities::loadObj(content.data(), content.size(), mesh, MeshUtilities::Indexed, threads);
+		if(mesh.indices.empty() || mesh.texcoords.empty() || mesh.normals.empty()){
+			continue;
+		}
+		Mesh reference = mesh;
+		Mesh current = mesh;
+		Mesh parallel = mesh;
+		const double referenceTime = timeIt(iterations, [&](){ computeTangentsAndBinormalsReference(reference); });
+		const double currentTime = timeIt(iterations, [&](){ MeshUtilities::computeTangentsAndBinormals(current); });
+		const double parallelTime = timeIt(iterations, [&](){ MeshUtilities::computeTangentsAndBinormals(parallel, threads); });
+		
+		// Accumulation order differs between threads, allow for rounding differences.
+		const float tolerance = 1e-4f;
+		const float currentError = std::max(maxDifference(reference.tangents, current.tangents), maxDifference(reference.binormals, current.binormals));
+		const float parallelError = std::max(maxDifference(reference.tangents, parallel.tangents), maxDifference(reference.binormals, parallel.binormals));
+		const bool identical = currentError <= tolerance && parallelError <= tolerance;
+		errors += identical ? 0 : 1;
+		std::stringstream line;
+		line << file.first << " (tangents, " << (mesh.indices.size() / 3) << " triangles): " << referenceTime << "ms -> " << currentTime << "ms, x" << (referenceTime / std::max(currentTime, 1e-6));
+		if(threads > 1){
+			line << ", " << threads << " threads: " << parallelTime << "ms, x" << (referenceTime / std::max(parallelTime, 1e-6));
+		}
+		line << ". Max error: " << std::max(currentError, parallelError) << (identical ? "" : " MISMATCH");
+		Log::Info() << Log::Utilities << line.str() << std::endl;
+	}
+	return errors == 0 ? 0 : 2;
+}
+
+int benchmarkLods(const std::vector<std::pair<std::string, std::string>> & files, const unsigned int iterations){
+	
+	int errors = 0;
+	for(const auto & file : files){
+		const std::string & content = file.second;
+		Mesh mesh;
+		MeshUtilities::loadObj(content.data(), content.size(), mesh, MeshUtilities::Indexed);
+		if(mesh.indices.empty()){
+			continue;
+		}
+		MeshUtilities::optimize(mesh);
+		const double lodTime = timeIt(iterations, [&](){ MeshUtilities::generateLods(mesh); });
+		
+		// Check that the levels are valid triangle lists, with decreasing triangle counts.
+		bool valid = true;
+		size_t offset = 0;
+		size_t previousCount = mesh.indices.size();
+		std::stringstream line;
+		line << file.first << " (lods, " << lodTime << "ms): " << (mesh.indices.size() / 3);
+		for(const MeshLod & lod : mesh.lods){
+			valid = valid && lod.count % 3 == 0 && lod.count < previousCount && offset + lod.count <= mesh.lodIndices.size();
+			for(size_t iid = offset; valid && iid < offset + lod.count; iid += 3){
+				const unsigned int i0 = mesh.lodIndices[iid], i1 = mesh.lodIndices[iid+1], i2 = mesh.lodIndices[iid+2];
+				valid = i0 < mesh.positions.size() && i1 < mesh.positions.size() && i2 < mesh.positions.size() && i0 != i1 && i1 != i2 && i2 != i0;
+			}
+			line << " -> " << (lod.count / 3) << " (error " << lod.error << ")";
+			offset += lod.count;
+			previousCount = lod.count;
+		}
+		valid = valid && offset == mesh.lodIndices.size();
+		errors += valid ? 0 : 1;
+		float radius = 0.0f;
+		glm::vec3 center;
+		MeshUtilities::computeBoundingSphere(mesh.positions, center, radius);
+		line << " triangles, radius " << radius << (valid ? "" : " INVALID");
+		Log::Info() << Log::Utilities << line.str() << "." << std::endl;
+	}
+	return errors == 0 ? 0 : 2;
+}
+
+/// Load all OBJ files at a given path (a single file or a directory).
+std::vector<std::pair<std::string, std::string>> loadObjFiles(const std::string & rootPath){
+	std::vector<std::string> paths;
+	if(rootPath.size() > 4 && rootPath.substr(rootPath.size()-4) == ".obj"){
+		paths.push_back(rootPath);
+	} else {
+		std::vector<std::string> allPaths;
+		Resources::listFiles(rootPath, allPaths);
+		for(const auto & path : allPaths){
+			if(path.size() > 4 && path.substr(path.size()-4) == ".obj"){
+				paths.push_back(path);
+			}
+		}
+	}
+	
+	std::vector<std::pair<std::string, std::string>> files;
+	for(const auto & path : paths){
+		size_t rawSize = 0;
+		char * rawContent = Resources::loadRawDataFromExternalFile(path, rawSize);
+		if(rawContent == NULL){
+			continue;
+		}
+		files.emplace_back(path.substr(path.find_last_of("/\\") + 1), std::string(rawContent, rawSize));
+		free(rawContent);
+	}
+	return files;
+}
+
+/// Decode all images of a directory (for instance the faces and levels of a cubemap) serially and concurrently.
+int benchmarkImages(const std::string & directoryPath, const unsigned int iterations, const unsigned int threads){
+	std::vector<std::string> allPaths;
+	Resources::listFiles(directoryPath, allPaths);
+	std::vector<std::string> paths;
+	const std::vector<std::string> extensions = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".exr" };
+	for(const auto & path : allPaths){
+		const std::string extension = path.substr(std::min(path.find_last_of('.'), path.size()));
+		if(std::find(extensions.begin(), extensions.end(), extension) != extensions.end()){
+			paths.push_back(path);
+		}
+	}
+	if(paths.empty()){
+		Log::Error() << Log::Utilities << "No image found at path " << directoryPath << "." << std::endl;
+		return 1;
+	}
+	
+	std::vector<ImageView> serialImages;
+	std::vector<void *> serialBuffers;
+	std::vector<ImageView> parallelImages;
+	std::vector<void *> parallelBuffers;
+	const auto freeBuffers = [](std::vector<void *> & buffers){
+		for(void * buffer : buffers){
+			free(buffer);
+		}
+		buffers.clear();
+	};
+	bool success = true;
+	const double serialTime = timeIt(iterations, [&](){
+		freeBuffers(serialBuffers);
+		success = ImageUtilities::loadImages(paths, false, 1, serialImages, serialBuffers, true) && success;
+	});
+	const double parallelTime = timeIt(iterations, [&](){
+		freeBuffers(parallelBuffers);
+		success = ImageUtilities::loadImages(paths, false, threads, parallelImages, parallelBuffers, true) && success;
+	});
+	
+	// Both versions should decode the exact same pixels.
+	bool identical = success;
+	for(size_t iid = 0; iid < paths.size() && identical; ++iid){
+		const ImageView & a = serialImages[iid];
+		const ImageView & b = parallelImages[iid];
+		identical = a.width == b.width && a.height == b.height && a.channels == b.channels && a.half == b.half
+			&& std::memcmp(a.levels[0], b.levels[0], a.levelSize(0)) == 0;
+	}
+	freeBuffers(serialBuffers);
+	freeBuffers(parallelBuffers);
+	
+	Log::Info() << Log::Utilities << paths.size() << " images, serial: " << serialTime << "ms, " << threads << " threads: " << parallelTime << "ms (x" << (serialTime / std::max(parallelTime, 1e-6)) << ")." << std::endl;
+	if(!identical){
+		Log::Error() << Log::Utilities << "Concurrent decoding differs from the serial one." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/// Reference implementation: the previous lookup, probing each extension, face and level in an ordered map.
+
+std::string getImagePathReference(std::map<std::string, std::string> & files, const std::string & name){
+	std::string path = "";
+	if(files.count(name + ".png") > 0){
+		path = files[name + ".png"];
+	} else if(files.count(name + ".jpg") > 0){
+		path = files[name + ".jpg"];
+	} else if(files.count(name + ".jpeg") > 0){
+		path = files[name + ".jpeg"];
+	} else if(files.count(name + ".bmp") > 0){
+		path = files[name + ".bmp"];
+	} else if(files.count(name + ".tga") > 0){
+		path = files[name + ".tga"];
+	} else if(files.count(name + ".exr") > 0){
+		path = files[name + ".exr"];
+	}
+	return path;
+}
+
+std::vector<std::string> getCubemapPathsReference(std::map<std::string, std::string> & files, const std::string & name){
+	const std::vector<std::string> names { name + "_px", name + "_nx", name + "_py", name + "_ny", name + "_pz", name + "_nz" };
+	std::vector<std::string> paths;
+	for(auto & faceName : names){
+		const std::string filePath = getImagePathReference(files, faceName);
+		if(filePath.empty()){
+			return std::vector<std::string>();
+		}
+		paths.push_back(filePath);
+	}
+	return paths;
+}
+
+/// Resolve the files of a texture or a cubemap, as the texture loading does.
+std::vector<std::vector<std::string>> findTextureReference(std::map<std::string, std::string> & files, const std::string & name, const bool cubemap){
+	std::vector<std::vector<std::string>> paths;
+	if(cubemap){
+		const std::vector<std::string> faces = getCubemapPathsReference(files, name);
+		if(!faces.empty()){
+			return { faces };
+		}
+		std::vector<std::string> levelFaces = getCubemapPathsReference(files, name + "_0");
+		while(!levelFaces.empty()){
+			paths.push_back(levelFaces);
+			levelFaces = getCubemapPathsReference(files, name + "_" + std::to_string(paths.size()));
+		}
+		return paths;
+	}
+	const std::string path = getImagePathReference(files, name);
+	if(!path.empty()){
+		return { { path } };
+	}
+	std::string levelPath = getImagePathReference(files, name + "_0");
+	while(!levelPath.empty()){
+		paths.push_back({ levelPath });
+		levelPath = getImagePathReference(files, name + "_" + std::to_string(paths.size()));
+	}
+	return paths;
+}
+
+std::vector<std::vector<std::string>> findTexture(const AssetIndex & index, const std::string & name, const bool cubemap){
+	std::vector<std::vector<std::string>> paths;
+	const AssetIndex::Image * image = index.image(name);
+	if(image == NULL){
+		return paths;
+	}
+	if(cubemap){
+		if(image->isCubemap()){
+			return { std::vector<std::string>(image->faces, image->faces + 6) };
+		}
+		for(size_t lid = 0; lid < image->levels.size() && image->levels[lid]->isCubemap(); ++lid){
+			paths.emplace_back(image->levels[lid]->faces, image->levels[lid]->faces + 6);
+		}
+		return paths;
+	}
+	if(!image->path.empty()){
+		return { { image->path } };
+	}
+	for(size_t lid = 0; lid < image->levels.size() && !image->levels[lid]->path.empty(); ++lid){
+		paths.push_back({ image->levels[lid]->path });
+	}
+	return paths;
+}
+
+/// Lookups of textures among a generated set of assets: plain textures, textures with custom mip levels,
+/// cubemaps and cubemaps with mip levels, along with meshes and shaders.
+int benchmarkIndex(const unsigned int assetsCount, const unsigned int iterations){
+	const std::vector<std::string> extensions = { ".png", ".jpg", ".exr" };
+	const std::vector<std::string> faces = { "_px", "_nx", "_py", "_ny", "_pz", "_nz" };
+	std::vector<std::pair<std::string, std::string>> files;
+	std::vector<std::pair<std::string, bool>> textures;
+	for(unsigned int aid = 0; aid < assetsCount; ++aid){
+		const std::string name = "asset" + std::to_string(aid);
+		const std::string & extension = extensions[aid % extensions.size()];
+		switch(aid % 4){
+			case 0:
+				files.emplace_back(name + extension, "");
+				files.emplace_back(name + ".obj", "");
+				textures.emplace_back(name, false);
+				break;
+			case 1:
+				for(unsigned int lid = 0; lid < 4; ++lid){
+					files.emplace_back(name + "_" + std::to_string(lid) + extension, "");
+				}
+				textures.emplace_back(name, false);
+				break;
+			case 2:
+				for(const auto & face : faces){
+					files.emplace_back(name + face + extension, "");
+				}
+				textures.emplace_back(name, true);
+				break;
+			default:
+				for(unsigned int lid = 0; lid < 4; ++lid){
+					for(const auto & face : faces){
+						files.emplace_back(name + "_" + std::to_string(lid) + face + extension, "");
+					}
+				}
+				files.emplace_back(name + ".frag", "");
+				textures.emplace_back(name, true);
+				break;
+		}
+		// Missing textures are looked up too.
+		textures.emplace_back(name + "_missing", aid % 2 == 0);
+	}
+
+	std::map<std::string, std::string> referenceFiles;
+	AssetIndex index;
+	for(auto & file : files){
+		file.second = "resources/" + file.first;
+		referenceFiles[file.first] = file.second;
+		index.add(file.first, file.second);
+	}
+	const double indexTime = timeIt(1, [&](){ index.finalize(); });
+
+	size_t referenceCount = 0;
+	size_t currentCount = 0;
+	const double referenceTime = timeIt(iterations, [&](){
+		for(const auto & texture : textures){
+			referenceCount += findTextureReference(referenceFiles, texture.first, texture.second).size();
+		}
+	});
+	const double currentTime = timeIt(iterations, [&](){
+		for(const auto & texture : textures){
+			currentCount += findTexture(index, texture.first, texture.second).size();
+		}
+	});
+
+	bool identical = referenceCount == currentCount;
+	for(size_t tid = 0; tid < textures.size() && identical; ++tid){
+		identical = findTextureReference(referenceFiles, textures[tid].first, textures[tid].second) == findTexture(index, textures[tid].first, textures[tid].second);
+	}
+	Log::Info() << Log::Utilities << files.size() << " files, " << textures.size() << " lookups. Index built in " << indexTime << "ms. ";
+	Log::Info() << "Map probing: " << referenceTime << "ms, hash index: " << currentTime << "ms (x" << (referenceTime / std::max(currentTime, 1e-6)) << ")." << std::endl;
+	if(!identical){
+		Log::Error() << Log::Utilities << "Index lookups differ from the reference." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/// Reference implementations: the previous per-pixel loops of the image loaders, kept for comparison.
+
+void interleaveReference(const float * const * planes, const unsigned int width, const unsigned int height, const bool flip, float * dst){
+	for(unsigned int y = 0; y < height; ++y){
+		for(unsigned int x = 0; x < width; ++x){
+			const size_t destIndex = size_t(y) * width + x;
+			const size_t sourceIndex = flip ? (size_t(height - 1 - y) * width + x) : destIndex;
+			dst[3 * destIndex + 0] = planes[0][sourceIndex];
+			dst[3 * destIndex + 1] = planes[1][sourceIndex];
+			dst[3 * destIndex + 2] = planes[2][sourceIndex];
+		}
+	}
+}
+
+void deinterleaveReference(const float * src, const unsigned int width, const unsigned int height, const unsigned int channels, const bool flip, float * const * planes){
+	for(unsigned int y = 0; y < height; ++y){
+		for(unsigned int x = 0; x < width; ++x){
+			const size_t destIndex = size_t(y) * width + x;
+			const size_t sourceIndex = flip ? (size_t(height - 1 - y) * width + x) : destIndex;
+			for(unsigned int j = 0; j < channels; ++j){
+				planes[j][destIndex] = src[channels * sourceIndex + j];
+			}
+		}
+	}
+}
+
+/// Pixel layout kernels on a size x size image, against the scalar loops they replace.
+int benchmarkKernels(const unsigned int size, const unsigned int iterations){
+	const size_t count = size_t(size) * size;
+	std::vector<float> planesData[4];
+	for(unsigned int c = 0; c < 4; ++c){
+		planesData[c].resize(count);
+		for(size_t i = 0; i < count; ++i){
+			planesData[c][i] = float((i * 7 + c * 13) % 1021) * 0.25f;
+		}
+	}
+	const float * planes[3] = { &planesData[0][0], &planesData[1][0], &planesData[2][0] };
+	std::vector<uint16_t> halfPlanes[3];
+	for(unsigned int c = 0; c < 3; ++c){
+		halfPlanes[c].resize(count);
+		for(size_t i = 0; i < count; ++i){
+			halfPlanes[c][i] = glm::packHalf1x16(planesData[c][i]);
+		}
+	}
+	bool identical = true;
+	const auto report = [](const std::string & name, const double referenceTime, const double currentTime){
+		Log::Info() << Log::Utilities << name << ": scalar loop " << referenceTime << "ms, kernel " << currentTime << "ms (x" << (referenceTime / std::max(currentTime, 1e-6)) << ")." << std::endl;
+	};
+
+	// Planar to interleaved RGB, flipped, as when decoding EXR images.
+	{
+		std::vector<float> reference(3 * count);
+		std::vector<float> current(3 * count);
+		const double referenceTime = timeIt(iterations, [&](){
+			interleaveReference(planes, size, size, true, &reference[0]);
+		});
+		const double currentTime = timeIt(iterations, [&](){
+			for(unsigned int y = 0; y < size; ++y){
+				const size_t sourceRow = size_t(size - 1 - y) * size;
+				PixelKernels::interleaveRGB(planes[0] + sourceRow, planes[1] + sourceRow, planes[2] + sourceRow, &current[3 * size_t(y) * size], size);
+			}
+		});
+		identical = identical && reference == current;
+		report("Interleave RGB32F", referenceTime, currentTime);
+	}
+	{
+		std::vector<uint16_t> reference(3 * count);
+		std::vector<uint16_t> current(3 * count);
+		const double referenceTime = timeIt(iterations, [&](){
+			for(size_t i = 0; i < count; ++i){
+				reference[3 * i + 0] = halfPlanes[0][i];
+				reference[3 * i + 1] = halfPlanes[1][i];
+				reference[3 * i + 2] = halfPlanes[2][i];
+			}
+		});
+		const double currentTime = timeIt(iterations, [&](){
+			PixelKernels::interleaveRGB(&halfPlanes[0][0], &halfPlanes[1][0], &halfPlanes[2][0], &current[0], count);
+		});
+		identical = identical && reference == current;
+		report("Interleave RGB16F", referenceTime, currentTime);
+	}
+
+	// Interleaved to planar, flipped, as when saving EXR images.
+	for(unsigned int channels = 3; channels <= 4; ++channels){
+		std::vector<float> pixels(channels * count);
+		for(size_t i = 0; i < pixels.size(); ++i){
+			pixels[i] = float(i % 4093);
+		}
+		std::vector<float> reference[4];
+		std::vector<float> current[4];
+		float * referencePlanes[4];
+		float * currentPlanes[4];
+		for(unsigned int c = 0; c < 4; ++c){
+			reference[c].resize(count);
+			current[c].resize(count);
+			referencePlanes[c] = &reference[c][0];
+			currentPlanes[c] = &current[c][0];
+		}
+		const double referenceTime = timeIt(iterations, [&](){
+			deinterleaveReference(&pixels[0], size, size, channels, true, referencePlanes);
+		});
+		const double currentTime = timeIt(iterations, [&](){
+			for(unsigned int y = 0; y < size; ++y){
+				const size_t destIndex = size_t(y) * size;
+				const float * source = &pixels[channels * size_t(size - 1 - y) * size];
+				if(channels == 3){
+					PixelKernels::deinterleaveRGB(source, currentPlanes[0] + destIndex, currentPlanes[1] + destIndex, currentPlanes[2] + destIndex, size);
+				} else {
+					PixelKernels::deinterleaveRGBA(source, currentPlanes[0] + destIndex, currentPlanes[1] + destIndex, currentPlanes[2] + destIndex, currentPlanes[3] + destIndex, size);
+				}
+			}
+		});
+		for(unsigned int c = 0; c < channels; ++c){
+			identical = identical && reference[c] == current[c];
+		}
+		report(channels == 3 ? "Deinterleave RGB32F" : "Deinterleave RGBA32F", referenceTime, currentTime);
+	}
+
+	// Opaque alpha and vertical flip of RGBA8 images, as when saving and decoding LDR images.
+	{
+		std::vector<unsigned char> pixels(4 * count);
+		for(size_t i = 0; i < pixels.size(); ++i){
+			pixels[i] = (unsigned char)((i * 31) & 0xFF);
+		}
+		std::vector<unsigned char> reference(4 * count);
+		std::vector<unsigned char> current(4 * count);
+		const double referenceTime = timeIt(iterations, [&](){
+			for(size_t i = 0; i < count; ++i){
+				reference[4 * i + 0] = pixels[4 * i + 0];
+				reference[4 * i + 1] = pixels[4 * i + 1];
+				reference[4 * i + 2] = pixels[4 * i + 2];
+				reference[4 * i + 3] = 255;
+			}
+		});
+		const double currentTime = timeIt(iterations, [&](){
+			PixelKernels::copyOpaqueRGBA(&pixels[0], &current[0], count);
+		});
+		identical = identical && reference == current;
+		report("Opaque RGBA8", referenceTime, currentTime);
+
+		const size_t rowSize = 4 * size_t(size);
+		std::vector<unsigned char> row(rowSize);
+		const double referenceFlipTime = timeIt(iterations, [&](){
+			for(unsigned int y = 0; y < size / 2; ++y){
+				unsigned char * top = &reference[y * rowSize];
+				unsigned char * bottom = &reference[(size - 1 - y) * rowSize];
+				std::memcpy(&row[0], top, rowSize);
+				std::memcpy(top, bottom, rowSize);
+				std::memcpy(bottom, &row[0], rowSize);
+			}
+		});
+		const double currentFlipTime = timeIt(iterations, [&](){
+			PixelKernels::flipRows(&current[0], rowSize, size);
+		});
+		identical = identical && reference == current;
+		report("Flip RGBA8", referenceFlipTime, currentFlipTime);
+	}
+
+	Log::Info() << Log::Utilities << size << "x" << size << " pixels, " << PixelKernels::instructionSet() << " kernels." << std::endl;
+	if(!identical){
+		Log::Error() << Log::Utilities << "Kernels results differ from the scalar loops." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/// Mip chain generation of a size x size image with each filter, the sRGB box filter checked against a direct conversion.
+int benchmarkMipmaps(const unsigned int size, const unsigned int iterations){
+	const size_t count = size_t(size) * size;
+	std::vector<unsigned char> pixels(4 * count);
+	std::vector<uint16_t> halfPixels(3 * count);
+	for(size_t i = 0; i < count; ++i){
+		const unsigned int x = (unsigned int)(i % size);
+		const unsigned int y = (unsigned int)(i / size);
+		// Fine stripes, that averaging in sRGB space darkens.
+		pixels[4 * i + 0] = ((x / 2 + y / 3) % 2) ? 255 : 0;
+		pixels[4 * i + 1] = (unsigned char)((x * 7 + y * 3) & 0xFF);
+		pixels[4 * i + 2] = (unsigned char)((x ^ y) & 0xFF);
+		pixels[4 * i + 3] = (unsigned char)(y & 0xFF);
+		for(unsigned int c = 0; c < 3; ++c){
+			halfPixels[3 * i + c] = glm::packHalf1x16(float((x * (c + 1) + y) % 257) * 0.125f);
+		}
+	}
+	struct Setup {
+		std::string name;
+		bool hdr;
+		bool srgb;
+		ImageUtilities::MipFilter filter;
+	};
+	const std::vector<Setup> setups = {
+		{ "RGBA8 box", false, false, ImageUtilities::BoxFilter },
+		{ "RGBA8 sRGB box", false, true, ImageUtilities::BoxFilter },
+		{ "RGBA8 sRGB Kaiser", false, true, ImageUtilities::KaiserFilter },
+		{ "RGB16F box", true, false, ImageUtilities::BoxFilter },
+		{ "RGB16F Kaiser", true, false, ImageUtilities::KaiserFilter },
+	};
+	for(const Setup & setup : setups){
+		const double time = timeIt(iterations, [&](){
+			ImageView image;
+			image.width = size;
+			image.height = size;
+			image.channels = setup.hdr ? 3 : 4;
+			image.hdr = setup.hdr;
+			image.half = setup.hdr;
+			image.levels.push_back(setup.hdr ? (const void *)&halfPixels[0] : (const void *)&pixels[0]);
+			std::vector<void *> buffers;
+			ImageUtilities::generateMipmaps(image, setup.srgb, setup.filter, buffers);
+			for(void * buffer : buffers){
+				free(buffer);
+			}
+		});
+		Log::Info() << Log::Utilities << setup.name << ": " << time << "ms for the mip chain." << std::endl;
+	}
+
+	// Reference second level, converting each pixel with the sRGB formulas.
+	const unsigned int half = std::max(1u, size / 2);
+	std::vector<unsigned char> current(4 * size_t(half) * half);
+	ImageUtilities::downscaleImage(&pixels[0], size, size, 4, false, &current[0], false, true, ImageUtilities::BoxFilter);
+	const auto toLinear = [](const unsigned char value){
+		const double v = value / 255.0;
+		return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+	};
+	int maxError = 0;
+	for(unsigned int y = 0; y < half; ++y){
+		for(unsigned int x = 0; x < half; ++x){
+			for(unsigned int c = 0; c < 4; ++c){
+				double sum = 0.0;
+				for(unsigned int dy = 0; dy < 2; ++dy){
+					for(unsigned int dx = 0; dx < 2; ++dx){
+						const unsigned char value = pixels[4 * (std::min(2 * y + dy, size - 1) * size_t(size) + std::min(2 * x + dx, size - 1)) + c];
+						sum += c < 3 ? toLinear(value) : value / 255.0;
+					}
+				}
+				const double average = 0.25 * sum;
+				const double encoded = c < 3 ? (average <= 0.0031308 ? 12.92 * average : 1.055 * std::pow(average, 1.0 / 2.4) - 0.055) : average;
+				const int expected = int(std::floor(encoded * 255.0 + 0.5));
+				maxError = std::max(maxError, std::abs(expected - int(current[4 * (size_t(y) * half + x) + c])));
+			}
+		}
+	}
+	Log::Info() << Log::Utilities << size << "x" << size << " pixels, sRGB box filter max error " << maxError << "." << std::endl;
+	if(maxError > 1){
+		Log::Error() << Log::Utilities << "sRGB mipmaps differ from the reference conversion." << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/// Block compression of an image in each applicable format, on one thread and on several, with the error of the decoded blocks.
+int benchmarkCompression(const std::string & path, const unsigned int iterations, const unsigned int threads){
+	std::vector<ImageView> images;
+	std::vector<void *> buffers;
+	if(!ImageUtilities::loadImages({ path }, false, 1, images, buffers, true)){
+		return 1;
+	}
+	const ImageView & image = images[0];
+	const size_t count = size_t(image.width) * image.height;
+	std::vector<BlockCompression::Format> formats = { BlockCompression::BC6H };
+	if(!image.hdr){
+		formats = { BlockCompression::BC1, BlockCompression::BC3, BlockCompression::BC4, BlockCompression::BC5, BlockCompression::BC7 };
+	}
+	Log::Info() << Log::Utilities << image.width << "x" << image.height << " pixels, " << PixelKernels::instructionSet() << "." << std::endl;
+	int result = 0;
+	for(const BlockCompression::Format format : formats){
+		std::vector<unsigned char> single(BlockCompression::imageSize(format, image.width, image.height));
+		std::vector<unsigned char> threaded(single.size());
+		const double singleTime = timeIt(iterations, [&](){
+			BlockCompression::encode(image, 0, format, 1, &single[0]);
+		});
+		const double threadedTime = timeIt(iterations, [&](){
+			BlockCompression::encode(image, 0, format, threads, &threaded[0]);
+		});
+		if(single != threaded){
+			Log::Error() << Log::Utilities << BlockCompression::name(format) << " blocks depend on the number of threads." << std::endl;
+			result = 1;
+		}
+
+		// Compare the channels stored by the format.
+		std::stringstream quality;
+		if(format == BlockCompression::BC6H){
+			std::vector<uint16_t> decoded(3 * count);
+			BlockCompression::decode(&single[0], format, image.width, image.height, &decoded[0]);
+			double error = 0.0;
+			double energy = 0.0;
+			for(size_t i = 0; i < 3 * count; ++i){
+				const float reference = image.half ? glm::unpackHalf1x16(((const uint16_t *)image.levels[0])[i]) : ((const float *)image.levels[0])[i];
+				const double delta = double(glm::unpackHalf1x16(decoded[i])) - std::max(0.0f, reference);
+				error += delta * delta;
+				energy += double(reference) * reference;
+			}
+			const double relative = std::sqrt(error / std::max(energy, 1e-12));
+			quality << "relative RMS error " << relative;
+			if(relative > 0.1){
+				result = 1;
+			}
+		} else {
+			std::vector<unsigned char> decoded(4 * count);
+			BlockCompression::decode(&single[0], format, image.width, image.height, &decoded[0]);
+			const unsigned int channels = format == BlockCompression::BC4 ? 1 : (format == BlockCompression::BC5 ? 2 : (format == BlockCompression::BC1 ? 3 : 4));
+			const unsigned char * pixels = (const unsigned char *)image.levels[0];
+			double error = 0.0;
+			for(size_t i = 0; i < count; ++i){
+				for(unsigned int c = 0; c < channels; ++c){
+					const double delta = double(decoded[4 * i + c]) - double(pixels[4 * i + c]);
+					error += delta * delta;
+				}
+			}
+			const double mse = error / double(count * channels);
+			const double psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+			quality << "PSNR " << psnr << "dB over " << channels << " channels";
+			if(psnr < 25.0){
+				result = 1;
+			}
+		}
+		Log::Info() << Log::Utilities << BlockCompression::name(format) << ": " << singleTime << "ms, " << threadedTime << "ms on " << threads << " threads, " << quality.str() << "." << std::endl;
+	}
+	for(void * buffer : buffers){
+		free(buffer);
+	}
+	if(result != 0){
+		Log::Error() << Log::Utilities << "Compressed blocks are invalid or too far from the image." << std::endl;
+	}
+	return result;
+}
+
+/// The main function
+
+int main(int argc, char** argv) {
+
+	// Arguments parsing.
+	std::map<std::string, std::string> arguments;
+	Config::parseFromArgs(argc, argv, arguments);
+
+	const unsigned int iterations = arguments.count("iterations") > 0 ? (unsigned int)std::max(1, std::stoi(arguments["iterations"])) : 5;
+	const unsigned int threads = arguments.count("threads") > 0 ? (unsigned int)std::max(1, std::stoi(arguments["threads"])) : 1;
+
+	// Meshes for the OBJ benchmarks, either from disk or generated.
+	std::vector<std::pair<std::string, std::string>> objFiles;
+	if(arguments.count("obj") > 0){
+		objFiles = loadObjFiles(arguments["obj"]);
+		if(objFiles.empty()){
+			Log::Error() << Log::Utilities << "No OBJ file found at path " << arguments["obj"] << "." << std::endl;
+			return 1;
+		}
+	} else if(arguments.count("grid") > 0){
+		const unsigned int gridSize = (unsigned int)std::max(1, std::stoi(arguments["grid"]));
+		objFiles.emplace_back("grid_" + std::to_string(gridSize), generateGridObj(gridSize));
+	}
+	
+	if(!objFiles.empty() && arguments.count("optimize") > 0){
+		return benchmarkOptimization(objFiles);
+	}
+	if(!objFiles.empty() && arguments.count("lods") > 0){
+		return benchmarkLods(objFiles, iterations);
+	}
+	if(!objFiles.empty() && arguments.count("tangents") > 0){
+		return benchmarkTangents(objFiles, iterations, threads);
+	}
+	if(!objFiles.empty() && arguments.count("packed") > 0){
+		return benchmarkPacking(objFiles, iterations);
+	}
+	if(!objFiles.empty() && arguments.count("cache") > 0){
+		return benchmarkMeshCache(objFiles, iterations, arguments["cache"]);
+	}
+	if(!objFiles.empty()){
+		return benchmarkObj(objFiles, iterations, threads);
+	}
+	if(arguments.count("index") > 0){
+		return benchmarkIndex((unsigned int)std::max(1, std::stoi(arguments["index"])), iterations);
+	}
+	if(arguments.count("images") > 0){
+		return benchmarkImages(arguments["images"], iterations, threads);
+	}
+	if(arguments.count("mipmaps") > 0){
+		const std::string & size = arguments["mipmaps"];
+		return benchmarkMipmaps(size.empty() || size == "true" ? 2048 : (unsigned int)std::max(1, std::stoi(size)), iterations);
+	}
+	if(arguments.count("compression") > 0){
+		return benchmarkCompression(arguments["compression"], iterations, threads);
+	}
+	if(arguments.count("kernels") > 0){
+		const std::string & size = arguments["kernels"];
+		return benchmarkKernels(size.empty() || size == "true" ? 4096 : (unsigned int)std::max(1, std::stoi(size)), iterations);
+	}
+	
+	Log::Error() << Log::Utilities << "Specify a benchmark: --obj <file or directory> or --grid <size>, [--iterations N] [--threads N] [--cache <directory>] [--packed] [--optimize] [--tangents] [--lods], --images <directory>, --kernels [image size, 4096 by default], --mipmaps [image size, 2048 by default], --compression <image> [--threads N], or --index <assets count>." << std::endl;
+	return 3;
+}
+
+